@@ -27,6 +27,7 @@
 #include "OperationResult.h"
 #include "Undocumented.h"
 #include "WindowsVersion.h"
+#include "Profiler.h"
 #include <D3D11.h>
 #include <DComp.h>
 #include <wrl\client.h>
@@ -54,10 +55,7 @@ private:
     [[nodiscard]] bool Flush() noexcept;
     [[nodiscard]] bool Commit() noexcept;
 
-    void OnXChanged(const int arg) noexcept;
-    void OnYChanged(const int arg) noexcept;
-    void OnWidthChanged(const UINT arg) noexcept;
-    void OnHeightChanged(const UINT arg) noexcept;
+    void OnGeometryChanged(const WindowGeometry &arg) noexcept;
     void OnActiveChanged(const bool arg) noexcept;
 
 private:
@@ -107,18 +105,16 @@ private:
 MainWindowPrivate::MainWindowPrivate(MainWindow *q) noexcept
 {
     if (!q) {
-        Utils::DisplayErrorDialog(L"MainWindowPrivate's q is null.");
+        Utils::DisplayErrorDialog(L"MainWindowPrivate's q is null.", ErrorSeverity::Fatal);
         std::exit(-1);
     }
     q_ptr = q;
     if (Initialize()) {
-        q_ptr->XChangeHandler(std::bind(&MainWindowPrivate::OnXChanged, this, std::placeholders::_1));
-        q_ptr->YChangeHandler(std::bind(&MainWindowPrivate::OnYChanged, this, std::placeholders::_1));
-        q_ptr->WidthChangeHandler(std::bind(&MainWindowPrivate::OnWidthChanged, this, std::placeholders::_1));
-        q_ptr->HeightChangeHandler(std::bind(&MainWindowPrivate::OnHeightChanged, this, std::placeholders::_1));
+        // One composition commit per frame, no matter how many of the coordinates changed.
+        q_ptr->GeometryChangeHandler(std::bind(&MainWindowPrivate::OnGeometryChanged, this, std::placeholders::_1));
         q_ptr->ActiveChangeHandler(std::bind(&MainWindowPrivate::OnActiveChanged, this, std::placeholders::_1));
     } else {
-        Utils::DisplayErrorDialog(L"Failed to initialize MainWindowPrivate.");
+        Utils::DisplayErrorDialog(L"Failed to initialize MainWindowPrivate.", ErrorSeverity::Fatal);
         std::exit(-1);
     }
 }
@@ -228,31 +224,7 @@ bool MainWindowPrivate::Initialize() noexcept
     return true;
 }
 
-void MainWindowPrivate::OnXChanged(const int arg) noexcept
-{
-    UNREFERENCED_PARAMETER(arg);
-    if (!SyncCoordinates()) {
-        Utils::DisplayErrorDialog(L"Failed to sync the geometry of the visuals.");
-    }
-}
-
-void MainWindowPrivate::OnYChanged(const int arg) noexcept
-{
-    UNREFERENCED_PARAMETER(arg);
-    if (!SyncCoordinates()) {
-        Utils::DisplayErrorDialog(L"Failed to sync the geometry of the visuals.");
-    }
-}
-
-void MainWindowPrivate::OnWidthChanged(const UINT arg) noexcept
-{
-    UNREFERENCED_PARAMETER(arg);
-    if (!SyncCoordinates()) {
-        Utils::DisplayErrorDialog(L"Failed to sync the geometry of the visuals.");
-    }
-}
-
-void MainWindowPrivate::OnHeightChanged(const UINT arg) noexcept
+void MainWindowPrivate::OnGeometryChanged(const WindowGeometry &arg) noexcept
 {
     UNREFERENCED_PARAMETER(arg);
     if (!SyncCoordinates()) {
@@ -270,6 +242,7 @@ void MainWindowPrivate::OnActiveChanged(const bool arg) noexcept
 
 bool MainWindowPrivate::CreateCompositionDevice() noexcept
 {
+    PROFILE_SCOPE(L"MainWindowPrivate::CreateCompositionDevice")
     // This array defines the set of DirectX hardware feature levels this app supports.
     // The ordering is important and you should preserve it.
     // Don't forget to declare your app's minimum required feature level in its
@@ -0,0 +1,58 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+// What the check programs share: a failed "CHECK()" prints the condition and its
+// line, and "Check::Finish()" gives the exit code of the program.
+
+#include <cstdio>
+
+namespace Check
+{
+    inline int Failures = 0;
+
+    inline void Expect(const bool condition, const char *expression, const char *file, const int line) noexcept
+    {
+        if (condition) {
+            return;
+        }
+        ++Failures;
+        std::fprintf(stderr, "%s(%d): check failed: %s\n", file, line, expression);
+    }
+
+    [[nodiscard]] inline int Finish(const char *name) noexcept
+    {
+        if (Failures != 0) {
+            std::fprintf(stderr, "%s: %d check(s) failed.\n", name, Failures);
+            return 1;
+        }
+        std::printf("%s: all checks passed.\n", name);
+        return 0;
+    }
+} // namespace Check
+
+#ifndef CHECK
+#define CHECK(condition) Check::Expect(static_cast<bool>(condition), #condition, __FILE__, __LINE__)
+#endif // CHECK
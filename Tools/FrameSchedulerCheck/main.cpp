@@ -0,0 +1,136 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// Checks the frame scheduler ("FrameScheduler.h") against a "FakeFrameClock": the
+// phase of the next vertical blank, the blending and the reset of the period, and
+// how often the compositor is asked.
+//
+// Usage: FrameSchedulerCheck
+
+#include "FrameScheduler.h"
+#include "../Check.hpp"
+
+// Microseconds, at 60Hz.
+static constexpr const std::int64_t Frequency = 1000000;
+static constexpr const std::int64_t Period = 16667;
+static constexpr const std::int64_t ResampleTicks = ((FrameScheduler::ResampleInterval * Frequency) / 1000);
+
+static inline void CheckPhaseWrap() noexcept
+{
+    FakeFrameClock clock(Frequency, Period);
+    FrameScheduler scheduler(clock);
+    clock.Advance(1000000);
+    const std::int64_t now = clock.Now();
+
+    // The reported vertical blank lies many frames in the past.
+    clock.VBlank({(now - (3 * Period) - 5), Period});
+    CHECK(scheduler.NextVBlank(now) == (now + Period - 5));
+    scheduler.Invalidate();
+    // Many frames in the future.
+    clock.VBlank({(now + (5 * Period) + 7), Period});
+    CHECK(scheduler.NextVBlank(now) == (now + 7));
+    scheduler.Invalidate();
+    // Right now.
+    clock.VBlank({(now - (2 * Period)), Period});
+    CHECK(scheduler.NextVBlank(now) == now);
+    // The phase is kept between samples, only "now" moves.
+    CHECK(scheduler.NextVBlank(now + 1) == (now + Period));
+    CHECK(scheduler.NextVBlank(now + Period + 1) == (now + (2 * Period)));
+
+    // Waiting ends on the next vertical blank.
+    clock.Advance(10);
+    CHECK(scheduler.WaitForVBlank());
+    CHECK(clock.WaitCount() == 1);
+    CHECK(clock.Waited() == (Period - 10));
+    CHECK(clock.Now() == (now + Period));
+}
+
+static inline void CheckResampleInterval() noexcept
+{
+    FakeFrameClock clock(Frequency, Period);
+    FrameScheduler scheduler(clock);
+    CHECK(scheduler.NextVBlank(clock.Now()) >= 0);
+    CHECK(clock.QueryCount() == 1);
+    clock.Advance(ResampleTicks - 1);
+    CHECK(scheduler.NextVBlank(clock.Now()) >= 0);
+    CHECK(scheduler.Period() == Period);
+    CHECK(clock.QueryCount() == 1);
+    clock.Advance(1);
+    CHECK(scheduler.NextVBlank(clock.Now()) >= 0);
+    CHECK(clock.QueryCount() == 2);
+
+    // A compositor which can't answer is not asked again before the interval is over.
+    clock.Available(false);
+    clock.Advance(ResampleTicks);
+    CHECK(scheduler.NextVBlank(clock.Now()) == -1);
+    CHECK(scheduler.Period() == -1);
+    CHECK(!scheduler.WaitForVBlank());
+    CHECK(clock.WaitCount() == 0);
+    CHECK(clock.QueryCount() == 3);
+    clock.Available(true);
+    CHECK(scheduler.NextVBlank(clock.Now()) == -1);
+    CHECK(clock.QueryCount() == 3);
+    // Unless the phase is thrown away.
+    scheduler.Invalidate();
+    CHECK(scheduler.NextVBlank(clock.Now()) >= 0);
+    CHECK(clock.QueryCount() == 4);
+}
+
+static inline void CheckPeriodBlending() noexcept
+{
+    FakeFrameClock clock(Frequency, Period);
+    FrameScheduler scheduler(clock);
+    CHECK(scheduler.Period() == Period);
+
+    // A little jitter is smoothed out.
+    const std::int64_t jittered = (Period + 200);
+    clock.VBlank({0, jittered});
+    clock.Advance(ResampleTicks);
+    const std::int64_t blended = (((Period * 7) + jittered) / 8);
+    CHECK(scheduler.Period() == blended);
+
+    // A new display mode replaces the period right away.
+    const std::int64_t period120Hz = 8333;
+    clock.VBlank({0, period120Hz});
+    clock.Advance(ResampleTicks);
+    CHECK(scheduler.Period() == period120Hz);
+
+    // So does a new phase after "Invalidate()", even if the period is close.
+    scheduler.Invalidate();
+    clock.VBlank({0, (period120Hz + 100)});
+    CHECK(scheduler.Period() == (period120Hz + 100));
+
+    // A period of zero is not a vertical blank.
+    clock.VBlank({0, 0});
+    clock.Advance(ResampleTicks);
+    CHECK(scheduler.Period() == -1);
+}
+
+int main()
+{
+    CheckPhaseWrap();
+    CheckResampleInterval();
+    CheckPeriodBlending();
+    return Check::Finish("FrameSchedulerCheck");
+}
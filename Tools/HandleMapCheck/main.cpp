@@ -0,0 +1,217 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// Checks the handle map ("HandleMap.hpp") against "std::unordered_map": random
+// inserts, erases and lookups over a small pool of handles, and the erasure of every
+// entry of a cluster which collides on a few home slots and wraps around the end of
+// the table, in random orders. A wrong backward shift leaves entries unreachable.
+//
+// Usage: HandleMapCheck [operations] [seed]
+
+#include "HandleMap.hpp"
+#include "../Check.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+using Handle = void *;
+using Map = HandleMap<Handle, int>;
+using Reference = std::unordered_map<Handle, int *>;
+
+static constexpr const std::size_t PoolSize = 1024;
+// The capacity of a new table, see "HandleMap::InitialCapacity".
+static constexpr const std::size_t InitialCapacity = 16;
+
+static std::mt19937 g_random = {};
+static int g_values[PoolSize] = {};
+
+[[nodiscard]] static inline std::size_t Random(const std::size_t first, const std::size_t last) noexcept
+{
+    return std::uniform_int_distribution<std::size_t>(first, last)(g_random);
+}
+
+// Handles are multiples of 8, like the ones of the system.
+[[nodiscard]] static inline Handle MakeHandle(const std::size_t index) noexcept
+{
+    return reinterpret_cast<Handle>(static_cast<std::uintptr_t>(0x10000 + (index * 8)));
+}
+
+// The home slot of a handle, the same Fibonacci hashing as "HandleMap" uses.
+[[nodiscard]] static inline std::size_t HomeSlot(const Handle key, const std::size_t capacity) noexcept
+{
+    const auto value = static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(key));
+    return static_cast<std::size_t>((value * 0x9E3779B97F4A7C15ull) >> 32) & (capacity - 1);
+}
+
+// Returns false on the first handle where the map and the reference disagree.
+[[nodiscard]] static inline bool Agrees(const Map &map, const Reference &reference, const Handle key) noexcept
+{
+    const auto it = reference.find(key);
+    const int * const expected = ((it == reference.end()) ? nullptr : it->second);
+    if (map.Find(key) == expected) {
+        return true;
+    }
+    std::fprintf(stderr, "Mismatch at handle %p: expected %p, found %p.\n", key,
+                 static_cast<const void *>(expected), static_cast<const void *>(map.Find(key)));
+    return false;
+}
+
+[[nodiscard]] static inline bool AgreesEverywhere(const Map &map, const Reference &reference, const std::vector<Handle> &keys) noexcept
+{
+    if (map.Size() != reference.size()) {
+        std::fprintf(stderr, "Size mismatch: expected %zu, found %zu.\n", reference.size(), map.Size());
+        return false;
+    }
+    for (auto &&key : keys) {
+        if (!Agrees(map, reference, key)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+[[nodiscard]] static inline bool CheckRandomOperations(const int operations) noexcept
+{
+    std::vector<Handle> keys = {};
+    for (std::size_t i = 0; i != PoolSize; ++i) {
+        keys.push_back(MakeHandle(i));
+    }
+    Map map;
+    Reference reference = {};
+    for (int operation = 0; operation != operations; ++operation) {
+        const std::size_t index = Random(0, (PoolSize - 1));
+        const Handle key = keys[index];
+        switch (Random(0, 2)) {
+        case 0: {
+            // Alternate between two values, so that replacing is checked as well.
+            int * const value = &g_values[(index + Random(0, 1)) % PoolSize];
+            if (!map.Insert(key, value)) {
+                return false;
+            }
+            reference.insert_or_assign(key, value);
+        } break;
+        case 1: {
+            map.Erase(key);
+            reference.erase(key);
+        } break;
+        default:
+            break;
+        }
+        if (!Agrees(map, reference, key)) {
+            return false;
+        }
+        if ((operation % 1000) == 0) {
+            if (!AgreesEverywhere(map, reference, keys)) {
+                return false;
+            }
+        }
+    }
+    return AgreesEverywhere(map, reference, keys);
+}
+
+// A cluster from slot 13 to slot 7 of a new table: several handles share the home
+// slots 14, 15, 0 and 1, so the cluster wraps around the end of the table.
+[[nodiscard]] static inline std::vector<Handle> CollidingHandles() noexcept
+{
+    struct Home
+    {
+        std::size_t Slot = 0;
+        int Count = 0;
+    };
+    std::vector<Home> homes = { {13, 1}, {14, 4}, {15, 3}, {0, 2}, {1, 1} };
+    std::vector<Handle> keys = {};
+    for (std::size_t i = 0; std::any_of(homes.begin(), homes.end(), [](const Home &home){ return (home.Count > 0); }); ++i) {
+        const Handle key = MakeHandle(i);
+        for (auto &&home : homes) {
+            if ((home.Count > 0) && (HomeSlot(key, InitialCapacity) == home.Slot)) {
+                keys.push_back(key);
+                --home.Count;
+                break;
+            }
+        }
+    }
+    return keys;
+}
+
+[[nodiscard]] static inline bool CheckWrapAround(const int rounds) noexcept
+{
+    const std::vector<Handle> keys = CollidingHandles();
+    // Without growing, the table would be rehashed and the cluster gone.
+    CHECK(((keys.size() + 1) * 4) <= (InitialCapacity * 3));
+    for (int round = 0; round != rounds; ++round) {
+        std::vector<Handle> order = keys;
+        std::shuffle(order.begin(), order.end(), g_random);
+        Map map;
+        Reference reference = {};
+        for (std::size_t i = 0; i != order.size(); ++i) {
+            if (!map.Insert(order[i], &g_values[i])) {
+                return false;
+            }
+            reference.insert_or_assign(order[i], &g_values[i]);
+        }
+        if (!AgreesEverywhere(map, reference, keys)) {
+            return false;
+        }
+        std::shuffle(order.begin(), order.end(), g_random);
+        for (auto &&key : order) {
+            map.Erase(key);
+            reference.erase(key);
+            if (!AgreesEverywhere(map, reference, keys)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc > 3) {
+        std::fprintf(stderr, "Usage: %s [operations] [seed]\n", argv[0]);
+        return -1;
+    }
+    int operations = 200000;
+    if (argc >= 2) {
+        operations = std::atoi(argv[1]);
+        if (operations <= 0) {
+            std::fprintf(stderr, "Invalid operation count \"%s\".\n", argv[1]);
+            return -1;
+        }
+    }
+    // A fixed seed by default, a failure has to be reproducible.
+    const auto seed = static_cast<std::mt19937::result_type>((argc == 3) ? std::strtoul(argv[2], nullptr, 10) : 20211024);
+    g_random.seed(seed);
+
+    CHECK(CollidingHandles().size() == 11);
+    CHECK(CheckWrapAround(1000));
+    CHECK(CheckRandomOperations(operations));
+    // Null is reserved.
+    Map map;
+    CHECK(!map.Insert(nullptr, &g_values[0]));
+    CHECK(map.Find(nullptr) == nullptr);
+    std::printf("%d random operations, seed %u.\n", operations, static_cast<unsigned int>(seed));
+    return Check::Finish("HandleMapCheck");
+}
@@ -0,0 +1,132 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// Checks the hit-test map ("HitTestMap.hpp") against its reference implementation,
+// "HitTestMap::Classify()", on randomized geometries: every boundary of every
+// geometry is probed from both sides, plus random points in and around the window.
+//
+// Usage: HitTestMapCheck [geometries] [seed]
+
+#include "HitTestMap.hpp"
+#include "../Check.hpp"
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+static std::mt19937 g_random = {};
+
+[[nodiscard]] static inline int Random(const int first, const int last) noexcept
+{
+    return std::uniform_int_distribution<int>(first, last)(g_random);
+}
+
+[[nodiscard]] static inline HitTestGeometry RandomGeometry() noexcept
+{
+    HitTestGeometry geometry = {};
+    // Mostly ordinary windows, sometimes tiny ones where the borders overlap.
+    const bool tiny = (Random(0, 7) == 0);
+    geometry.Width = (tiny ? Random(0, 40) : Random(100, 4000));
+    geometry.Height = (tiny ? Random(0, 40) : Random(100, 3000));
+    geometry.ResizeBorderThicknessX = Random(0, 16);
+    geometry.ResizeBorderThicknessY = Random(0, 16);
+    geometry.TitleBarHeight = Random(0, 64);
+    geometry.HasTitleBar = (Random(0, 1) != 0);
+    geometry.ResizableTop = (Random(0, 1) != 0);
+    geometry.ResizableEdges = (Random(0, 1) != 0);
+    return geometry;
+}
+
+// Returns false on the first point where the map and the reference disagree.
+[[nodiscard]] static inline bool Agrees(const HitTestMap &map, const HitTestGeometry &geometry, const int x, const int y) noexcept
+{
+    if (map.Find(x, y) == HitTestMap::Classify(geometry, x, y)) {
+        return true;
+    }
+    std::fprintf(stderr, "Mismatch at (%d, %d): width %d, height %d, border %d x %d, title bar %d, flags %d%d%d.\n",
+                 x, y, geometry.Width, geometry.Height, geometry.ResizeBorderThicknessX, geometry.ResizeBorderThicknessY,
+                 geometry.TitleBarHeight, geometry.HasTitleBar, geometry.ResizableTop, geometry.ResizableEdges);
+    return false;
+}
+
+[[nodiscard]] static inline bool CheckGeometry(const HitTestGeometry &geometry) noexcept
+{
+    HitTestMap map;
+    map.Build(geometry);
+    // Everything the classification compares against, and both neighbours of it.
+    const int thicknessX = geometry.ResizeBorderThicknessX;
+    const int thicknessY = geometry.ResizeBorderThicknessY;
+    const std::vector<int> xs = { -100000, -1, 0, thicknessX, (2 * thicknessX), (geometry.Width - (2 * thicknessX)),
+                                  (geometry.Width - thicknessX), geometry.Width, 100000 };
+    const std::vector<int> ys = { -100000, -1, 0, thicknessY, geometry.TitleBarHeight, (geometry.Height - thicknessY),
+                                  geometry.Height, 100000 };
+    for (auto &&x : xs) {
+        for (auto &&y : ys) {
+            for (int dx = -1; dx <= 1; ++dx) {
+                for (int dy = -1; dy <= 1; ++dy) {
+                    if (!Agrees(map, geometry, (x + dx), (y + dy))) {
+                        return false;
+                    }
+                }
+            }
+        }
+    }
+    for (int i = 0; i != 64; ++i) {
+        if (!Agrees(map, geometry, Random(-20, (geometry.Width + 20)), Random(-20, (geometry.Height + 20)))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc > 3) {
+        std::fprintf(stderr, "Usage: %s [geometries] [seed]\n", argv[0]);
+        return -1;
+    }
+    int count = 10000;
+    if (argc >= 2) {
+        count = std::atoi(argv[1]);
+        if (count <= 0) {
+            std::fprintf(stderr, "Invalid geometry count \"%s\".\n", argv[1]);
+            return -1;
+        }
+    }
+    // A fixed seed by default, a failure has to be reproducible.
+    const auto seed = static_cast<std::mt19937::result_type>((argc == 3) ? std::strtoul(argv[2], nullptr, 10) : 20211024);
+    g_random.seed(seed);
+
+    // The geometries of the three window states first: windowed, maximized, fullscreen.
+    CHECK(CheckGeometry({800, 600, 8, 8, 31, true, true, true}));
+    CHECK(CheckGeometry({1920, 1040, 8, 8, 31, true, false, false}));
+    CHECK(CheckGeometry({1920, 1080, 8, 8, 31, false, false, false}));
+    for (int i = 0; i != count; ++i) {
+        if (!CheckGeometry(RandomGeometry())) {
+            CHECK(false && "the map and the reference disagree");
+            break;
+        }
+    }
+    std::printf("%d random geometries, seed %u.\n", count, static_cast<unsigned int>(seed));
+    return Check::Finish("HitTestMapCheck");
+}
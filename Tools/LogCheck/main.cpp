@@ -0,0 +1,237 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// Checks the binary log ("Log.h") end to end: records every kind of argument from a
+// few call sites and from several threads into a log file, reads the file back the
+// way "LogReader" does ("LogFormat.hpp") and compares the formatted text with what
+// was logged. The long strings make the thread buffers fill up and flush many times.
+//
+// Usage: LogCheck [file]
+//
+// The file is removed again when all checks have passed.
+
+#include "Log.h"
+#include "../Check.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+static constexpr const int ThreadCount = 4;
+static constexpr const int RecordsPerThread = 2000;
+static constexpr const int LongRecordCount = 200;
+
+struct DecodedRecord
+{
+    std::uint32_t Thread = 0;
+    std::uint8_t Level = 0;
+    std::string Function = {};
+    std::wstring Text = {};
+};
+
+// Index 0 is the main thread, the others are the threads started below.
+static std::vector<std::wstring> g_expected[ThreadCount + 1] = {};
+
+[[nodiscard]] static inline std::wstring DescribeErrorCode(const LogFormat::ErrorCode &code) noexcept
+{
+    return (std::to_wstring(code.Value) + L'/' + std::to_wstring(code.Domain));
+}
+
+[[nodiscard]] static inline std::wstring LongString(const int index, const std::size_t length) noexcept
+{
+    return std::wstring(length, static_cast<wchar_t>(L'a' + (index % 26)));
+}
+
+static inline void LogCallSites() noexcept
+{
+    LOG_INFO(L"[{}] int {}, unsigned {}, negative {}", 0, 42, 7u, -123456789012ll);
+    g_expected[0].push_back(L"[0] int 42, unsigned 7, negative -123456789012");
+    LOG_DEBUG(L"[{}] double {}, bool {} {}", 0, 1.5, true, false);
+    g_expected[0].push_back(L"[0] double 1.500000, bool true false");
+    LOG_WARNING(L"[{}] pointer {}, null {}, enum {}", 0, reinterpret_cast<const void *>(static_cast<std::uintptr_t>(0xABCD0)),
+                static_cast<const void *>(nullptr), LogLevel::Warning);
+    g_expected[0].push_back(L"[0] pointer 0xABCD0, null 0x0, enum 2");
+    const std::wstring string = L"std::wstring";
+    const wchar_t * const nullString = nullptr;
+    LOG_INFO(L"[{}] {}, {}, {}, \"{}\", {{literal}}", 0, string, std::wstring_view(L"view"), L"pointer", nullString);
+    g_expected[0].push_back(L"[0] std::wstring, view, pointer, \"\", {literal}");
+    LOG_INFO(L"[{}] non-ASCII: {}", 0, L"é中");
+    g_expected[0].push_back(L"[0] non-ASCII: é中");
+    LOG_ERROR(L"[{}] error {} {}", 0, LogFormat::ErrorCode{ 5, 0 }, LogFormat::ErrorCode{ 0x80004005u, 1 });
+    g_expected[0].push_back(L"[0] error 5/0 2147500037/1");
+    // Longer strings are truncated.
+    LOG_INFO(L"[{}] {}", 0, LongString(0, (LogFormat::MaximumStringLength * 4)));
+    g_expected[0].push_back(L"[0] " + LongString(0, LogFormat::MaximumStringLength));
+    // Not a single buffer holds all of them.
+    for (int index = 0; index != LongRecordCount; ++index) {
+        LOG_DEBUG(L"[{}] {} {}", 0, index, LongString(index, (LogFormat::MaximumStringLength - 1)));
+        g_expected[0].push_back(L"[0] " + std::to_wstring(index) + L' ' + LongString(index, (LogFormat::MaximumStringLength - 1)));
+    }
+}
+
+static inline void LogFromThread(const int thread) noexcept
+{
+    for (int index = 0; index != RecordsPerThread; ++index) {
+        const std::wstring text = LongString(index, static_cast<std::size_t>((index * 7) % 300));
+        LOG_DEBUG(L"[{}] record {} \"{}\"", thread, index, text);
+        g_expected[thread].push_back(L'[' + std::to_wstring(thread) + L"] record " + std::to_wstring(index) + L" \"" + text + L'"');
+    }
+    // The rest of the buffer is written when the thread exits.
+}
+
+[[nodiscard]] static inline bool ReadLog(const char *path, std::vector<DecodedRecord> &records) noexcept
+{
+    std::FILE *file = std::fopen(path, "rb");
+    if (!file) {
+        std::fprintf(stderr, "Failed to open \"%s\".\n", path);
+        return false;
+    }
+    std::vector<std::byte> content = {};
+    std::byte buffer[64 * 1024];
+    std::size_t count = 0;
+    while ((count = std::fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        content.insert(content.end(), buffer, (buffer + count));
+    }
+    std::fclose(file);
+    const std::size_t headerSize = (sizeof(LogFormat::Magic) + sizeof(LogFormat::Version) + sizeof(std::uint8_t));
+    if ((content.size() < headerSize) || (std::memcmp(content.data(), LogFormat::Magic, sizeof(LogFormat::Magic)) != 0)) {
+        std::fprintf(stderr, "\"%s\" is not a log file.\n", path);
+        return false;
+    }
+    std::uint32_t version = 0;
+    std::memcpy(&version, (content.data() + sizeof(LogFormat::Magic)), sizeof(version));
+    CHECK(version == LogFormat::Version);
+    const auto wcharSize = static_cast<std::size_t>(content[headerSize - 1]);
+    CHECK(wcharSize == sizeof(wchar_t));
+    LogFormat::Reader reader((content.data() + headerSize), (content.size() - headerSize), wcharSize);
+    std::vector<LogFormat::DescriptorEntry> descriptors = {};
+    LogFormat::RecordEntry record = {};
+    while (!reader.AtEnd()) {
+        LogFormat::EntryKind kind = {};
+        if (!reader.Get(kind)) {
+            return false;
+        }
+        if (kind == LogFormat::EntryKind::Descriptor) {
+            LogFormat::DescriptorEntry descriptor = {};
+            if (!reader.GetDescriptor(descriptor)) {
+                std::fprintf(stderr, "The log file is truncated.\n");
+                return false;
+            }
+            // Identifiers are handed out in order, and written before their first record.
+            CHECK(descriptor.Id == (descriptors.size() + 1));
+            descriptors.push_back(descriptor);
+            continue;
+        }
+        if ((kind != LogFormat::EntryKind::Record) || !reader.GetRecord(record)) {
+            std::fprintf(stderr, "The log file is truncated or corrupted.\n");
+            return false;
+        }
+        if ((record.Id == 0) || (record.Id > descriptors.size())) {
+            std::fprintf(stderr, "Record refers to the unknown descriptor %u.\n", record.Id);
+            return false;
+        }
+        const LogFormat::DescriptorEntry &descriptor = descriptors[record.Id - 1];
+        CHECK(descriptor.File.find("LogCheck") != std::string::npos);
+        CHECK(descriptor.Line != 0);
+        records.push_back({ record.Thread, descriptor.Level, descriptor.Function, LogFormat::Format(descriptor.Format, record.Arguments, DescribeErrorCode) });
+    }
+    return true;
+}
+
+static inline void CheckRecords(const std::vector<DecodedRecord> &records) noexcept
+{
+    // Records are only ordered within their thread, group them by the emitter.
+    std::vector<std::wstring> decoded[ThreadCount + 1] = {};
+    std::vector<std::uint32_t> threads[ThreadCount + 1] = {};
+    for (auto &&record : records) {
+        const std::size_t end = record.Text.find(L']');
+        const int emitter = ((record.Text.size() > 1) && (record.Text[0] == L'[') && (end != std::wstring::npos))
+                            ? std::stoi(record.Text.substr(1, (end - 1))) : -1;
+        if ((emitter < 0) || (emitter > ThreadCount)) {
+            CHECK(false && "a record of an unknown emitter");
+            continue;
+        }
+        decoded[emitter].push_back(record.Text);
+        threads[emitter].push_back(record.Thread);
+        CHECK(record.Function == ((emitter == 0) ? "LogCallSites" : "LogFromThread"));
+    }
+    for (int emitter = 0; emitter <= ThreadCount; ++emitter) {
+        CHECK(decoded[emitter].size() == g_expected[emitter].size());
+        for (std::size_t index = 0; (index < decoded[emitter].size()) && (index < g_expected[emitter].size()); ++index) {
+            if (decoded[emitter][index] != g_expected[emitter][index]) {
+                std::fprintf(stderr, "Record %zu of emitter %d differs.\n", index, emitter);
+                CHECK(decoded[emitter][index] == g_expected[emitter][index]);
+                break;
+            }
+        }
+        // All records of a thread carry its identifier.
+        for (auto &&thread : threads[emitter]) {
+            CHECK(thread == threads[emitter].front());
+        }
+    }
+    // The levels of the call sites: info, debug, warning, info, info, error.
+    static constexpr const std::uint8_t levels[] = { 1, 0, 2, 1, 1, 3 };
+    std::size_t next = 0;
+    for (auto &&record : records) {
+        if ((next < std::size(levels)) && (record.Function == "LogCallSites")) {
+            CHECK(record.Level == levels[next++]);
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc > 2) {
+        std::fprintf(stderr, "Usage: %s [file]\n", argv[0]);
+        return -1;
+    }
+    const char * const path = ((argc == 2) ? argv[1] : "LogCheck.wlog");
+    // Read when the first buffer is written out, that is after this.
+#ifdef _WIN32
+    _putenv_s("WIN32ACRYLICHELPER_LOG", path);
+#else
+    setenv("WIN32ACRYLICHELPER_LOG", path, 1);
+#endif
+
+    LogCallSites();
+    std::vector<std::thread> threads = {};
+    for (int thread = 1; thread <= ThreadCount; ++thread) {
+        threads.emplace_back(LogFromThread, thread);
+    }
+    for (auto &&thread : threads) {
+        thread.join();
+    }
+    Log::Flush();
+
+    std::vector<DecodedRecord> records = {};
+    CHECK(ReadLog(path, records));
+    CheckRecords(records);
+    const int result = Check::Finish("LogCheck");
+    if (result == 0) {
+        std::remove(path);
+    }
+    return result;
+}
@@ -0,0 +1,186 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// Prints the binary log files written by "Log.h" as text.
+//
+// Usage: LogReader <file> [debug|info|warning|error]
+//
+// The optional level hides everything below it. Each line shows the time since the
+// first record in milliseconds, the thread, the level, the call site and the message.
+
+#include "LogFormat.hpp"
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+static constexpr const char *LevelNames[] = { "debug", "info", "warning", "error" };
+
+[[nodiscard]] static inline std::string ToUTF8(const std::wstring &text) noexcept
+{
+    std::string result = {};
+    result.reserve(text.size());
+    for (std::size_t index = 0; index < text.size(); ++index) {
+        auto codePoint = static_cast<std::uint32_t>(text[index]);
+        // The writer may have used UTF-16, join the surrogate pairs.
+        if ((codePoint >= 0xD800) && (codePoint <= 0xDBFF) && ((index + 1) < text.size())) {
+            const auto low = static_cast<std::uint32_t>(text[index + 1]);
+            if ((low >= 0xDC00) && (low <= 0xDFFF)) {
+                codePoint = (0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00));
+                ++index;
+            }
+        }
+        if (codePoint < 0x80) {
+            result += static_cast<char>(codePoint);
+        } else if (codePoint < 0x800) {
+            result += static_cast<char>(0xC0 | (codePoint >> 6));
+            result += static_cast<char>(0x80 | (codePoint & 0x3F));
+        } else if (codePoint < 0x10000) {
+            result += static_cast<char>(0xE0 | (codePoint >> 12));
+            result += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+            result += static_cast<char>(0x80 | (codePoint & 0x3F));
+        } else {
+            result += static_cast<char>(0xF0 | (codePoint >> 18));
+            result += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+            result += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+            result += static_cast<char>(0x80 | (codePoint & 0x3F));
+        }
+    }
+    return result;
+}
+
+[[nodiscard]] static inline std::wstring DescribeErrorCode(const LogFormat::ErrorCode &code) noexcept
+{
+    // The messages of the system are not available here, the domain tells the format.
+    if (code.Domain == 1) {
+        static constexpr const wchar_t digits[] = L"0123456789ABCDEF";
+        std::wstring hex = {};
+        for (int shift = 28; shift >= 0; shift -= 4) {
+            hex += digits[(code.Value >> shift) & 0xF];
+        }
+        return (std::wstring(L"0x") + hex);
+    }
+    return std::to_wstring(code.Value);
+}
+
+[[nodiscard]] static inline bool ReadWholeFile(const char *path, std::vector<std::byte> &content) noexcept
+{
+    std::FILE *file = std::fopen(path, "rb");
+    if (!file) {
+        return false;
+    }
+    std::byte buffer[64 * 1024];
+    std::size_t count = 0;
+    while ((count = std::fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        content.insert(content.end(), buffer, (buffer + count));
+    }
+    std::fclose(file);
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    if ((argc < 2) || (argc > 3)) {
+        std::fprintf(stderr, "Usage: %s <file> [debug|info|warning|error]\n", argv[0]);
+        return -1;
+    }
+    std::uint8_t minimumLevel = 0;
+    if (argc == 3) {
+        bool found = false;
+        for (std::uint8_t level = 0; level != std::size(LevelNames); ++level) {
+            if (std::strcmp(argv[2], LevelNames[level]) == 0) {
+                minimumLevel = level;
+                found = true;
+                break;
+            }
+        }
+        if (!found) {
+            std::fprintf(stderr, "Unknown level \"%s\".\n", argv[2]);
+            return -1;
+        }
+    }
+    std::vector<std::byte> content = {};
+    if (!ReadWholeFile(argv[1], content)) {
+        std::fprintf(stderr, "Failed to open \"%s\".\n", argv[1]);
+        return -1;
+    }
+    const std::size_t headerSize = (sizeof(LogFormat::Magic) + sizeof(LogFormat::Version) + sizeof(std::uint8_t));
+    if ((content.size() < headerSize) || (std::memcmp(content.data(), LogFormat::Magic, sizeof(LogFormat::Magic)) != 0)) {
+        std::fprintf(stderr, "\"%s\" is not a log file.\n", argv[1]);
+        return -1;
+    }
+    std::uint32_t version = 0;
+    std::memcpy(&version, (content.data() + sizeof(LogFormat::Magic)), sizeof(version));
+    if (version != LogFormat::Version) {
+        std::fprintf(stderr, "Unsupported log file version %u.\n", version);
+        return -1;
+    }
+    const auto wcharSize = static_cast<std::size_t>(content[headerSize - 1]);
+    LogFormat::Reader reader((content.data() + headerSize), (content.size() - headerSize), wcharSize);
+    std::unordered_map<std::uint32_t, LogFormat::DescriptorEntry> descriptors = {};
+    LogFormat::RecordEntry record = {};
+    bool firstRecord = true;
+    std::uint64_t startTime = 0;
+    while (!reader.AtEnd()) {
+        LogFormat::EntryKind kind = {};
+        if (!reader.Get(kind)) {
+            break;
+        }
+        if (kind == LogFormat::EntryKind::Descriptor) {
+            LogFormat::DescriptorEntry descriptor = {};
+            if (!reader.GetDescriptor(descriptor)) {
+                std::fprintf(stderr, "The log file is truncated.\n");
+                return -1;
+            }
+            descriptors.insert_or_assign(descriptor.Id, descriptor);
+            continue;
+        }
+        if ((kind != LogFormat::EntryKind::Record) || !reader.GetRecord(record)) {
+            std::fprintf(stderr, "The log file is truncated or corrupted.\n");
+            return -1;
+        }
+        // Records are written per thread, so they are only ordered within a thread.
+        if (firstRecord) {
+            startTime = record.Timestamp;
+            firstRecord = false;
+        }
+        const auto search = descriptors.find(record.Id);
+        if (search == descriptors.cend()) {
+            std::fprintf(stderr, "Record refers to the unknown descriptor %u.\n", record.Id);
+            continue;
+        }
+        const LogFormat::DescriptorEntry &descriptor = search->second;
+        if (descriptor.Level < minimumLevel) {
+            continue;
+        }
+        const double milliseconds = ((static_cast<double>(record.Timestamp) - static_cast<double>(startTime)) / 1000000.0);
+        const char *levelName = ((descriptor.Level < std::size(LevelNames)) ? LevelNames[descriptor.Level] : "?");
+        const std::string text = ToUTF8(LogFormat::Format(descriptor.Format, record.Arguments, DescribeErrorCode));
+        std::printf("%12.3f [%u] %-7s %s:%u %s(): %s\n", milliseconds, record.Thread, levelName,
+                    descriptor.File.c_str(), descriptor.Line, descriptor.Function.c_str(), text.c_str());
+    }
+    return 0;
+}
@@ -0,0 +1,369 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// Replays the message traces recorded by "MessageTrace.h" through the platform
+// independent parts of the window logic: the hit-test map, the frame scheduler, the
+// client area of WM_NCCALCSIZE and the coalescing of geometry changes. No desktop is
+// needed, so the numbers are repeatable on any machine.
+//
+// What Windows itself does is not replayed: the default frame "DefWindowProc()"
+// applies to WM_NCCALCSIZE (the frame border is taken as visible, as on Windows 10),
+// the auto-hide task bar (taken as absent) and the timer delivering a delayed geometry
+// change (it fires with the first entry past its due time).
+//
+// Usage: MessageTraceReplay <file> [iterations]
+//
+// Prints a summary of the trace, the replay throughput, and the latency of every
+// replayed message kind, in nanoseconds.
+//
+// "Sample.trace" next to this file holds one window being hovered, resized by its
+// right edge for one and a half seconds and then moved to a monitor with 150% scaling.
+
+#include "MessageTraceFormat.hpp"
+#include "HitTestMap.hpp"
+#include "FrameScheduler.h"
+#include "WindowFrameGeometry.hpp"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace Messages = MessageTraceFormat::Messages;
+
+enum class ReplayKind : int
+{
+    HitTest = 0, // WM_NCHITTEST, a hit-test map lookup.
+    BuildHitTestMap, // A recorded hit-test geometry, the map is rebuilt.
+    CalcSize, // WM_NCCALCSIZE, the client area and the vertical blank to commit the resize on.
+    GeometryChange, // WM_WINDOWPOSCHANGED, the geometry change is delivered now or once the frame is over.
+    DpiChanged, // WM_DPICHANGED, the frame schedule is thrown away.
+    Count
+};
+
+static constexpr const char *ReplayKindNames[] = { "WM_NCHITTEST", "hit-test map rebuild", "WM_NCCALCSIZE", "WM_WINDOWPOSCHANGED", "WM_DPICHANGED" };
+static_assert(std::size(ReplayKindNames) == static_cast<std::size_t>(ReplayKind::Count));
+
+// The clock of the replay runs in nanoseconds, like the trace, at 60Hz.
+static constexpr const std::int64_t ClockFrequency = 1000000000;
+static constexpr const std::int64_t RefreshPeriod = (ClockFrequency / 60);
+
+// The values of the Windows ABI.
+static constexpr const std::uint64_t SizeMaximized = 2; // SIZE_MAXIMIZED
+static constexpr const std::uint32_t NoSize = 0x0001; // SWP_NOSIZE
+static constexpr const std::uint32_t NoMove = 0x0002; // SWP_NOMOVE
+
+struct ReplayWindow
+{
+    HitTestMap Map = HitTestMap();
+    int OriginX = 0;
+    int OriginY = 0;
+    bool Maximized = false;
+    int ResizeBorderThicknessX = 0;
+    int ResizeBorderThicknessY = 0;
+    MessageTraceFormat::WindowPos Geometry = {};
+    MessageTraceFormat::WindowPos DeliveredGeometry = {};
+    GeometryChangeCoalescer Coalescer = GeometryChangeCoalescer();
+    std::int64_t DeliveryTime = 0; // When the pending geometry change is due.
+};
+
+struct ReplayState
+{
+    explicit ReplayState() noexcept : Scheduler(Clock) {}
+
+    FakeFrameClock Clock = FakeFrameClock(ClockFrequency, RefreshPeriod);
+    FrameScheduler Scheduler;
+    std::vector<ReplayWindow> Windows = {};
+    std::uint64_t Checksum = 0; // Keeps the work from being optimized away, and must not change between runs.
+};
+
+[[nodiscard]] static inline bool ReadWholeFile(const char *path, std::vector<std::byte> &content) noexcept
+{
+    std::FILE *file = std::fopen(path, "rb");
+    if (!file) {
+        return false;
+    }
+    std::byte buffer[64 * 1024];
+    std::size_t count = 0;
+    while ((count = std::fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        content.insert(content.end(), buffer, (buffer + count));
+    }
+    std::fclose(file);
+    return true;
+}
+
+// The same as "GET_X_LPARAM()" and "GET_Y_LPARAM()".
+[[nodiscard]] static inline int SignedLowWord(const std::uint64_t value) noexcept
+{
+    return static_cast<int>(static_cast<std::int16_t>(value & 0xFFFF));
+}
+
+[[nodiscard]] static inline int SignedHighWord(const std::uint64_t value) noexcept
+{
+    return static_cast<int>(static_cast<std::int16_t>((value >> 16) & 0xFFFF));
+}
+
+static inline void DeliverGeometryChange(ReplayState &state, ReplayWindow &window) noexcept
+{
+    window.Coalescer.Delivered(state.Clock.Now());
+    const MessageTraceFormat::WindowPos &geometry = window.Geometry;
+    const MessageTraceFormat::WindowPos &delivered = window.DeliveredGeometry;
+    if ((geometry.X == delivered.X) && (geometry.Y == delivered.Y) && (geometry.Width == delivered.Width) && (geometry.Height == delivered.Height)) {
+        return;
+    }
+    window.DeliveredGeometry = geometry;
+    state.Checksum += (static_cast<std::uint64_t>(geometry.Width) * 31 + static_cast<std::uint64_t>(geometry.Height));
+}
+
+[[nodiscard]] static inline MessageTraceFormat::Rect CalculateClientArea(const ReplayWindow &window, const MessageTraceFormat::Rect &proposed) noexcept
+{
+    ClientAreaFrame frame = {};
+    frame.Maximized = window.Maximized;
+    frame.FrameBorderVisible = true;
+    frame.ResizeBorderThicknessX = window.ResizeBorderThicknessX;
+    frame.ResizeBorderThicknessY = window.ResizeBorderThicknessY;
+    const ClientAreaInsets insets = CalculateClientAreaInsets(frame);
+    MessageTraceFormat::Rect result = proposed;
+    result.Left += insets.Left;
+    result.Top += insets.Top;
+    result.Right -= insets.Right;
+    result.Bottom -= insets.Bottom;
+    return result;
+}
+
+// Returns the kind of work done, or "ReplayKind::Count" if the entry doesn't replay anything.
+static inline ReplayKind Replay(ReplayState &state, const MessageTraceFormat::Entry &entry) noexcept
+{
+    const MessageTraceFormat::MessageEntry &message = entry.Message;
+    if (message.Window >= state.Windows.size()) {
+        state.Windows.resize(message.Window + 1);
+    }
+    const auto now = static_cast<std::int64_t>(message.Timestamp);
+    if (now > state.Clock.Now()) {
+        state.Clock.Advance(now - state.Clock.Now());
+    }
+    // The timers of the delayed geometry changes.
+    for (auto &&window : state.Windows) {
+        if (window.Coalescer.Pending() && (window.DeliveryTime <= now)) {
+            DeliverGeometryChange(state, window);
+        }
+    }
+    ReplayWindow &window = state.Windows[message.Window];
+    if (entry.Kind == MessageTraceFormat::EntryKind::HitTestGeometry) {
+        const MessageTraceFormat::HitTestGeometryEntry &recorded = entry.Geometry;
+        HitTestGeometry geometry = {};
+        geometry.Width = recorded.Width;
+        geometry.Height = recorded.Height;
+        geometry.ResizeBorderThicknessX = recorded.ResizeBorderThicknessX;
+        geometry.ResizeBorderThicknessY = recorded.ResizeBorderThicknessY;
+        geometry.TitleBarHeight = recorded.TitleBarHeight;
+        geometry.HasTitleBar = (recorded.HasTitleBar != 0);
+        geometry.ResizableTop = (recorded.ResizableTop != 0);
+        geometry.ResizableEdges = (recorded.ResizableEdges != 0);
+        window.Map.Build(geometry);
+        window.OriginX = recorded.OriginX;
+        window.OriginY = recorded.OriginY;
+        window.ResizeBorderThicknessX = recorded.ResizeBorderThicknessX;
+        window.ResizeBorderThicknessY = recorded.ResizeBorderThicknessY;
+        return ReplayKind::BuildHitTestMap;
+    }
+    switch (message.Message) {
+    case Messages::NcHitTest: {
+        const int x = (SignedLowWord(message.LParam) - window.OriginX);
+        const int y = (SignedHighWord(message.LParam) - window.OriginY);
+        state.Checksum += static_cast<std::uint64_t>(window.Map.Find(x, y));
+        return ReplayKind::HitTest;
+    }
+    case Messages::NcCalcSize: {
+        // Both payloads keep the proposed window rectangle in the first one.
+        if (message.Payload != MessageTraceFormat::PayloadType::None) {
+            const MessageTraceFormat::Rect client = CalculateClientArea(window, message.Params.Rects[0]);
+            state.Checksum += static_cast<std::uint64_t>((client.Right - client.Left) + (client.Bottom - client.Top));
+        }
+        state.Checksum += static_cast<std::uint64_t>(state.Scheduler.NextVBlank(state.Clock.Now()));
+        return ReplayKind::CalcSize;
+    }
+    case Messages::Size:
+        window.Maximized = (message.WParam == SizeMaximized);
+        break;
+    case Messages::WindowPosChanged: {
+        if (message.Payload != MessageTraceFormat::PayloadType::WindowPos) {
+            break;
+        }
+        const MessageTraceFormat::WindowPos &position = message.Params.Position;
+        if ((position.Flags & NoMove) == 0) {
+            window.Geometry.X = position.X;
+            window.Geometry.Y = position.Y;
+        }
+        if ((position.Flags & NoSize) == 0) {
+            window.Geometry.Width = position.Width;
+            window.Geometry.Height = position.Height;
+        }
+        const std::int64_t period = state.Scheduler.Period();
+        const std::int64_t delay = window.Coalescer.Schedule(now, ((period > 0) ? period : RefreshPeriod));
+        if (delay == 0) {
+            DeliverGeometryChange(state, window);
+        } else if (delay > 0) {
+            window.DeliveryTime = (now + delay);
+        }
+        return ReplayKind::GeometryChange;
+    }
+    case Messages::DpiChanged:
+        state.Scheduler.Invalidate();
+        return ReplayKind::DpiChanged;
+    default:
+        break;
+    }
+    return ReplayKind::Count;
+}
+
+int main(int argc, char *argv[])
+{
+    if ((argc < 2) || (argc > 3)) {
+        std::fprintf(stderr, "Usage: %s <file> [iterations]\n", argv[0]);
+        return -1;
+    }
+    int iterations = 10;
+    if (argc == 3) {
+        iterations = std::atoi(argv[2]);
+        if (iterations <= 0) {
+            std::fprintf(stderr, "Invalid iteration count \"%s\".\n", argv[2]);
+            return -1;
+        }
+    }
+    std::vector<std::byte> content = {};
+    if (!ReadWholeFile(argv[1], content)) {
+        std::fprintf(stderr, "Failed to open \"%s\".\n", argv[1]);
+        return -1;
+    }
+    const std::size_t headerSize = (sizeof(MessageTraceFormat::Magic) + sizeof(MessageTraceFormat::Version));
+    if ((content.size() < headerSize) || (std::memcmp(content.data(), MessageTraceFormat::Magic, sizeof(MessageTraceFormat::Magic)) != 0)) {
+        std::fprintf(stderr, "\"%s\" is not a message trace.\n", argv[1]);
+        return -1;
+    }
+    std::uint32_t version = 0;
+    std::memcpy(&version, (content.data() + sizeof(MessageTraceFormat::Magic)), sizeof(version));
+    if (version != MessageTraceFormat::Version) {
+        std::fprintf(stderr, "Unsupported message trace version %u.\n", version);
+        return -1;
+    }
+    MessageTraceFormat::Reader reader((content.data() + headerSize), (content.size() - headerSize));
+    std::vector<MessageTraceFormat::Entry> entries = {};
+    std::uint32_t windowCount = 0;
+    while (!reader.AtEnd()) {
+        MessageTraceFormat::Entry entry = {};
+        if (!reader.GetEntry(entry)) {
+            // The recording may have been cut short, replay what's there.
+            std::fprintf(stderr, "The message trace is truncated or corrupted, ignoring the rest.\n");
+            break;
+        }
+        windowCount = std::max(windowCount, (entry.Message.Window + 1));
+        // The geometry is recorded while a hit test is being handled, after the
+        // message itself. Replay the rebuild first, as it happened.
+        if ((entry.Kind == MessageTraceFormat::EntryKind::HitTestGeometry) && !entries.empty()) {
+            const MessageTraceFormat::Entry &previous = entries.back();
+            if ((previous.Kind == MessageTraceFormat::EntryKind::Message) && (previous.Message.Message == Messages::NcHitTest)
+                    && (previous.Message.Window == entry.Message.Window)) {
+                entries.insert((entries.end() - 1), entry);
+                continue;
+            }
+        }
+        entries.push_back(entry);
+    }
+    if (entries.empty()) {
+        std::fprintf(stderr, "The message trace is empty.\n");
+        return -1;
+    }
+    std::array<std::size_t, static_cast<std::size_t>(ReplayKind::Count)> kindCounts = {};
+    {
+        ReplayState state;
+        for (auto &&entry : entries) {
+            const ReplayKind kind = Replay(state, entry);
+            if (kind != ReplayKind::Count) {
+                ++kindCounts[static_cast<std::size_t>(kind)];
+            }
+        }
+    }
+    const double traceMilliseconds = (static_cast<double>(entries.back().Message.Timestamp - entries.front().Message.Timestamp) / 1000000.0);
+    std::printf("Trace: %zu entries, %u windows, %.3f ms\n", entries.size(), windowCount, traceMilliseconds);
+    for (std::size_t kind = 0; kind != kindCounts.size(); ++kind) {
+        std::printf("  %-24s %zu\n", ReplayKindNames[kind], kindCounts[kind]);
+    }
+
+    // Throughput: the whole trace in one go, without timing every single entry.
+    std::uint64_t checksum = 0;
+    std::chrono::nanoseconds total = {};
+    for (int iteration = 0; iteration != iterations; ++iteration) {
+        ReplayState state;
+        const auto start = std::chrono::steady_clock::now();
+        for (auto &&entry : entries) {
+            Replay(state, entry);
+        }
+        total += (std::chrono::steady_clock::now() - start);
+        if ((iteration != 0) && (state.Checksum != checksum)) {
+            std::fprintf(stderr, "The replay is not deterministic.\n");
+            return -1;
+        }
+        checksum = state.Checksum;
+    }
+    const double seconds = std::chrono::duration<double>(total).count();
+    std::printf("Replay: %d iterations, %.3f ms per iteration, %.0f entries per second (checksum %llu)\n",
+                iterations, ((seconds * 1000.0) / iterations), ((static_cast<double>(entries.size()) * iterations) / seconds),
+                static_cast<unsigned long long>(checksum));
+
+    // Latency: every entry timed on its own, the clock reading is part of the numbers.
+    std::array<std::vector<std::int64_t>, static_cast<std::size_t>(ReplayKind::Count)> latencies = {};
+    for (int iteration = 0; iteration != iterations; ++iteration) {
+        ReplayState state;
+        for (auto &&entry : entries) {
+            const auto start = std::chrono::steady_clock::now();
+            const ReplayKind kind = Replay(state, entry);
+            const auto end = std::chrono::steady_clock::now();
+            if (kind != ReplayKind::Count) {
+                latencies[static_cast<std::size_t>(kind)].push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+            }
+        }
+    }
+    std::printf("%-24s %10s %10s %10s %10s %10s\n", "Latency (ns)", "count", "mean", "p50", "p99", "max");
+    for (std::size_t kind = 0; kind != latencies.size(); ++kind) {
+        std::vector<std::int64_t> &values = latencies[kind];
+        if (values.empty()) {
+            continue;
+        }
+        std::sort(values.begin(), values.end());
+        std::int64_t sum = 0;
+        for (auto &&value : values) {
+            sum += value;
+        }
+        const auto percentile = [&values](const std::size_t percent) -> std::int64_t {
+            return values[std::min((values.size() - 1), ((values.size() * percent) / 100))];
+        };
+        std::printf("%-24s %10zu %10lld %10lld %10lld %10lld\n", ReplayKindNames[kind], values.size(),
+                    static_cast<long long>(sum / static_cast<std::int64_t>(values.size())), static_cast<long long>(percentile(50)),
+                    static_cast<long long>(percentile(99)), static_cast<long long>(values.back()));
+    }
+    return 0;
+}
@@ -0,0 +1,183 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// Checks the personalization settings cache ("PersonalizationSettings.h") against a
+// "MockSettingsBackend": a write wakes up the watcher, the generation only moves when
+// a setting really changes, and the destructor stops and joins the watcher.
+//
+// Usage: PersonalizationSettingsCheck
+
+#include "PersonalizationSettings.h"
+#include "../Check.hpp"
+#include <chrono>
+
+// Forwards to a "MockSettingsBackend" and tells when the watcher is back waiting,
+// that is when it has finished the refresh of the previous change.
+class ObservedSettingsBackend final : public SettingsBackend
+{
+public:
+    explicit ObservedSettingsBackend() noexcept = default;
+    ~ObservedSettingsBackend() noexcept override = default;
+
+    [[nodiscard]] std::uint32_t ReadDWORD(const SettingsKey key, const std::wstring &name) noexcept override
+    {
+        return m_mock.ReadDWORD(key, name);
+    }
+
+    [[nodiscard]] std::uint32_t ColorizationColor() noexcept override
+    {
+        return m_mock.ColorizationColor();
+    }
+
+    [[nodiscard]] bool HighContrast() noexcept override
+    {
+        return m_mock.HighContrast();
+    }
+
+    [[nodiscard]] bool WaitForChange() noexcept override
+    {
+        {
+            const std::scoped_lock lock(m_mutex);
+            ++m_waitCount;
+            m_condition.notify_all();
+        }
+        const bool result = m_mock.WaitForChange();
+        if (!result) {
+            m_watcherStopped = true;
+        }
+        return result;
+    }
+
+    void Stop() noexcept override
+    {
+        m_mock.Stop();
+    }
+
+    [[nodiscard]] MockSettingsBackend &Mock() noexcept
+    {
+        return m_mock;
+    }
+
+    [[nodiscard]] int WaitCount() noexcept
+    {
+        const std::scoped_lock lock(m_mutex);
+        return m_waitCount;
+    }
+
+    // False if the watcher didn't get there in time.
+    [[nodiscard]] bool WaitForWatcher(const int waitCount) noexcept
+    {
+        std::unique_lock lock(m_mutex);
+        return m_condition.wait_for(lock, std::chrono::seconds(10), [this, waitCount](){ return (m_waitCount >= waitCount); });
+    }
+
+    [[nodiscard]] bool WatcherStopped() const noexcept
+    {
+        return m_watcherStopped;
+    }
+
+private:
+    ObservedSettingsBackend(const ObservedSettingsBackend &) = delete;
+    ObservedSettingsBackend &operator=(const ObservedSettingsBackend &) = delete;
+    ObservedSettingsBackend(ObservedSettingsBackend &&) = delete;
+    ObservedSettingsBackend &operator=(ObservedSettingsBackend &&) = delete;
+
+private:
+    MockSettingsBackend m_mock;
+    std::mutex m_mutex = {};
+    std::condition_variable m_condition = {};
+    int m_waitCount = 0;
+    std::atomic<bool> m_watcherStopped = false;
+};
+
+static inline void CheckWatcher() noexcept
+{
+    ObservedSettingsBackend backend;
+    backend.Mock().ColorizationColor(0xFF0078D7);
+    {
+        PersonalizationSettings settings(backend);
+        // The color written above is still pending, the watcher refreshes once for it.
+        CHECK(backend.WaitForWatcher(2));
+        const PersonalizationSnapshot initial = settings.Snapshot();
+        CHECK(initial.ColorizationColor == 0xFF0078D7);
+        CHECK(!initial.AppsUseLightTheme);
+
+        // A write wakes up the watcher, which publishes the change on its own.
+        backend.Mock().Write(SettingsKey::Personalize, L"AppsUseLightTheme", 1);
+        CHECK(backend.WaitForWatcher(3));
+        const PersonalizationSnapshot light = settings.Snapshot();
+        CHECK(light.AppsUseLightTheme);
+        CHECK(light.ColorizationColor == 0xFF0078D7);
+        CHECK(light.Generation == ((initial.Generation + 1) & PersonalizationSnapshot::GenerationMask));
+
+        // Writing the same value again wakes up the watcher as well, but nothing changed.
+        backend.Mock().Write(SettingsKey::Personalize, L"AppsUseLightTheme", 1);
+        CHECK(backend.WaitForWatcher(4));
+        CHECK(settings.Snapshot().Generation == light.Generation);
+        // Values nobody reads don't count either.
+        backend.Mock().Write(SettingsKey::Dwm, L"Composition", 1);
+        CHECK(backend.WaitForWatcher(5));
+        CHECK(settings.Snapshot().Generation == light.Generation);
+
+        // Unlike the registry, the mock wakes up the watcher for high contrast too.
+        // An explicit refresh afterwards finds nothing new.
+        backend.Mock().HighContrast(true);
+        CHECK(backend.WaitForWatcher(6));
+        const PersonalizationSnapshot highContrast = settings.Snapshot();
+        CHECK(highContrast.HighContrast);
+        CHECK(highContrast.Generation == ((light.Generation + 1) & PersonalizationSnapshot::GenerationMask));
+        settings.Refresh();
+        CHECK(settings.Snapshot().Generation == highContrast.Generation);
+        CHECK(!backend.WatcherStopped());
+    }
+    // The destructor doesn't return before the watcher is gone.
+    CHECK(backend.WatcherStopped());
+    const int waitCount = backend.WaitCount();
+    backend.Mock().Write(SettingsKey::Dwm, L"ColorPrevalence", 1);
+    CHECK(backend.WaitCount() == waitCount);
+}
+
+static inline void CheckPacking() noexcept
+{
+    PersonalizationSnapshot snapshot = {};
+    snapshot.ColorizationColor = 0xC40078D7;
+    snapshot.DwmColorPrevalence = true;
+    snapshot.HighContrast = true;
+    snapshot.Generation = PersonalizationSnapshot::GenerationMask;
+    const PersonalizationSnapshot unpacked = PersonalizationSnapshot::Unpack(PersonalizationSnapshot::Pack(snapshot));
+    CHECK(unpacked.SameSettings(snapshot));
+    CHECK(!unpacked.AppsUseLightTheme);
+    CHECK(!unpacked.ThemeColorPrevalence);
+    CHECK(unpacked.Generation == PersonalizationSnapshot::GenerationMask);
+    // The generation wraps instead of spilling into the other settings.
+    snapshot.Generation = (PersonalizationSnapshot::GenerationMask + 1);
+    CHECK(PersonalizationSnapshot::Unpack(PersonalizationSnapshot::Pack(snapshot)).Generation == 0);
+}
+
+int main()
+{
+    CheckPacking();
+    CheckWatcher();
+    return Check::Finish("PersonalizationSettingsCheck");
+}
@@ -0,0 +1,159 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// Measures emitting a "Signal" ("Signal.hpp") with no, one and several subscribers,
+// against calling a "std::function" member and a vector of them, the way the
+// callbacks used to be stored.
+//
+// Usage: SignalBenchmark [iterations]
+//
+// Prints the average cost of a single emission in nanoseconds, and the heap
+// allocations per emission, counted by replacing the global "operator new".
+
+#include "Signal.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <new>
+#include <vector>
+
+static std::size_t g_allocationCount = 0;
+
+void *operator new(const std::size_t size)
+{
+    ++g_allocationCount;
+    if (void *memory = std::malloc((size != 0) ? size : 1)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void *memory, [[maybe_unused]] const std::size_t size) noexcept
+{
+    std::free(memory);
+}
+
+// Several subscribers, like the windows listening to a settings change.
+static constexpr const int SlotCount = 8;
+
+// Where the subscribers add the argument, keeps the calls from being dropped.
+static volatile std::uint64_t g_sink = 0;
+
+struct Result
+{
+    double Nanoseconds = 0.0;
+    double Allocations = 0.0;
+};
+
+template<typename Function>
+[[nodiscard]] static inline Result Measure(const int iterations, Function &&function)
+{
+    const std::size_t allocationCount = g_allocationCount;
+    const auto start = std::chrono::steady_clock::now();
+    for (int index = 0; index != iterations; ++index) {
+        function(index);
+    }
+    const auto finish = std::chrono::steady_clock::now();
+    Result result = {};
+    result.Nanoseconds = (static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(finish - start).count()) / iterations);
+    result.Allocations = (static_cast<double>(g_allocationCount - allocationCount) / iterations);
+    return result;
+}
+
+static inline void Print(const char *name, const Result &result)
+{
+    std::printf("  %-32s %10.2f ns %10.2f\n", name, result.Nanoseconds, result.Allocations);
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc > 2) {
+        std::fprintf(stderr, "Usage: %s [iterations]\n", argv[0]);
+        return -1;
+    }
+    int iterations = 10000000;
+    if (argc == 2) {
+        iterations = std::atoi(argv[1]);
+        if (iterations <= 0) {
+            std::fprintf(stderr, "Invalid iteration count \"%s\".\n", argv[1]);
+            return -1;
+        }
+    }
+
+    std::uint64_t total = 0;
+    const auto subscriber = [&total](const int value) { total += static_cast<std::uint64_t>(value); };
+
+    Signal<int> empty;
+    Signal<int> single;
+    Signal<int> several;
+    std::vector<SignalConnection> connections = {};
+    connections.push_back(single.Connect(subscriber));
+    for (int index = 0; index != SlotCount; ++index) {
+        connections.push_back(several.Connect(subscriber));
+    }
+
+    std::function<void(int)> emptyFunction = {};
+    std::function<void(int)> singleFunction = subscriber;
+    std::vector<std::function<void(int)>> severalFunctions(SlotCount, subscriber);
+
+    // Everything is reached through volatile pointers, otherwise the compiler
+    // hoists the checks for subscribers out of the loops.
+    Signal<int> * volatile emptyPointer = &empty;
+    Signal<int> * volatile singlePointer = &single;
+    Signal<int> * volatile severalPointer = &several;
+    std::function<void(int)> * volatile emptyFunctionPointer = &emptyFunction;
+    std::function<void(int)> * volatile singleFunctionPointer = &singleFunction;
+    std::vector<std::function<void(int)>> * volatile severalFunctionsPointer = &severalFunctions;
+
+    std::printf("%-34s %13s %10s\n", "Emissions", "time", "allocations");
+    Print("Signal, no subscriber", Measure(iterations, [&](const int value) { emptyPointer->Emit(value); }));
+    Print("std::function, empty", Measure(iterations, [&](const int value) {
+        if (*emptyFunctionPointer) {
+            (*emptyFunctionPointer)(value);
+        }
+    }));
+    Print("Signal, 1 subscriber", Measure(iterations, [&](const int value) { singlePointer->Emit(value); }));
+    Print("std::function", Measure(iterations, [&](const int value) { (*singleFunctionPointer)(value); }));
+    char name[64] = {};
+    std::snprintf(name, sizeof(name), "Signal, %d subscribers", SlotCount);
+    Print(name, Measure(iterations, [&](const int value) { severalPointer->Emit(value); }));
+    std::snprintf(name, sizeof(name), "std::vector<std::function>, %d", SlotCount);
+    Print(name, Measure(iterations, [&](const int value) {
+        for (auto &&function : *severalFunctionsPointer) {
+            function(value);
+        }
+    }));
+
+    g_sink = total;
+    for (auto &&connection : connections) {
+        connection.Disconnect();
+    }
+    return 0;
+}
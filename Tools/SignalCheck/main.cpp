@@ -0,0 +1,189 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// Checks the connection management of "Signal.hpp" while emitting: slots which are
+// disconnected by themselves or by others stay alive until the emission is over,
+// don't run anymore, and slots connected meanwhile only run from the next emission.
+//
+// Usage: SignalCheck
+
+#include "Signal.hpp"
+#include "../Check.hpp"
+#include <array>
+#include <utility>
+
+// Flags its own destruction, moved-from instances don't count.
+class Tracker
+{
+public:
+    inline explicit Tracker(bool *destroyed) noexcept : m_destroyed(destroyed) {}
+    inline Tracker(Tracker &&other) noexcept : m_destroyed(std::exchange(other.m_destroyed, nullptr)) {}
+    inline ~Tracker() noexcept {
+        if (m_destroyed) {
+            *m_destroyed = true;
+        }
+    }
+
+    [[nodiscard]] inline bool Alive() const noexcept {
+        return (m_destroyed && !*m_destroyed);
+    }
+
+private:
+    Tracker(const Tracker &) = delete;
+    Tracker &operator=(const Tracker &) = delete;
+    Tracker &operator=(Tracker &&) = delete;
+
+private:
+    bool *m_destroyed = nullptr;
+};
+
+// Padding pushes a callable out of the inline buffer of the slot.
+template<std::size_t PaddingSize>
+static inline void CheckSelfDisconnect() noexcept
+{
+    Signal<int> signal;
+    bool destroyed = false;
+    int calls = 0;
+    SignalConnection connection;
+    connection = signal.Connect([tracker = Tracker(&destroyed), padding = std::array<char, PaddingSize>(), &connection, &calls](const int) {
+        CHECK(padding.size() == PaddingSize);
+        ++calls;
+        connection.Disconnect();
+        // Still running, so the captures must still be there.
+        CHECK(tracker.Alive());
+    });
+    signal.Emit(1);
+    CHECK(calls == 1);
+    CHECK(destroyed);
+    CHECK(signal.Empty());
+    signal.Emit(2);
+    CHECK(calls == 1);
+}
+
+static inline void CheckDisconnectAll() noexcept
+{
+    Signal<> signal;
+    bool destroyed = false;
+    int laterCalls = 0;
+    int pendingCalls = 0;
+    [[maybe_unused]] SignalConnection first = signal.Connect([tracker = Tracker(&destroyed), &signal, &pendingCalls]() {
+        signal.DisconnectAll();
+        CHECK(tracker.Alive());
+        // Connected and disconnected within the same emission.
+        [[maybe_unused]] SignalConnection pending = signal.Connect([&pendingCalls]() { ++pendingCalls; });
+        signal.DisconnectAll();
+    });
+    [[maybe_unused]] SignalConnection later = signal.Connect([&laterCalls]() { ++laterCalls; });
+    signal.Emit();
+    CHECK(destroyed);
+    CHECK(laterCalls == 0);
+    CHECK(signal.Empty());
+    signal.Emit();
+    CHECK(pendingCalls == 0);
+}
+
+static inline void CheckDisconnectOthers() noexcept
+{
+    Signal<> signal;
+    int firstCalls = 0;
+    int secondCalls = 0;
+    int connectedCalls = 0;
+    SignalConnection second;
+    SignalConnection connected;
+    [[maybe_unused]] SignalConnection first = signal.Connect([&]() {
+        ++firstCalls;
+        second.Disconnect();
+        if (!connected.Valid()) {
+            connected = signal.Connect([&connectedCalls]() { ++connectedCalls; });
+        }
+    });
+    second = signal.Connect([&secondCalls]() { ++secondCalls; });
+    signal.Emit();
+    CHECK(firstCalls == 1);
+    CHECK(secondCalls == 0);
+    CHECK(connectedCalls == 0);
+    signal.Emit();
+    CHECK(firstCalls == 2);
+    CHECK(secondCalls == 0);
+    CHECK(connectedCalls == 1);
+}
+
+// A lone slot takes the shortcut in "Emit()", what it connects must still wait.
+static inline void CheckConnectFromSingleSlot() noexcept
+{
+    Signal<> signal;
+    int firstCalls = 0;
+    int connectedCalls = 0;
+    SignalConnection connected;
+    [[maybe_unused]] SignalConnection first = signal.Connect([&]() {
+        ++firstCalls;
+        if (!connected.Valid()) {
+            connected = signal.Connect([&connectedCalls]() { ++connectedCalls; });
+        }
+    });
+    signal.Emit();
+    CHECK(firstCalls == 1);
+    CHECK(connectedCalls == 0);
+    signal.Emit();
+    CHECK(firstCalls == 2);
+    CHECK(connectedCalls == 1);
+    first.Disconnect();
+    signal.Emit();
+    CHECK(firstCalls == 2);
+    CHECK(connectedCalls == 2);
+}
+
+static inline void CheckNestedEmission() noexcept
+{
+    Signal<int> signal;
+    bool destroyed = false;
+    int innerCalls = 0;
+    SignalConnection inner;
+    [[maybe_unused]] SignalConnection outer = signal.Connect([&signal, &inner](const int depth) {
+        if (depth == 0) {
+            signal.Emit(1);
+        }
+    });
+    inner = signal.Connect([tracker = Tracker(&destroyed), &inner, &innerCalls](const int) {
+        ++innerCalls;
+        inner.Disconnect();
+        CHECK(tracker.Alive());
+    });
+    // The inner emission runs the slot and disconnects it, the outer one must
+    // neither run it again nor have it destroyed before it's over.
+    signal.Emit(0);
+    CHECK(innerCalls == 1);
+    CHECK(destroyed);
+}
+
+int main()
+{
+    CheckSelfDisconnect<1>();
+    CheckSelfDisconnect<256>();
+    CheckDisconnectAll();
+    CheckDisconnectOthers();
+    CheckConnectFromSingleSlot();
+    CheckNestedEmission();
+    return Check::Finish("SignalCheck");
+}
@@ -0,0 +1,133 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// Measures the symbol lookups of the system library cache ("SystemLibrary.h") against
+// resolving the symbol from the library every time, for both symbols which exist
+// (cache hits) and symbols which don't (cache misses).
+//
+// Usage: SystemLibraryBenchmark [iterations]
+//
+// Prints the average cost of a single lookup of every kind, in nanoseconds. Every
+// uncached miss is logged, the log goes to the null device unless
+// "WIN32ACRYLICHELPER_LOG" names a file already.
+
+#include "SystemLibrary.h"
+#include "SystemLibraryManager.h"
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+// A library which is loaded into every process anyway, so that the uncached lookups
+// don't have to load it, like "GetModuleHandleW()" on Windows.
+#ifdef _WIN32
+static constexpr const char NullDevice[] = "NUL";
+static constexpr const wchar_t LibraryFileName[] = L"kernel32.dll";
+static constexpr const wchar_t ExistingSymbol[] = L"GetTickCount";
+#elif defined(__APPLE__)
+static constexpr const char NullDevice[] = "/dev/null";
+static constexpr const wchar_t LibraryFileName[] = L"/usr/lib/libSystem.B.dylib";
+static constexpr const wchar_t ExistingSymbol[] = L"strlen";
+#else
+static constexpr const char NullDevice[] = "/dev/null";
+static constexpr const wchar_t LibraryFileName[] = L"libc.so.6";
+static constexpr const wchar_t ExistingSymbol[] = L"strlen";
+#endif
+static constexpr const wchar_t MissingSymbol[] = L"Win32AcrylicHelperNoSuchSymbol";
+
+// Keeps the compiler from dropping the lookups.
+static volatile std::uintptr_t g_sink = 0;
+
+template<typename Function>
+[[nodiscard]] static inline double Measure(const int iterations, Function &&function) noexcept
+{
+    std::uintptr_t sink = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (int index = 0; index < iterations; ++index) {
+        sink ^= reinterpret_cast<std::uintptr_t>(function());
+    }
+    const auto finish = std::chrono::steady_clock::now();
+    g_sink = sink;
+    return (static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(finish - start).count()) / static_cast<double>(iterations));
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc > 2) {
+        std::fprintf(stderr, "Usage: %s [iterations]\n", argv[0]);
+        return -1;
+    }
+    int iterations = 1000000;
+    if (argc == 2) {
+        iterations = std::atoi(argv[1]);
+        if (iterations <= 0) {
+            std::fprintf(stderr, "Invalid iteration count \"%s\".\n", argv[1]);
+            return -1;
+        }
+    }
+
+    if (!std::getenv("WIN32ACRYLICHELPER_LOG")) {
+#ifdef _WIN32
+        _putenv_s("WIN32ACRYLICHELPER_LOG", NullDevice);
+#else
+        setenv("WIN32ACRYLICHELPER_LOG", NullDevice, 0);
+#endif
+    }
+
+    SystemLibrary library(LibraryFileName);
+    if (!library.GetSymbol(ExistingSymbol)) {
+        std::fprintf(stderr, "Failed to resolve the symbol of the benchmark, is the library missing?\n");
+        return -1;
+    }
+    SystemLibraryManager &manager = SystemLibraryManager::instance();
+
+    std::printf("%d lookups of every kind:\n", iterations);
+    std::printf("  %-24s %10.1f ns\n", "uncached hit", Measure(iterations, [&]() {
+        return SystemLibrary::GetSymbolNoCache(LibraryFileName, ExistingSymbol);
+    }));
+    std::printf("  %-24s %10.1f ns\n", "cached hit", Measure(iterations, [&]() {
+        return library.GetSymbol(ExistingSymbol);
+    }));
+    std::printf("  %-24s %10.1f ns\n", "cached hit (manager)", Measure(iterations, [&]() {
+        return manager.GetSymbol(LibraryFileName, ExistingSymbol);
+    }));
+
+    // Failures are resolved again every time with "Always", that is what a miss costs
+    // without the negative cache.
+    library.RetryPolicy(SystemLibraryRetryPolicy::Always);
+    std::printf("  %-24s %10.1f ns\n", "uncached miss", Measure(iterations, [&]() {
+        return library.GetSymbol(MissingSymbol);
+    }));
+    library.RetryPolicy(SystemLibraryRetryPolicy::Never);
+    std::printf("  %-24s %10.1f ns\n", "cached miss", Measure(iterations, [&]() {
+        return library.GetSymbol(MissingSymbol);
+    }));
+    manager.RetryPolicy(SystemLibraryRetryPolicy::Never);
+    std::printf("  %-24s %10.1f ns\n", "cached miss (manager)", Measure(iterations, [&]() {
+        return manager.GetSymbol(LibraryFileName, MissingSymbol);
+    }));
+
+    manager.Release();
+    return 0;
+}
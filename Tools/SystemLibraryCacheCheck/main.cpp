@@ -0,0 +1,186 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// Checks the caching of the system library loader ("SystemLibrary.h" and
+// "SystemLibraryManager.h") with the backend of the current platform: a symbol is
+// resolved once and then served from the cache, a missing symbol is remembered as
+// missing, and "Release()" unloads the library and forgets its addresses.
+//
+// Usage: SystemLibraryCacheCheck
+
+#include "SystemLibrary.h"
+#include "SystemLibraryManager.h"
+#include "../Check.hpp"
+#include <cstdlib>
+
+// A library which is loaded into every process anyway, see "SystemLibraryBenchmark".
+#ifdef _WIN32
+static constexpr const char NullDevice[] = "NUL";
+static constexpr const wchar_t LibraryFileName[] = L"kernel32.dll";
+static constexpr const wchar_t ExistingSymbol[] = L"GetTickCount";
+#elif defined(__APPLE__)
+static constexpr const char NullDevice[] = "/dev/null";
+static constexpr const wchar_t LibraryFileName[] = L"/usr/lib/libSystem.B.dylib";
+static constexpr const wchar_t ExistingSymbol[] = L"strlen";
+#else
+static constexpr const char NullDevice[] = "/dev/null";
+static constexpr const wchar_t LibraryFileName[] = L"libc.so.6";
+static constexpr const wchar_t ExistingSymbol[] = L"strlen";
+#endif
+static constexpr const wchar_t MissingSymbol[] = L"Win32AcrylicHelperNoSuchSymbol";
+
+// Forwards to the backend of the current platform and counts what reaches it.
+class CountingSystemLibraryBackend final : public SystemLibraryBackend
+{
+public:
+    explicit CountingSystemLibraryBackend() noexcept = default;
+    ~CountingSystemLibraryBackend() noexcept override = default;
+
+    [[nodiscard]] HMODULE Open(const std::wstring &fileName) noexcept override
+    {
+        ++m_openCount;
+        return m_backend.Open(fileName);
+    }
+
+    [[nodiscard]] bool Close(const HMODULE module) noexcept override
+    {
+        ++m_closeCount;
+        return m_backend.Close(module);
+    }
+
+    [[nodiscard]] FARPROC Resolve(const HMODULE module, const std::wstring &function) noexcept override
+    {
+        ++m_resolveCount;
+        return m_backend.Resolve(module, function);
+    }
+
+    [[nodiscard]] FARPROC ResolveNoCache(const std::wstring &fileName, const std::wstring &function) noexcept override
+    {
+        return m_backend.ResolveNoCache(fileName, function);
+    }
+
+    void Trace(const std::wstring &message) noexcept override
+    {
+        m_backend.Trace(message);
+    }
+
+    [[nodiscard]] int OpenCount() const noexcept
+    {
+        return m_openCount;
+    }
+
+    [[nodiscard]] int CloseCount() const noexcept
+    {
+        return m_closeCount;
+    }
+
+    [[nodiscard]] int ResolveCount() const noexcept
+    {
+        return m_resolveCount;
+    }
+
+private:
+    CountingSystemLibraryBackend(const CountingSystemLibraryBackend &) = delete;
+    CountingSystemLibraryBackend &operator=(const CountingSystemLibraryBackend &) = delete;
+    CountingSystemLibraryBackend(CountingSystemLibraryBackend &&) = delete;
+    CountingSystemLibraryBackend &operator=(CountingSystemLibraryBackend &&) = delete;
+
+private:
+    SystemLibraryBackend &m_backend = SystemLibraryBackend::Default();
+    int m_openCount = 0;
+    int m_closeCount = 0;
+    int m_resolveCount = 0;
+};
+
+static inline void CheckLibrary() noexcept
+{
+    CountingSystemLibraryBackend backend;
+    SystemLibrary library(LibraryFileName, &backend);
+    const FARPROC address = library.GetSymbol(ExistingSymbol);
+    CHECK(address != nullptr);
+    CHECK(address == SystemLibrary::GetSymbolNoCache(LibraryFileName, ExistingSymbol));
+    CHECK(library.Loaded());
+    CHECK(library.GetSymbol(ExistingSymbol) == address);
+    CHECK(library.GetSymbol(ExistingSymbol) == address);
+    CHECK(backend.OpenCount() == 1);
+    CHECK(backend.ResolveCount() == 1);
+
+    // Missing symbols are cached as missing.
+    library.RetryPolicy(SystemLibraryRetryPolicy::Never);
+    CHECK(!library.GetSymbol(MissingSymbol));
+    CHECK(!library.GetSymbol(MissingSymbol));
+    CHECK(backend.ResolveCount() == 2);
+
+    // Unloading closes the library and forgets what was resolved from it.
+    CHECK(library.Load(false));
+    CHECK(!library.Loaded());
+    CHECK(backend.CloseCount() == 1);
+    library.FileName(LibraryFileName);
+    CHECK(library.GetSymbol(ExistingSymbol) == address);
+    CHECK(!library.GetSymbol(MissingSymbol));
+    CHECK(backend.OpenCount() == 2);
+    CHECK(backend.ResolveCount() == 4);
+}
+
+static inline void CheckManager() noexcept
+{
+    static CountingSystemLibraryBackend backend;
+    SystemLibraryManager &manager = SystemLibraryManager::instance();
+    manager.Backend(&backend);
+    manager.RetryPolicy(SystemLibraryRetryPolicy::Never);
+    const FARPROC address = manager.GetSymbol(LibraryFileName, ExistingSymbol);
+    CHECK(address != nullptr);
+    CHECK(manager.GetSymbol(LibraryFileName, ExistingSymbol) == address);
+    CHECK(!manager.GetSymbol(LibraryFileName, MissingSymbol));
+    CHECK(!manager.GetSymbol(LibraryFileName, MissingSymbol));
+    CHECK(backend.OpenCount() == 1);
+    CHECK(backend.ResolveCount() == 2);
+
+    // Every library opened so far is closed, and its addresses are resolved again.
+    manager.Release();
+    CHECK(backend.CloseCount() == backend.OpenCount());
+    CHECK(manager.GetSymbol(LibraryFileName, ExistingSymbol) == address);
+    CHECK(!manager.GetSymbol(LibraryFileName, MissingSymbol));
+    CHECK(backend.OpenCount() == 2);
+    CHECK(backend.ResolveCount() == 4);
+
+    manager.Release();
+    CHECK(backend.CloseCount() == backend.OpenCount());
+    manager.Backend(nullptr);
+}
+
+int main()
+{
+    // Every failed lookup is logged.
+    if (!std::getenv("WIN32ACRYLICHELPER_LOG")) {
+#ifdef _WIN32
+        _putenv_s("WIN32ACRYLICHELPER_LOG", NullDevice);
+#else
+        setenv("WIN32ACRYLICHELPER_LOG", NullDevice, 0);
+#endif
+    }
+    CheckLibrary();
+    CheckManager();
+    return Check::Finish("SystemLibraryCacheCheck");
+}
@@ -0,0 +1,199 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// Checks the retry policies of the system library cache ("SystemLibrary.h") against
+// a "MockSystemLibraryBackend": a library or a symbol which couldn't be found is
+// looked up again only when the policy allows it, "Rescan()" starts a new generation,
+// and a thunk ("WindowsAPICache") resolves a missing address again once after it.
+//
+// Usage: SystemLibraryRetryCheck
+
+#include "SystemLibrary.h"
+#include "SystemLibraryManager.h"
+#include "WindowsAPIThunks.h"
+#include "../Check.hpp"
+#include <cstdlib>
+
+#ifdef _WIN32
+static constexpr const char NullDevice[] = "NUL";
+#else
+static constexpr const char NullDevice[] = "/dev/null";
+#endif
+static constexpr const wchar_t LibraryFileName[] = L"Win32AcrylicHelperMock.dll";
+static constexpr const wchar_t SymbolName[] = L"MockFunction";
+
+static void MockFunction() noexcept
+{
+}
+
+[[nodiscard]] static inline FARPROC MockAddress() noexcept
+{
+    return reinterpret_cast<FARPROC>(&MockFunction);
+}
+
+static inline void CheckNever() noexcept
+{
+    MockSystemLibraryBackend backend;
+    backend.AddLibrary(LibraryFileName);
+    SystemLibrary library(LibraryFileName, &backend);
+    library.RetryPolicy(SystemLibraryRetryPolicy::Never);
+    CHECK(!library.GetSymbol(SymbolName));
+    CHECK(!library.GetSymbol(SymbolName));
+    CHECK(backend.ResolveCount() == 1);
+    // Neither the symbol showing up nor a new generation makes a difference.
+    backend.AddSymbol(LibraryFileName, SymbolName, MockAddress());
+    SystemLibrary::Rescan();
+    CHECK(!library.GetSymbol(SymbolName));
+    CHECK(backend.ResolveCount() == 1);
+    // Only unloading the library does.
+    CHECK(library.Load(false));
+    library.FileName(LibraryFileName);
+    CHECK(library.GetSymbol(SymbolName) == MockAddress());
+    CHECK(backend.ResolveCount() == 2);
+
+    // The same goes for the library itself.
+    MockSystemLibraryBackend missing;
+    SystemLibrary missingLibrary(LibraryFileName, &missing);
+    missingLibrary.RetryPolicy(SystemLibraryRetryPolicy::Never);
+    CHECK(!missingLibrary.GetSymbol(SymbolName));
+    missing.AddLibrary(LibraryFileName);
+    SystemLibrary::Rescan();
+    CHECK(!missingLibrary.ShouldLoad());
+    CHECK(!missingLibrary.GetSymbol(SymbolName));
+    CHECK(missing.OpenCount() == 1);
+}
+
+static inline void CheckAfterRescan() noexcept
+{
+    MockSystemLibraryBackend backend;
+    backend.AddLibrary(LibraryFileName);
+    SystemLibrary library(LibraryFileName, &backend);
+    library.RetryPolicy(SystemLibraryRetryPolicy::AfterRescan);
+    CHECK(!library.GetSymbol(SymbolName));
+    CHECK(!library.GetSymbol(SymbolName));
+    CHECK(backend.ResolveCount() == 1);
+    backend.AddSymbol(LibraryFileName, SymbolName, MockAddress());
+    CHECK(!library.GetSymbol(SymbolName));
+    CHECK(backend.ResolveCount() == 1);
+    const std::uint64_t generation = SystemLibrary::Generation();
+    SystemLibrary::Rescan();
+    CHECK(SystemLibrary::Generation() == (generation + 1));
+    CHECK(library.GetSymbol(SymbolName) == MockAddress());
+    CHECK(backend.ResolveCount() == 2);
+    // Found, that is never looked up again.
+    SystemLibrary::Rescan();
+    CHECK(library.GetSymbol(SymbolName) == MockAddress());
+    CHECK(backend.ResolveCount() == 2);
+
+    // Still missing: once per generation.
+    CHECK(!library.GetSymbol(L"MissingFunction"));
+    CHECK(!library.GetSymbol(L"MissingFunction"));
+    CHECK(backend.ResolveCount() == 3);
+    SystemLibrary::Rescan();
+    CHECK(!library.GetSymbol(L"MissingFunction"));
+    CHECK(!library.GetSymbol(L"MissingFunction"));
+    CHECK(backend.ResolveCount() == 4);
+
+    MockSystemLibraryBackend missing;
+    SystemLibrary missingLibrary(LibraryFileName, &missing);
+    missingLibrary.RetryPolicy(SystemLibraryRetryPolicy::AfterRescan);
+    CHECK(!missingLibrary.GetSymbol(SymbolName));
+    missing.AddSymbol(LibraryFileName, SymbolName, MockAddress());
+    CHECK(!missingLibrary.ShouldLoad());
+    CHECK(!missingLibrary.GetSymbol(SymbolName));
+    CHECK(missing.OpenCount() == 1);
+    SystemLibrary::Rescan();
+    CHECK(missingLibrary.ShouldLoad());
+    CHECK(missingLibrary.GetSymbol(SymbolName) == MockAddress());
+    CHECK(missing.OpenCount() == 2);
+}
+
+static inline void CheckAlways() noexcept
+{
+    MockSystemLibraryBackend backend;
+    backend.AddLibrary(LibraryFileName);
+    SystemLibrary library(LibraryFileName, &backend);
+    library.RetryPolicy(SystemLibraryRetryPolicy::Always);
+    CHECK(!library.GetSymbol(SymbolName));
+    CHECK(!library.GetSymbol(SymbolName));
+    CHECK(!library.GetSymbol(SymbolName));
+    CHECK(backend.ResolveCount() == 3);
+    backend.AddSymbol(LibraryFileName, SymbolName, MockAddress());
+    CHECK(library.GetSymbol(SymbolName) == MockAddress());
+    CHECK(library.GetSymbol(SymbolName) == MockAddress());
+    CHECK(backend.ResolveCount() == 4);
+
+    MockSystemLibraryBackend missing;
+    SystemLibrary missingLibrary(LibraryFileName, &missing);
+    missingLibrary.RetryPolicy(SystemLibraryRetryPolicy::Always);
+    CHECK(!missingLibrary.GetSymbol(SymbolName));
+    CHECK(!missingLibrary.GetSymbol(SymbolName));
+    CHECK(missing.OpenCount() == 2);
+}
+
+static inline void CheckWindowsAPICache() noexcept
+{
+    using Function = void (*)() noexcept;
+    static MockSystemLibraryBackend backend;
+    SystemLibraryManager &manager = SystemLibraryManager::instance();
+    manager.Backend(&backend);
+    manager.RetryPolicy(SystemLibraryRetryPolicy::AfterRescan);
+    backend.AddLibrary(LibraryFileName);
+
+    WindowsAPICache<Function> cache(LibraryFileName, SymbolName);
+    CHECK(backend.ResolveCount() == 1);
+    CHECK(!cache.Get());
+    CHECK(!cache.Get());
+    CHECK(backend.ResolveCount() == 1);
+    backend.AddSymbol(LibraryFileName, SymbolName, MockAddress());
+    CHECK(!cache.Get());
+    CHECK(backend.ResolveCount() == 1);
+    manager.Rescan();
+    CHECK(cache.Get() == &MockFunction);
+    CHECK(backend.ResolveCount() == 2);
+    CHECK(cache.Get() == &MockFunction);
+    manager.Rescan();
+    CHECK(cache.Get() == &MockFunction);
+    CHECK(backend.ResolveCount() == 2);
+
+    manager.Release();
+    manager.Backend(nullptr);
+}
+
+int main()
+{
+    // Every failed lookup is logged.
+    if (!std::getenv("WIN32ACRYLICHELPER_LOG")) {
+#ifdef _WIN32
+        _putenv_s("WIN32ACRYLICHELPER_LOG", NullDevice);
+#else
+        setenv("WIN32ACRYLICHELPER_LOG", NullDevice, 0);
+#endif
+    }
+    CheckNever();
+    CheckAfterRescan();
+    CheckAlways();
+    CheckWindowsAPICache();
+    return Check::Finish("SystemLibraryRetryCheck");
+}
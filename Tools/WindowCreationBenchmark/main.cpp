@@ -0,0 +1,128 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// Creates and closes top-level windows ("Window.h") with a child window each, the
+// way the demo applications do, and measures how long it takes. It also reports how
+// many window classes they went through: the class registry ("WindowClassRegistry.h")
+// shares one class between all windows with the same class key, so this must not
+// grow with the window count, and all of them must be gone once the windows are.
+//
+// Usage: WindowCreationBenchmark [windows]
+//
+// Prints the average cost of creating and closing a single top-level window (with
+// its child window), in microseconds. The log goes to the null device unless
+// "WIN32ACRYLICHELPER_LOG" names a file already.
+
+#include "Window.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <utility>
+#include <vector>
+
+// A window class seen during the benchmark.
+struct WindowClassAtom
+{
+    ATOM Atom = INVALID_ATOM;
+    HINSTANCE Instance = nullptr;
+};
+
+static inline void RecordWindowClass(const HWND hWnd, std::vector<WindowClassAtom> &classes) noexcept
+{
+    const auto atom = static_cast<ATOM>(GetClassLongPtrW(hWnd, GCW_ATOM));
+    if (atom == INVALID_ATOM) {
+        return;
+    }
+    for (auto &&windowClass : std::as_const(classes)) {
+        if (windowClass.Atom == atom) {
+            return;
+        }
+    }
+    classes.push_back({atom, reinterpret_cast<HINSTANCE>(GetWindowLongPtrW(hWnd, GWLP_HINSTANCE))});
+}
+
+// The windows post a few messages to themselves, don't let them pile up.
+static inline void ProcessPendingMessages() noexcept
+{
+    MSG msg = {};
+    while (PeekMessageW(&msg, nullptr, 0, 0, PM_REMOVE) != FALSE) {
+        TranslateMessage(&msg);
+        DispatchMessageW(&msg);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc > 2) {
+        std::fprintf(stderr, "Usage: %s [windows]\n", argv[0]);
+        return -1;
+    }
+    int windows = 1000;
+    if (argc == 2) {
+        windows = std::atoi(argv[1]);
+        if (windows <= 0) {
+            std::fprintf(stderr, "Invalid window count \"%s\".\n", argv[1]);
+            return -1;
+        }
+    }
+
+    if (!std::getenv("WIN32ACRYLICHELPER_LOG")) {
+        _putenv_s("WIN32ACRYLICHELPER_LOG", "NUL");
+    }
+
+    std::vector<WindowClassAtom> classes = {};
+    const auto start = std::chrono::steady_clock::now();
+    for (int index = 0; index < windows; ++index) {
+        {
+            const auto window = std::make_unique<Window>(0);
+            const HWND child = window->CreateChildWindow(0, 0, DefWindowProcW, nullptr, 0);
+            if (!child) {
+                std::fprintf(stderr, "Failed to create the child window.\n");
+                return -1;
+            }
+            RecordWindowClass(window->WindowHandle(), classes);
+            RecordWindowClass(child, classes);
+        }
+        ProcessPendingMessages();
+    }
+    const auto finish = std::chrono::steady_clock::now();
+
+    int leaked = 0;
+    for (auto &&windowClass : std::as_const(classes)) {
+        WNDCLASSEXW wcex = {};
+        wcex.cbSize = sizeof(wcex);
+        if (GetClassInfoExW(windowClass.Instance, MAKEINTATOM(windowClass.Atom), &wcex) != FALSE) {
+            ++leaked;
+        }
+    }
+
+    const double elapsed = static_cast<double>(std::chrono::duration_cast<std::chrono::microseconds>(finish - start).count());
+    std::printf("%d top-level windows, each with a child window:\n", windows);
+    std::printf("  %-24s %10.1f ms\n", "total", (elapsed / 1000.0));
+    std::printf("  %-24s %10.1f us\n", "per window", (elapsed / static_cast<double>(windows)));
+    std::printf("  %-24s %10zu\n", "window classes", classes.size());
+    std::printf("  %-24s %10d\n", "still registered", leaked);
+    return ((leaked == 0) ? 0 : -1);
+}
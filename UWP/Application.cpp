@@ -26,6 +26,8 @@
 #include "Application.h"
 #include "MainWindow.h"
 #include "WindowsVersion.h"
+#include "SystemLibraryManager.h"
+#include "Profiler.h"
 #include "Utils.h"
 #include "OperationResult.h"
 
@@ -54,12 +56,12 @@ private:
 ApplicationPrivate::ApplicationPrivate(Application *q) noexcept
 {
     if (!q) {
-        Utils::DisplayErrorDialog(L"ApplicationPrivate's q is null.");
+        Utils::DisplayErrorDialog(L"ApplicationPrivate's q is null.", ErrorSeverity::Fatal);
         std::exit(-1);
     }
     q_ptr = q;
     if (!Initialize()) {
-        Utils::DisplayErrorDialog(L"Failed to initialize the UWP application.");
+        Utils::DisplayErrorDialog(L"Failed to initialize the UWP application.", ErrorSeverity::Fatal);
         std::exit(-1);
     }
 }
@@ -77,6 +79,7 @@ ApplicationPrivate::~ApplicationPrivate() noexcept
 
 bool ApplicationPrivate::Initialize() noexcept
 {
+    PROFILE_SCOPE(L"ApplicationPrivate::Initialize")
     const VersionNumber &curOsVer = WindowsVersion::CurrentVersion();
     const std::wstring osVerDbgMsg = std::wstring(L"Current operating system version: ") + WindowsVersion::ToHumanReadableString(curOsVer) + L'\n';
     OutputDebugStringW(osVerDbgMsg.c_str());
@@ -90,6 +93,7 @@ bool ApplicationPrivate::Initialize() noexcept
         m_comInitialized = true;
     }
     if (m_xamlManager == nullptr) {
+        PROFILE_SCOPE(L"WindowsXamlManager::InitializeForCurrentThread")
         // Initialize the XAML framework's core window for the current thread.
         m_xamlManager = winrt::Windows::UI::Xaml::Hosting::WindowsXamlManager::InitializeForCurrentThread();
         if (m_xamlManager == nullptr) {
@@ -110,6 +114,9 @@ bool ApplicationPrivate::Initialize() noexcept
     const ProcessDPIAwareness curPcDPIAwareness = Utils::GetProcessDPIAwareness();
     const std::wstring curPcDPIAwarenessDbgMsg = std::wstring(L"Current process's DPI awareness: ") + Utils::DPIAwarenessToString(curPcDPIAwareness) + L'\n';
     OutputDebugStringW(curPcDPIAwarenessDbgMsg.c_str());
+    // Map the libraries the window needs in parallel instead of one by one during its creation.
+    // Only a hint, anything not preloaded will still be loaded on demand.
+    [[maybe_unused]] const bool windowPreloaded = SystemLibraryManager::instance().Preload(SystemLibraryGroups::Window, true);
     m_window = std::make_unique<MainWindow>();
     m_window->StartupLocation(WindowStartupLocation::ScreenCenter);
     m_window->Visibility(WindowState::Windowed);
@@ -120,11 +127,11 @@ bool ApplicationPrivate::Initialize() noexcept
 int ApplicationPrivate::Run() const noexcept
 {
     if (!q_ptr) {
-        Utils::DisplayErrorDialog(L"Can't run the UWP application due to the q_ptr is null.");
+        Utils::DisplayErrorDialog(L"Can't run the UWP application due to the q_ptr is null.", ErrorSeverity::Fatal);
         return -1;
     }
     if (!m_window) {
-        Utils::DisplayErrorDialog(L"Can't run the UWP application due to the main window has not been created yet.");
+        Utils::DisplayErrorDialog(L"Can't run the UWP application due to the main window has not been created yet.", ErrorSeverity::Fatal);
         return -1;
     }
     return MainWindow::MessageLoop();
@@ -26,6 +26,7 @@
 #include "MainWindow.h"
 #include "OperationResult.h"
 #include "Utils.h"
+#include "Profiler.h"
 
 namespace Constants {
 namespace Light {
@@ -110,24 +111,26 @@ private:
 MainWindowPrivate::MainWindowPrivate(MainWindow *q) noexcept
 {
     if (!q) {
-        Utils::DisplayErrorDialog(L"MainWindowPrivate's q is null.");
+        Utils::DisplayErrorDialog(L"MainWindowPrivate's q is null.", ErrorSeverity::Fatal);
         std::exit(-1);
     }
     q_ptr = q;
     if (InitializeXamlIsland()) {
         if (InitializeDragBarWindow()) {
-            q_ptr->CustomMessageHandler(std::bind(&MainWindowPrivate::MainWindowMessageHandler, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4));
+            const auto handler = std::bind(&MainWindowPrivate::MainWindowMessageHandler, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4);
+            [[maybe_unused]] const auto setFocusId = q_ptr->SubscribeMessage(WM_SETFOCUS, handler);
+            [[maybe_unused]] const auto setCursorId = q_ptr->SubscribeMessage(WM_SETCURSOR, handler);
             q_ptr->WindowMessageFilter(std::bind(&MainWindowPrivate::MainWindowMessageFilter, this, std::placeholders::_1));
             q_ptr->WidthChangeHandler(std::bind(&MainWindowPrivate::OnWidthChanged, this, std::placeholders::_1));
             q_ptr->HeightChangeHandler(std::bind(&MainWindowPrivate::OnHeightChanged, this, std::placeholders::_1));
             q_ptr->VisibilityChangeHandler(std::bind(&MainWindowPrivate::OnVisibilityChanged, this, std::placeholders::_1));
             q_ptr->ThemeChangeHandler(std::bind(&MainWindowPrivate::OnThemeChanged, this, std::placeholders::_1));
         } else {
-            Utils::DisplayErrorDialog(L"Failed to initialize the drag bar window.");
+            Utils::DisplayErrorDialog(L"Failed to initialize the drag bar window.", ErrorSeverity::Fatal);
             std::exit(-1);
         }
     } else {
-        Utils::DisplayErrorDialog(L"Failed to initialize the XAML Island.");
+        Utils::DisplayErrorDialog(L"Failed to initialize the XAML Island.", ErrorSeverity::Fatal);
         std::exit(-1);
     }
 }
@@ -283,6 +286,7 @@ bool MainWindowPrivate::DragBarMessageHandler(const UINT message, const WPARAM w
 
 bool MainWindowPrivate::InitializeXamlIsland() noexcept
 {
+    PROFILE_SCOPE(L"MainWindowPrivate::InitializeXamlIsland")
     if (!q_ptr) {
         Utils::DisplayErrorDialog(L"Can't initialize the XAML Island due to the q_ptr is null.");
         return false;
@@ -26,6 +26,8 @@
 #include "MainWindow.h"
 #include "Utils.h"
 #include "WindowsVersion.h"
+#include "SystemLibraryManager.h"
+#include "Profiler.h"
 
 class ApplicationPrivate
 {
@@ -50,12 +52,12 @@ private:
 ApplicationPrivate::ApplicationPrivate(Application *q) noexcept
 {
     if (!q) {
-        Utils::DisplayErrorDialog(L"ApplicationPrivate's q is null.");
+        Utils::DisplayErrorDialog(L"ApplicationPrivate's q is null.", ErrorSeverity::Fatal);
         std::exit(-1);
     }
     q_ptr = q;
     if (!Initialize()) {
-        Utils::DisplayErrorDialog(L"Failed to initialize the Win32 application.");
+        Utils::DisplayErrorDialog(L"Failed to initialize the Win32 application.", ErrorSeverity::Fatal);
         std::exit(-1);
     }
 }
@@ -64,6 +66,7 @@ ApplicationPrivate::~ApplicationPrivate() noexcept = default;
 
 bool ApplicationPrivate::Initialize() noexcept
 {
+    PROFILE_SCOPE(L"ApplicationPrivate::Initialize")
     const VersionNumber &curOsVer = WindowsVersion::CurrentVersion();
     const std::wstring osVerDbgMsg = std::wstring(L"Current operating system version: ") + WindowsVersion::ToHumanReadableString(curOsVer) + L'\n';
     OutputDebugStringW(osVerDbgMsg.c_str());
@@ -86,6 +89,9 @@ bool ApplicationPrivate::Initialize() noexcept
     const ProcessDPIAwareness curPcDPIAwareness = Utils::GetProcessDPIAwareness();
     const std::wstring curPcDPIAwarenessDbgMsg = std::wstring(L"Current process's DPI awareness: ") + Utils::DPIAwarenessToString(curPcDPIAwareness) + L'\n';
     OutputDebugStringW(curPcDPIAwarenessDbgMsg.c_str());
+    // Map the libraries the window needs in parallel instead of one by one during its creation.
+    // Only a hint, anything not preloaded will still be loaded on demand.
+    [[maybe_unused]] const bool windowPreloaded = SystemLibraryManager::instance().Preload(SystemLibraryGroups::Window, true);
     m_window = std::make_unique<MainWindow>();
     m_window->FrameBorderVisible(false);
     m_window->StartupLocation(WindowStartupLocation::ScreenCenter);
@@ -97,11 +103,11 @@ bool ApplicationPrivate::Initialize() noexcept
 int ApplicationPrivate::Run() const noexcept
 {
     if (!q_ptr) {
-        Utils::DisplayErrorDialog(L"Can't run the Win32 application due to the q_ptr is null.");
+        Utils::DisplayErrorDialog(L"Can't run the Win32 application due to the q_ptr is null.", ErrorSeverity::Fatal);
         return -1;
     }
     if (!m_window) {
-        Utils::DisplayErrorDialog(L"Can't run the Win32 application due to the main window has not been created yet.");
+        Utils::DisplayErrorDialog(L"Can't run the Win32 application due to the main window has not been created yet.", ErrorSeverity::Fatal);
         return -1;
     }
     return MainWindow::MessageLoop();
@@ -61,7 +61,7 @@ private:
 MainWindowPrivate::MainWindowPrivate(MainWindow *q) noexcept
 {
     if (!q) {
-        Utils::DisplayErrorDialog(L"MainWindowPrivate's q is null.");
+        Utils::DisplayErrorDialog(L"MainWindowPrivate's q is null.", ErrorSeverity::Fatal);
         std::exit(-1);
     }
     q_ptr = q;
@@ -77,10 +77,14 @@ MainWindowPrivate::MainWindowPrivate(MainWindow *q) noexcept
             static constexpr const VersionNumber goodVersionStart = VersionNumber(10, 0, 16190);
             m_isAPIWorkingWell = ((curOsVer >= WindowsVersion::Windows11_21H2) || ((curOsVer >= goodVersionStart) && (curOsVer < WindowsVersion::Windows10_1803)));
         }
-        q_ptr->CustomMessageHandler(std::bind(&MainWindowPrivate::MainWindowMessageHandler, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4));
+        if (!m_isAPIWorkingWell) {
+            const auto handler = std::bind(&MainWindowPrivate::MainWindowMessageHandler, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4);
+            [[maybe_unused]] const auto enterSizeMoveId = q_ptr->SubscribeMessage(WM_ENTERSIZEMOVE, handler);
+            [[maybe_unused]] const auto exitSizeMoveId = q_ptr->SubscribeMessage(WM_EXITSIZEMOVE, handler);
+        }
         q_ptr->ThemeChangeHandler(std::bind(&MainWindowPrivate::OnThemeChanged, this, std::placeholders::_1));
     } else {
-        Utils::DisplayErrorDialog(L"Failed to initialize MainWindowPrivate.");
+        Utils::DisplayErrorDialog(L"Failed to initialize MainWindowPrivate.", ErrorSeverity::Fatal);
         std::exit(-1);
     }
 }
@@ -137,9 +141,6 @@ bool MainWindowPrivate::MainWindowMessageHandler(const UINT message, const WPARA
     UNREFERENCED_PARAMETER(wParam);
     UNREFERENCED_PARAMETER(lParam);
     UNREFERENCED_PARAMETER(result);
-    if (m_isAPIWorkingWell) {
-        return false;
-    }
     switch (message) {
     case WM_ENTERSIZEMOVE: {
         // The window will be super laggy during move and resize, we workaround this by
@@ -147,3 +147,26 @@ enum class WindowStartupLocation : int
     DesktopCenter, // take the task bar into account
     ScreenCenter // regardless of the task bar
 };
+
+// The statistics and traces written at exit, see "Utils::WriteReport()".
+enum class ReportFormat : int
+{
+    CSV = 0,
+    JSON
+};
+
+// The position and the client area size of a window, as reported by "WM_MOVE" and "WM_SIZE".
+struct WindowGeometry
+{
+    int X = 0;
+    int Y = 0;
+    UINT Width = 0;
+    UINT Height = 0;
+
+    [[nodiscard]] inline constexpr friend bool operator==(const WindowGeometry &lhs, const WindowGeometry &rhs) noexcept {
+        return ((lhs.X == rhs.X) && (lhs.Y == rhs.Y) && (lhs.Width == rhs.Width) && (lhs.Height == rhs.Height));
+    }
+    [[nodiscard]] inline constexpr friend bool operator!=(const WindowGeometry &lhs, const WindowGeometry &rhs) noexcept {
+        return !(lhs == rhs);
+    }
+};
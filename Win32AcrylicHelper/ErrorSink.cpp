@@ -0,0 +1,331 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "ErrorSink.h"
+#include <array>
+#include <cstdint>
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <algorithm>
+#include <cstdlib>
+#include <utility>
+
+// Longer texts are truncated, the queue must not allocate.
+static constexpr const std::size_t MaximumTextLength = 512;
+// Must be a power of two.
+static constexpr const std::size_t QueueCapacity = 128;
+// The same text is written at most once per interval, the repeats are counted.
+static constexpr const ULONGLONG RepeatInterval = 1000;
+static constexpr const std::size_t MaximumTrackedTexts = 256;
+// How many of the previous errors are shown together with a fatal one.
+static constexpr const std::size_t RecentErrorCount = 8;
+
+static_assert((QueueCapacity & (QueueCapacity - 1)) == 0);
+
+struct ErrorRecord
+{
+    ErrorSeverity Severity = ErrorSeverity::Error;
+    std::size_t Length = 0;
+    std::array<wchar_t, MaximumTextLength> Text = {};
+};
+
+struct ErrorRepeat
+{
+    ULONGLONG LastWritten = 0;
+    std::uint64_t Suppressed = 0;
+};
+
+class AsyncErrorSink final : public ErrorSink
+{
+public:
+    explicit AsyncErrorSink() noexcept;
+    ~AsyncErrorSink() noexcept override;
+
+    void Report(const ErrorSeverity severity, const std::wstring &text) noexcept override;
+    void Flush() noexcept override;
+    // Writes everything reported so far and stops the drain thread. Everything
+    // reported afterwards is written right away by the reporting thread.
+    void Shutdown() noexcept;
+
+private:
+    AsyncErrorSink(const AsyncErrorSink &) = delete;
+    AsyncErrorSink &operator=(const AsyncErrorSink &) = delete;
+    AsyncErrorSink(AsyncErrorSink &&) = delete;
+    AsyncErrorSink &operator=(AsyncErrorSink &&) = delete;
+
+private:
+    // Multiple producers, the consumer side is serialized by "m_drainMutex".
+    [[nodiscard]] bool Enqueue(const ErrorSeverity severity, const std::wstring &text) noexcept;
+    [[nodiscard]] bool Dequeue(ErrorRecord &record) noexcept;
+    void Drain() noexcept;
+    void Write(const ErrorRecord &record) noexcept;
+    void WriteSuppressed() noexcept;
+    void ThreadMain() noexcept;
+    void EnsureThread() noexcept;
+
+private:
+    struct Slot
+    {
+        std::atomic<std::size_t> Sequence = 0;
+        ErrorRecord Record = {};
+    };
+    std::array<Slot, QueueCapacity> m_slots = {};
+    std::atomic<std::size_t> m_enqueuePosition = 0;
+    std::size_t m_dequeuePosition = 0;
+    std::atomic<std::uint64_t> m_dropped = 0;
+    std::atomic<std::uint32_t> m_signal = 0;
+    std::atomic<bool> m_stop = false;
+    std::once_flag m_threadOnce = {};
+    std::thread m_thread = {};
+    std::mutex m_drainMutex = {};
+    // Only touched with "m_drainMutex" held.
+    std::unordered_map<std::wstring, ErrorRepeat> m_repeats = {};
+    std::deque<std::wstring> m_recent = {};
+    std::mutex m_fatalMutex = {};
+};
+
+static std::atomic<ErrorSink *> g_currentSink = nullptr;
+
+AsyncErrorSink::AsyncErrorSink() noexcept
+{
+    // A slot is free for the producer which reaches position N when its sequence is N.
+    for (std::size_t index = 0; index != QueueCapacity; ++index) {
+        m_slots[index].Sequence.store(index, std::memory_order_relaxed);
+    }
+}
+
+AsyncErrorSink::~AsyncErrorSink() noexcept
+{
+    m_stop.store(true, std::memory_order_release);
+    m_signal.fetch_add(1, std::memory_order_release);
+    m_signal.notify_one();
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+    Flush();
+    const std::scoped_lock lock(m_drainMutex);
+    WriteSuppressed();
+}
+
+bool AsyncErrorSink::Enqueue(const ErrorSeverity severity, const std::wstring &text) noexcept
+{
+    std::size_t position = m_enqueuePosition.load(std::memory_order_relaxed);
+    Slot *slot = nullptr;
+    while (true) {
+        slot = &m_slots[position & (QueueCapacity - 1)];
+        const std::size_t sequence = slot->Sequence.load(std::memory_order_acquire);
+        const auto difference = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+        if (difference == 0) {
+            if (m_enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (difference < 0) {
+            // Full. Losing a record is better than blocking a message handler.
+            return false;
+        } else {
+            position = m_enqueuePosition.load(std::memory_order_relaxed);
+        }
+    }
+    ErrorRecord &record = slot->Record;
+    record.Severity = severity;
+    record.Length = std::min(text.size(), MaximumTextLength);
+    std::copy_n(text.cbegin(), record.Length, record.Text.begin());
+    slot->Sequence.store(position + 1, std::memory_order_release);
+    return true;
+}
+
+bool AsyncErrorSink::Dequeue(ErrorRecord &record) noexcept
+{
+    Slot &slot = m_slots[m_dequeuePosition & (QueueCapacity - 1)];
+    if (slot.Sequence.load(std::memory_order_acquire) != (m_dequeuePosition + 1)) {
+        return false;
+    }
+    record = slot.Record;
+    slot.Sequence.store(m_dequeuePosition + QueueCapacity, std::memory_order_release);
+    ++m_dequeuePosition;
+    return true;
+}
+
+void AsyncErrorSink::Write(const ErrorRecord &record) noexcept
+{
+    const std::wstring text(record.Text.data(), record.Length);
+    const auto recent = std::find(m_recent.cbegin(), m_recent.cend(), text);
+    if (recent != m_recent.cend()) {
+        m_recent.erase(recent);
+    } else if (m_recent.size() >= RecentErrorCount) {
+        m_recent.pop_front();
+    }
+    m_recent.push_back(text);
+    const ULONGLONG now = GetTickCount64();
+    if (m_repeats.size() >= MaximumTrackedTexts) {
+        WriteSuppressed();
+    }
+    const auto search = m_repeats.find(text);
+    std::wstring output = text;
+    if (search != m_repeats.cend()) {
+        ErrorRepeat &repeat = search->second;
+        if ((now - repeat.LastWritten) < RepeatInterval) {
+            ++repeat.Suppressed;
+            return;
+        }
+        if (repeat.Suppressed > 0) {
+            output += std::wstring(L" (repeated ") + std::to_wstring(repeat.Suppressed) + std::wstring(L" more times)");
+        }
+        repeat.LastWritten = now;
+        repeat.Suppressed = 0;
+    } else {
+        m_repeats.insert({text, ErrorRepeat{now, 0}});
+    }
+    output += L'\n';
+    OutputDebugStringW(output.c_str());
+}
+
+void AsyncErrorSink::WriteSuppressed() noexcept
+{
+    for (auto &&repeat : std::as_const(m_repeats)) {
+        if (repeat.second.Suppressed > 0) {
+            const std::wstring output = repeat.first + std::wstring(L" (repeated ") + std::to_wstring(repeat.second.Suppressed) + std::wstring(L" more times)\n");
+            OutputDebugStringW(output.c_str());
+        }
+    }
+    m_repeats = {};
+}
+
+void AsyncErrorSink::Drain() noexcept
+{
+    const std::scoped_lock lock(m_drainMutex);
+    ErrorRecord record = {};
+    while (Dequeue(record)) {
+        Write(record);
+    }
+    const std::uint64_t dropped = m_dropped.exchange(0, std::memory_order_relaxed);
+    if (dropped > 0) {
+        const std::wstring output = std::to_wstring(dropped) + std::wstring(L" error messages were dropped because the error queue was full.\n");
+        OutputDebugStringW(output.c_str());
+    }
+}
+
+void AsyncErrorSink::ThreadMain() noexcept
+{
+    std::uint32_t signal = m_signal.load(std::memory_order_acquire);
+    while (!m_stop.load(std::memory_order_acquire)) {
+        Drain();
+        m_signal.wait(signal, std::memory_order_acquire);
+        signal = m_signal.load(std::memory_order_acquire);
+    }
+}
+
+void AsyncErrorSink::EnsureThread() noexcept
+{
+    std::call_once(m_threadOnce, [this](){
+        m_thread = std::thread([this](){
+            ThreadMain();
+        });
+    });
+}
+
+void AsyncErrorSink::Report(const ErrorSeverity severity, const std::wstring &text) noexcept
+{
+    if (text.empty()) {
+        return;
+    }
+    if (severity != ErrorSeverity::Fatal) {
+        const bool stopped = m_stop.load(std::memory_order_acquire);
+        if (!stopped) {
+            EnsureThread();
+        }
+        if (!Enqueue(severity, text)) {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+        if (stopped) {
+            // Nobody else is going to write it any more.
+            Drain();
+            return;
+        }
+        m_signal.fetch_add(1, std::memory_order_release);
+        m_signal.notify_one();
+        return;
+    }
+    // Fatal errors are rare and the application is about to go away, so handle them
+    // right here and let the user know what happened before.
+    Flush();
+    std::wstring dialogText = text;
+    {
+        const std::scoped_lock lock(m_drainMutex);
+        if (!m_recent.empty()) {
+            dialogText += std::wstring(L"\n\nPrevious errors:");
+            for (auto &&recent : std::as_const(m_recent)) {
+                dialogText += std::wstring(L"\n") + recent;
+            }
+        }
+    }
+    const std::wstring textWithNewLine = text + L'\n';
+    OutputDebugStringW(textWithNewLine.c_str());
+    // Don't stack several message boxes on top of each other.
+    const std::scoped_lock lock(m_fatalMutex);
+    MessageBoxW(nullptr, dialogText.c_str(), L"Error", MB_ICONERROR | MB_OK);
+}
+
+void AsyncErrorSink::Flush() noexcept
+{
+    Drain();
+}
+
+void AsyncErrorSink::Shutdown() noexcept
+{
+    m_stop.store(true, std::memory_order_release);
+    m_signal.fetch_add(1, std::memory_order_release);
+    m_signal.notify_one();
+    Flush();
+    const std::scoped_lock lock(m_drainMutex);
+    WriteSuppressed();
+}
+
+ErrorSink &ErrorSink::Default() noexcept
+{
+    // Leaked on purpose, like the log and the message trace outputs: windows and
+    // exiting threads may still report errors during the static destruction.
+    static AsyncErrorSink * const sink = new AsyncErrorSink;
+    [[maybe_unused]] static const bool shutdownRegistered = (std::atexit([](){
+        sink->Shutdown();
+    }) == 0);
+    return *sink;
+}
+
+ErrorSink &ErrorSink::Current() noexcept
+{
+    ErrorSink * const sink = g_currentSink.load(std::memory_order_acquire);
+    return (sink ? *sink : Default());
+}
+
+void ErrorSink::Install(ErrorSink *sink) noexcept
+{
+    ErrorSink &previous = Current();
+    g_currentSink.store(sink, std::memory_order_release);
+    // Don't lose what has been reported to the previous sink.
+    previous.Flush();
+}
@@ -0,0 +1,64 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <SDKDDKVer.h>
+#include <Windows.h>
+#include <string>
+
+enum class ErrorSeverity : int
+{
+    Warning = 0,
+    Error = 1,
+    Fatal = 2 // The application can't continue, the user should be told.
+};
+
+// Receives everything reported through "Utils::DisplayErrorDialog()". Reporting may
+// happen from any thread, including the message handlers of the windows.
+class ErrorSink
+{
+public:
+    explicit ErrorSink() noexcept = default;
+    virtual ~ErrorSink() noexcept = default;
+
+    virtual void Report(const ErrorSeverity severity, const std::wstring &text) noexcept = 0;
+    // Returns when everything reported so far has been handled.
+    virtual void Flush() noexcept = 0;
+
+    // The default sink never blocks the reporting thread for non-fatal errors: the
+    // records go through a lock-free queue to a background thread, which writes them
+    // to the debugger output with repeats folded together. Only fatal errors show a
+    // message box, together with the last few errors which led to them.
+    [[nodiscard]] static ErrorSink &Default() noexcept;
+    [[nodiscard]] static ErrorSink &Current() noexcept;
+    // Null restores the default sink. The given sink must outlive its installation.
+    static void Install(ErrorSink *sink) noexcept;
+
+private:
+    ErrorSink(const ErrorSink &) = delete;
+    ErrorSink &operator=(const ErrorSink &) = delete;
+    ErrorSink(ErrorSink &&) = delete;
+    ErrorSink &operator=(ErrorSink &&) = delete;
+};
@@ -0,0 +1,312 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "EventLoop.h"
+#include "OperationResult.h"
+#include <algorithm>
+#include <limits>
+
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION (0x00000002)
+#endif // CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+
+static thread_local EventLoop *t_currentLoop = nullptr;
+
+EventLoop::EventLoop() noexcept
+{
+    m_wakeEvent = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+    if (!m_wakeEvent) {
+        PRINT_WIN32_ERROR_MESSAGE(CreateEventW, L"Failed to create the wake up event of the event loop.")
+    }
+    // See "FrameClock_Win32.cpp" for the reason of the fallback.
+    m_timer = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+    if (!m_timer) {
+        m_timer = CreateWaitableTimerExW(nullptr, nullptr, 0, TIMER_ALL_ACCESS);
+        if (!m_timer) {
+            PRINT_WIN32_ERROR_MESSAGE(CreateWaitableTimerExW, L"Failed to create the waitable timer of the event loop.")
+        }
+    }
+}
+
+EventLoop::~EventLoop() noexcept
+{
+    TaskNode *node = m_tasks.exchange(nullptr, std::memory_order_acquire);
+    while (node) {
+        TaskNode *next = node->Next;
+        delete node;
+        node = next;
+    }
+    if (m_timer) {
+        if (CloseHandle(m_timer) == FALSE) {
+            PRINT_WIN32_ERROR_MESSAGE(CloseHandle, L"Failed to close the waitable timer of the event loop.")
+        }
+        m_timer = nullptr;
+    }
+    if (m_wakeEvent) {
+        if (CloseHandle(m_wakeEvent) == FALSE) {
+            PRINT_WIN32_ERROR_MESSAGE(CloseHandle, L"Failed to close the wake up event of the event loop.")
+        }
+        m_wakeEvent = nullptr;
+    }
+}
+
+bool EventLoop::Post(const EventLoopTask &task) noexcept
+{
+    if (!task) {
+        return false;
+    }
+    const auto node = new (std::nothrow) TaskNode;
+    if (!node) {
+        return false;
+    }
+    node->Task = task;
+    TaskNode *head = m_tasks.load(std::memory_order_relaxed);
+    do {
+        node->Next = head;
+    } while (!m_tasks.compare_exchange_weak(head, node, std::memory_order_release, std::memory_order_relaxed));
+    // Only the first task of a batch has to wake the loop up, the others
+    // are picked up together with it.
+    if (!head && m_wakeEvent) {
+        if (SetEvent(m_wakeEvent) == FALSE) {
+            PRINT_WIN32_ERROR_MESSAGE(SetEvent, L"Failed to wake up the event loop.")
+        }
+    }
+    return true;
+}
+
+void EventLoop::Quit(const int exitCode) noexcept
+{
+    // From the loop thread itself, this could simply be "PostQuitMessage()",
+    // but other threads have to go through the task queue anyway.
+    if (!Post([exitCode](){ PostQuitMessage(exitCode); })) {
+        LOG_ERROR(L"Failed to ask the event loop to quit.");
+    }
+}
+
+std::uint32_t EventLoop::StartTimer(const UINT interval, const EventLoopTimerType type, const EventLoopTimerCallback &cb) noexcept
+{
+    if (!cb) {
+        return 0;
+    }
+    ++m_lastTimerId;
+    if (m_lastTimerId == 0) {
+        ++m_lastTimerId;
+    }
+    FrameClock &clock = FrameClock::Default();
+    Timer timer = {};
+    timer.Id = m_lastTimerId;
+    timer.Type = type;
+    timer.Interval = std::max(std::int64_t(1), ((static_cast<std::int64_t>(interval) * clock.Frequency()) / 1000));
+    timer.Deadline = (clock.Now() + timer.Interval);
+    timer.Callback = cb;
+    (m_firingTimers ? m_pendingTimers : m_timers).push_back(std::move(timer));
+    return m_lastTimerId;
+}
+
+void EventLoop::StopTimer(const std::uint32_t id) noexcept
+{
+    if (id == 0) {
+        return;
+    }
+    const auto match = [id](const Timer &timer){ return (timer.Id == id); };
+    if (std::erase_if(m_pendingTimers, match) > 0) {
+        return;
+    }
+    if (m_firingTimers) {
+        // The timer may be running right now, only mark it.
+        const auto it = std::find_if(m_timers.begin(), m_timers.end(), match);
+        if (it != m_timers.end()) {
+            it->Id = 0;
+            m_timersDirty = true;
+        }
+    } else {
+        std::erase_if(m_timers, match);
+    }
+}
+
+EventLoopFrameSignal &EventLoop::Frame() noexcept
+{
+    return m_frame;
+}
+
+void EventLoop::MessageFilter(const EventLoopMessageFilter &cb) noexcept
+{
+    m_messageFilter = cb;
+}
+
+int EventLoop::Run() noexcept
+{
+    EventLoop * const previousLoop = t_currentLoop;
+    t_currentLoop = this;
+    FrameClock &clock = FrameClock::Default();
+    MSG msg = {};
+    while (true) {
+        for (UINT i = 0; (i != MessageBatchSize) && (PeekMessageW(&msg, nullptr, 0, 0, PM_REMOVE) != FALSE); ++i) {
+            if (msg.message == WM_QUIT) {
+                t_currentLoop = previousLoop;
+                return static_cast<int>(msg.wParam);
+            }
+            if (!(m_messageFilter && m_messageFilter(&msg))) {
+                TranslateMessage(&msg);
+                DispatchMessageW(&msg);
+            }
+        }
+        RunTasks();
+        const std::int64_t now = clock.Now();
+        FireTimers(now);
+        EmitFrame(now);
+        Wait();
+    }
+}
+
+EventLoop *EventLoop::Current() noexcept
+{
+    return t_currentLoop;
+}
+
+void EventLoop::RunTasks() noexcept
+{
+    TaskNode *node = m_tasks.exchange(nullptr, std::memory_order_acquire);
+    // The queue hands them out newest first.
+    TaskNode *ordered = nullptr;
+    while (node) {
+        TaskNode *next = node->Next;
+        node->Next = ordered;
+        ordered = node;
+        node = next;
+    }
+    while (ordered) {
+        TaskNode *next = ordered->Next;
+        ordered->Task();
+        delete ordered;
+        ordered = next;
+    }
+}
+
+void EventLoop::FireTimers(const std::int64_t now) noexcept
+{
+    if (m_timers.empty()) {
+        return;
+    }
+    m_firingTimers = true;
+    // Nothing is added to or removed from "m_timers" meanwhile.
+    for (auto &&timer : m_timers) {
+        if ((timer.Id == 0) || (timer.Deadline > now)) {
+            continue;
+        }
+        // Fire once even if several intervals were missed, and stay on the grid.
+        timer.Deadline += (((now - timer.Deadline) / timer.Interval) + 1) * timer.Interval;
+        timer.Callback();
+    }
+    m_firingTimers = false;
+    if (m_timersDirty) {
+        m_timersDirty = false;
+        std::erase_if(m_timers, [](const Timer &timer){ return (timer.Id == 0); });
+    }
+    if (!m_pendingTimers.empty()) {
+        for (auto &&timer : m_pendingTimers) {
+            m_timers.push_back(std::move(timer));
+        }
+        m_pendingTimers.clear();
+    }
+}
+
+void EventLoop::EmitFrame(const std::int64_t now) noexcept
+{
+    if (m_frame.Empty()) {
+        m_nextFrame = -1;
+        return;
+    }
+    if (m_nextFrame < 0) {
+        // Somebody just connected, start with the next vertical blank.
+        m_nextFrame = NextFrame(now);
+        return;
+    }
+    if (now < m_nextFrame) {
+        return;
+    }
+    const std::int64_t frame = m_nextFrame;
+    m_nextFrame = NextFrame(now + 1);
+    m_frame.Emit(frame);
+}
+
+std::int64_t EventLoop::NextFrame(const std::int64_t now) noexcept
+{
+    const std::int64_t vblank = m_frameScheduler.NextVBlank(now);
+    if (vblank >= 0) {
+        return vblank;
+    }
+    // No compositor timing (composition disabled, remote sessions), assume 60Hz.
+    return (now + std::max(std::int64_t(1), (FrameClock::Default().Frequency() / 60)));
+}
+
+void EventLoop::Wait() noexcept
+{
+    FrameClock &clock = FrameClock::Default();
+    const std::int64_t now = clock.Now();
+    const std::int64_t frequency = clock.Frequency();
+    if ((frequency <= 0) || m_tasks.load(std::memory_order_relaxed)) {
+        return;
+    }
+    std::int64_t coarseDeadline = std::numeric_limits<std::int64_t>::max();
+    std::int64_t preciseDeadline = ((m_nextFrame >= 0) ? m_nextFrame : std::numeric_limits<std::int64_t>::max());
+    for (auto &&timer : m_timers) {
+        std::int64_t &deadline = ((timer.Type == EventLoopTimerType::Precise) ? preciseDeadline : coarseDeadline);
+        deadline = std::min(deadline, timer.Deadline);
+    }
+    DWORD timeout = INFINITE;
+    if (coarseDeadline != std::numeric_limits<std::int64_t>::max()) {
+        const std::int64_t remaining = std::max(std::int64_t(0), (coarseDeadline - now));
+        // Rounded up, waking up early only means another round of waiting.
+        timeout = static_cast<DWORD>(std::min(std::int64_t(INFINITE - 1), (((remaining * 1000) + frequency - 1) / frequency)));
+    }
+    HANDLE handles[2] = {};
+    DWORD handleCount = 0;
+    if (m_wakeEvent) {
+        handles[handleCount++] = m_wakeEvent;
+    }
+    if (preciseDeadline != std::numeric_limits<std::int64_t>::max()) {
+        const std::int64_t remaining = (preciseDeadline - now);
+        if (remaining <= 0) {
+            return;
+        }
+        if (m_timer) {
+            // Negative values mean relative time, in 100 nanosecond intervals.
+            LARGE_INTEGER dueTime = {};
+            dueTime.QuadPart = -std::max(std::int64_t(1), ((remaining * 10000000) / frequency));
+            if (SetWaitableTimer(m_timer, &dueTime, 0, nullptr, nullptr, FALSE) == FALSE) {
+                PRINT_WIN32_ERROR_MESSAGE(SetWaitableTimer, L"Failed to arm the waitable timer of the event loop.")
+            } else {
+                handles[handleCount++] = m_timer;
+            }
+        } else {
+            timeout = std::min(timeout, static_cast<DWORD>(std::min(std::int64_t(INFINITE - 1), (((remaining * 1000) + frequency - 1) / frequency))));
+        }
+    }
+    // MWMO_INPUTAVAILABLE: also return for input that has been seen, but not
+    // removed from the queue yet, for example by a nested modal loop.
+    if (MsgWaitForMultipleObjectsEx(handleCount, handles, timeout, QS_ALLINPUT, MWMO_INPUTAVAILABLE) == WAIT_FAILED) {
+        PRINT_WIN32_ERROR_MESSAGE(MsgWaitForMultipleObjectsEx, L"Failed to wait for the next event.")
+    }
+}
@@ -0,0 +1,124 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <SDKDDKVer.h>
+#include <Windows.h>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include "Signal.hpp"
+#include "FrameScheduler.h"
+
+using EventLoopTask = std::function<void ()>;
+using EventLoopTimerCallback = std::function<void ()>;
+using EventLoopMessageFilter = std::function<bool (const MSG *)>;
+// The argument is the vertical blank the frame is for, in "FrameClock::Default()" ticks.
+using EventLoopFrameSignal = Signal<const std::int64_t>;
+
+enum class EventLoopTimerType : int
+{
+    Coarse = 0, // Fires within the system timer resolution, usually about 16 milliseconds.
+    Precise // Backed by a high resolution waitable timer.
+};
+
+// A message loop that sleeps in "MsgWaitForMultipleObjectsEx()" and, besides the
+// window messages, runs tasks posted from any thread, timers and frame callbacks.
+// Every round handles the pending messages first, so input is never stuck behind
+// a long queue of tasks; the tasks posted meanwhile run in the next round.
+class EventLoop
+{
+public:
+    explicit EventLoop() noexcept;
+    ~EventLoop() noexcept;
+
+    // May be called from any thread, without taking any lock. The tasks run on
+    // the thread of the loop, in the order they were posted.
+    [[nodiscard]] bool Post(const EventLoopTask &task) noexcept;
+    // May be called from any thread. "Run()" returns the exit code once the
+    // messages and tasks queued so far are handled.
+    void Quit(const int exitCode) noexcept;
+
+    // Everything below must be called from the thread of the loop.
+
+    // Returns an id for "StopTimer()", never zero. The timer keeps firing
+    // every "interval" milliseconds until it's stopped.
+    [[nodiscard]] std::uint32_t StartTimer(const UINT interval, const EventLoopTimerType type, const EventLoopTimerCallback &cb) noexcept;
+    void StopTimer(const std::uint32_t id) noexcept;
+    // Emitted once per vertical blank, as long as anyone is connected.
+    [[nodiscard]] EventLoopFrameSignal &Frame() noexcept;
+    // Returning true means the message has been handled, it's not dispatched then.
+    void MessageFilter(const EventLoopMessageFilter &cb) noexcept;
+
+    [[nodiscard]] int Run() noexcept;
+    // The loop running on the calling thread, if any.
+    [[nodiscard]] static EventLoop *Current() noexcept;
+
+    // Messages handled in one go before the tasks and timers get their turn.
+    static inline constexpr const UINT MessageBatchSize = 64;
+
+private:
+    EventLoop(const EventLoop &) = delete;
+    EventLoop &operator=(const EventLoop &) = delete;
+    EventLoop(EventLoop &&) = delete;
+    EventLoop &operator=(EventLoop &&) = delete;
+
+private:
+    struct TaskNode
+    {
+        TaskNode *Next = nullptr;
+        EventLoopTask Task = nullptr;
+    };
+
+    struct Timer
+    {
+        std::uint32_t Id = 0; // Zero once stopped while the timers are firing.
+        EventLoopTimerType Type = EventLoopTimerType::Coarse;
+        std::int64_t Interval = 0; // In clock ticks, like the deadline.
+        std::int64_t Deadline = 0;
+        EventLoopTimerCallback Callback = nullptr;
+    };
+
+    void RunTasks() noexcept;
+    void FireTimers(const std::int64_t now) noexcept;
+    void EmitFrame(const std::int64_t now) noexcept;
+    [[nodiscard]] std::int64_t NextFrame(const std::int64_t now) noexcept;
+    void Wait() noexcept;
+
+private:
+    std::atomic<TaskNode *> m_tasks = nullptr; // Newest first.
+    HANDLE m_wakeEvent = nullptr;
+    HANDLE m_timer = nullptr;
+    std::vector<Timer> m_timers = {};
+    std::vector<Timer> m_pendingTimers = {}; // Started while the timers are firing.
+    bool m_firingTimers = false;
+    bool m_timersDirty = false;
+    std::uint32_t m_lastTimerId = 0;
+    EventLoopFrameSignal m_frame;
+    FrameScheduler m_frameScheduler = FrameScheduler(FrameClock::Default());
+    std::int64_t m_nextFrame = -1; // -1 while nobody wants frames.
+    EventLoopMessageFilter m_messageFilter = nullptr;
+};
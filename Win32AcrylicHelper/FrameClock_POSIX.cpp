@@ -0,0 +1,72 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _WIN32
+
+#include "FrameScheduler.h"
+#include <chrono>
+#include <thread>
+
+// There's no compositor to ask, so the scheduler never waits on POSIX.
+class POSIXFrameClock final : public FrameClock
+{
+public:
+    explicit POSIXFrameClock() noexcept = default;
+    ~POSIXFrameClock() noexcept override = default;
+
+    [[nodiscard]] std::int64_t Frequency() const noexcept override
+    {
+        return std::chrono::steady_clock::period::den / std::chrono::steady_clock::period::num;
+    }
+
+    [[nodiscard]] std::int64_t Now() const noexcept override
+    {
+        return std::chrono::steady_clock::now().time_since_epoch().count();
+    }
+
+    [[nodiscard]] bool QueryVBlank(VBlankTiming &timing) noexcept override
+    {
+        timing = {};
+        return false;
+    }
+
+    void WaitUntil(const std::int64_t deadline) noexcept override
+    {
+        std::this_thread::sleep_until(std::chrono::steady_clock::time_point(std::chrono::steady_clock::duration(deadline)));
+    }
+
+private:
+    POSIXFrameClock(const POSIXFrameClock &) = delete;
+    POSIXFrameClock &operator=(const POSIXFrameClock &) = delete;
+    POSIXFrameClock(POSIXFrameClock &&) = delete;
+    POSIXFrameClock &operator=(POSIXFrameClock &&) = delete;
+};
+
+FrameClock &FrameClock::Default() noexcept
+{
+    static POSIXFrameClock clock;
+    return clock;
+}
+
+#endif // _WIN32
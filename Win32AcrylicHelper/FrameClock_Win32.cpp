@@ -0,0 +1,151 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifdef _WIN32
+
+#include <SDKDDKVer.h>
+#include <Windows.h>
+#include <DwmApi.h>
+#include "FrameScheduler.h"
+#include "OperationResult.h"
+#include "TimingService.h"
+
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION (0x00000002)
+#endif // CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+
+// One waitable timer per thread, closed when the thread exits.
+class ThreadWaitableTimer
+{
+public:
+    inline explicit ThreadWaitableTimer() noexcept
+    {
+        // High resolution timers (Windows 10 1803 and onwards) fire on time without
+        // raising the system wide timer resolution through "timeBeginPeriod()". The
+        // regular ones rely on "TimingService" raising it during a resize.
+        m_timer = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+        if (!m_timer) {
+            m_timer = CreateWaitableTimerExW(nullptr, nullptr, 0, TIMER_ALL_ACCESS);
+            if (!m_timer) {
+                PRINT_WIN32_ERROR_MESSAGE(CreateWaitableTimerExW, L"Failed to create a waitable timer.")
+            }
+        }
+    }
+    inline ~ThreadWaitableTimer() noexcept
+    {
+        if (m_timer) {
+            if (CloseHandle(m_timer) == FALSE) {
+                PRINT_WIN32_ERROR_MESSAGE(CloseHandle, L"Failed to close the waitable timer.")
+            }
+            m_timer = nullptr;
+        }
+    }
+
+    [[nodiscard]] inline HANDLE Handle() const noexcept
+    {
+        return m_timer;
+    }
+
+private:
+    ThreadWaitableTimer(const ThreadWaitableTimer &) = delete;
+    ThreadWaitableTimer &operator=(const ThreadWaitableTimer &) = delete;
+    ThreadWaitableTimer(ThreadWaitableTimer &&) = delete;
+    ThreadWaitableTimer &operator=(ThreadWaitableTimer &&) = delete;
+
+private:
+    HANDLE m_timer = nullptr;
+};
+
+class Win32FrameClock final : public FrameClock
+{
+public:
+    explicit Win32FrameClock() noexcept
+    {
+        m_frequency = TimingService::PerformanceFrequency();
+    }
+    ~Win32FrameClock() noexcept override = default;
+
+    [[nodiscard]] std::int64_t Frequency() const noexcept override
+    {
+        return m_frequency;
+    }
+
+    [[nodiscard]] std::int64_t Now() const noexcept override
+    {
+        LARGE_INTEGER counter = {};
+        QueryPerformanceCounter(&counter);
+        return counter.QuadPart;
+    }
+
+    [[nodiscard]] bool QueryVBlank(VBlankTiming &timing) noexcept override
+    {
+        DWM_TIMING_INFO dti;
+        SecureZeroMemory(&dti, sizeof(dti));
+        dti.cbSize = sizeof(dti);
+        // Fails when DWM composition is disabled, that's not an error.
+        if (FAILED(DwmGetCompositionTimingInfo(nullptr, &dti))) {
+            return false;
+        }
+        // Both are in performance counter ticks already.
+        timing.VBlank = static_cast<std::int64_t>(dti.qpcVBlank);
+        timing.Period = static_cast<std::int64_t>(dti.qpcRefreshPeriod);
+        return true;
+    }
+
+    void WaitUntil(const std::int64_t deadline) noexcept override
+    {
+        static thread_local const ThreadWaitableTimer timer = ThreadWaitableTimer();
+        const std::int64_t remaining = (deadline - Now());
+        if ((remaining <= 0) || (m_frequency <= 0) || !timer.Handle()) {
+            return;
+        }
+        // Negative values mean relative time, in 100 nanosecond intervals.
+        LARGE_INTEGER dueTime = {};
+        dueTime.QuadPart = -((remaining * 10000000) / m_frequency);
+        if (SetWaitableTimer(timer.Handle(), &dueTime, 0, nullptr, nullptr, FALSE) == FALSE) {
+            PRINT_WIN32_ERROR_MESSAGE(SetWaitableTimer, L"Failed to arm the waitable timer.")
+            return;
+        }
+        if (WaitForSingleObject(timer.Handle(), INFINITE) == WAIT_FAILED) {
+            PRINT_WIN32_ERROR_MESSAGE(WaitForSingleObject, L"Failed to wait for the waitable timer.")
+        }
+    }
+
+private:
+    Win32FrameClock(const Win32FrameClock &) = delete;
+    Win32FrameClock &operator=(const Win32FrameClock &) = delete;
+    Win32FrameClock(Win32FrameClock &&) = delete;
+    Win32FrameClock &operator=(Win32FrameClock &&) = delete;
+
+private:
+    std::int64_t m_frequency = 0;
+};
+
+FrameClock &FrameClock::Default() noexcept
+{
+    static Win32FrameClock clock;
+    return clock;
+}
+
+#endif // _WIN32
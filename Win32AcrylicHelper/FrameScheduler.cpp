@@ -0,0 +1,97 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "FrameScheduler.h"
+
+// A new sample whose period differs more than this (in percent) from the
+// current one replaces it instead of being blended in, the display mode changed.
+static constexpr const std::int64_t PeriodResetThreshold = 10;
+
+FrameScheduler::FrameScheduler(FrameClock &clock) noexcept : m_clock(clock)
+{
+}
+
+bool FrameScheduler::Sample(const std::int64_t now) noexcept
+{
+    if (m_sampled && ((now - m_sampledAt) < ((ResampleInterval * m_clock.Frequency()) / 1000))) {
+        return m_valid;
+    }
+    // Remember failed attempts as well, so that we don't keep asking a
+    // compositor which can't answer (composition disabled) on every call.
+    m_sampled = true;
+    m_sampledAt = now;
+    VBlankTiming timing = {};
+    if (!m_clock.QueryVBlank(timing) || (timing.Period <= 0)) {
+        m_valid = false;
+        return false;
+    }
+    const std::int64_t difference = (timing.Period - m_timing.Period);
+    const bool blend = (m_valid && (((difference < 0) ? -difference : difference) * 100 <= (m_timing.Period * PeriodResetThreshold)));
+    // The reported period jitters a little, smooth it out.
+    m_timing.Period = (blend ? ((m_timing.Period * 7 + timing.Period) / 8) : timing.Period);
+    m_timing.VBlank = timing.VBlank;
+    m_valid = true;
+    return true;
+}
+
+std::int64_t FrameScheduler::NextVBlank(const std::int64_t now) noexcept
+{
+    if (!Sample(now)) {
+        return -1;
+    }
+    // The compositor told us about SOME vertical blank, past or future,
+    // possibly many frames away. Convert that into the NEXT vertical blank.
+    std::int64_t phase = ((m_timing.VBlank - now) % m_timing.Period);
+    if (phase < 0) {
+        phase += m_timing.Period;
+    }
+    return (now + phase);
+}
+
+bool FrameScheduler::WaitForVBlank() noexcept
+{
+    const std::int64_t now = m_clock.Now();
+    const std::int64_t next = NextVBlank(now);
+    if (next < 0) {
+        return false;
+    }
+    if (next > now) {
+        m_clock.WaitUntil(next);
+    }
+    return true;
+}
+
+std::int64_t FrameScheduler::Period() noexcept
+{
+    if (!Sample(m_clock.Now())) {
+        return -1;
+    }
+    return m_timing.Period;
+}
+
+void FrameScheduler::Invalidate() noexcept
+{
+    m_sampled = false;
+    m_valid = false;
+}
@@ -0,0 +1,164 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+// Deliberately free of any Windows dependency, so that the scheduling logic
+// can be exercised with "FakeFrameClock" everywhere.
+
+#include <cstdint>
+
+// A vertical blank reported by the compositor, in clock ticks.
+struct VBlankTiming
+{
+    std::int64_t VBlank = 0; // Some vertical blank, past or future, possibly many frames away.
+    std::int64_t Period = 0; // The refresh period.
+};
+
+// Where the frame scheduler gets its time and vertical blank information from.
+class FrameClock
+{
+public:
+    virtual ~FrameClock() noexcept = default;
+
+    // Clock ticks per second.
+    [[nodiscard]] virtual std::int64_t Frequency() const noexcept = 0;
+    [[nodiscard]] virtual std::int64_t Now() const noexcept = 0;
+    [[nodiscard]] virtual bool QueryVBlank(VBlankTiming &timing) noexcept = 0;
+    // Block the calling thread until the given point in time.
+    virtual void WaitUntil(const std::int64_t deadline) noexcept = 0;
+
+    // The clock of the current platform: the performance counter, DWM and a
+    // high resolution waitable timer on Windows, "std::chrono::steady_clock"
+    // without any vertical blank information on POSIX systems.
+    [[nodiscard]] static FrameClock &Default() noexcept;
+};
+
+// A manually driven clock. Time only moves on "Advance()" and "WaitUntil()",
+// which makes the scheduler fully deterministic.
+class FakeFrameClock final : public FrameClock
+{
+public:
+    inline explicit FakeFrameClock(const std::int64_t frequency, const std::int64_t period) noexcept {
+        m_frequency = frequency;
+        m_timing.Period = period;
+    }
+    inline ~FakeFrameClock() noexcept override = default;
+
+    [[nodiscard]] inline std::int64_t Frequency() const noexcept override {
+        return m_frequency;
+    }
+    [[nodiscard]] inline std::int64_t Now() const noexcept override {
+        return m_now;
+    }
+    [[nodiscard]] inline bool QueryVBlank(VBlankTiming &timing) noexcept override {
+        ++m_queryCount;
+        if (!m_available) {
+            return false;
+        }
+        timing = m_timing;
+        return true;
+    }
+    inline void WaitUntil(const std::int64_t deadline) noexcept override {
+        ++m_waitCount;
+        if (deadline > m_now) {
+            m_waited += (deadline - m_now);
+            m_now = deadline;
+        }
+    }
+
+    inline void Advance(const std::int64_t ticks) noexcept {
+        m_now += ticks;
+    }
+    inline void VBlank(const VBlankTiming &timing) noexcept {
+        m_timing = timing;
+    }
+    inline void Available(const bool value) noexcept {
+        m_available = value;
+    }
+    [[nodiscard]] inline int QueryCount() const noexcept {
+        return m_queryCount;
+    }
+    [[nodiscard]] inline int WaitCount() const noexcept {
+        return m_waitCount;
+    }
+    // The total time spent in "WaitUntil()".
+    [[nodiscard]] inline std::int64_t Waited() const noexcept {
+        return m_waited;
+    }
+
+private:
+    FakeFrameClock(const FakeFrameClock &) = delete;
+    FakeFrameClock &operator=(const FakeFrameClock &) = delete;
+    FakeFrameClock(FakeFrameClock &&) = delete;
+    FakeFrameClock &operator=(FakeFrameClock &&) = delete;
+
+private:
+    std::int64_t m_frequency = 0;
+    std::int64_t m_now = 0;
+    VBlankTiming m_timing = {};
+    bool m_available = true;
+    int m_queryCount = 0;
+    int m_waitCount = 0;
+    std::int64_t m_waited = 0;
+};
+
+// Aligns work (resize commits, mostly) with the vertical blank. The phase is
+// sampled from the clock at most every "ResampleInterval" instead of asking
+// the compositor every time, and the period is smoothed across samples.
+class FrameScheduler
+{
+public:
+    explicit FrameScheduler(FrameClock &clock) noexcept;
+    ~FrameScheduler() noexcept = default;
+
+    // The first vertical blank at or after "now", or -1 if it's unknown.
+    [[nodiscard]] std::int64_t NextVBlank(const std::int64_t now) noexcept;
+    // Block until the next vertical blank. Returns false without waiting if
+    // the clock can't tell where the vertical blanks are.
+    [[nodiscard]] bool WaitForVBlank() noexcept;
+    // Forget the current phase, for example when the display changes.
+    void Invalidate() noexcept;
+    // The refresh period in clock ticks, or -1 if it's unknown.
+    [[nodiscard]] std::int64_t Period() noexcept;
+
+    // Milliseconds between two samples of the compositor timing.
+    static inline constexpr const std::int64_t ResampleInterval = 500;
+
+private:
+    FrameScheduler(const FrameScheduler &) = delete;
+    FrameScheduler &operator=(const FrameScheduler &) = delete;
+    FrameScheduler(FrameScheduler &&) = delete;
+    FrameScheduler &operator=(FrameScheduler &&) = delete;
+
+private:
+    [[nodiscard]] bool Sample(const std::int64_t now) noexcept;
+
+private:
+    FrameClock &m_clock;
+    VBlankTiming m_timing = {};
+    std::int64_t m_sampledAt = 0;
+    bool m_sampled = false; // A sample has been attempted, successful or not.
+    bool m_valid = false;
+};
@@ -0,0 +1,168 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+// A small open-addressing hash table from handles (any pointer-like key, null
+// is reserved) to objects. Meant for per-message lookups: a hit is usually a
+// single probe and never allocates, only inserting may grow the table.
+// Deliberately free of any Windows dependency.
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+
+template<typename Handle, typename Object>
+class HandleMap
+{
+public:
+    inline explicit HandleMap() noexcept = default;
+    inline ~HandleMap() noexcept = default;
+
+    [[nodiscard]] inline std::size_t Size() const noexcept {
+        return m_size;
+    }
+
+    [[nodiscard]] inline Object *Find(const Handle key) const noexcept {
+        if (!key || (m_size == 0)) {
+            return nullptr;
+        }
+        for (std::size_t i = Home(key); ; i = Next(i)) {
+            const Slot &slot = m_slots[i];
+            if (slot.Key == key) {
+                return slot.Value;
+            }
+            if (!slot.Key) {
+                return nullptr;
+            }
+        }
+    }
+
+    // Replaces the value if the key is there already. Fails only if the
+    // table can't grow.
+    [[nodiscard]] inline bool Insert(const Handle key, Object *value) noexcept {
+        if (!key) {
+            return false;
+        }
+        // Keep the load factor below 3/4, the probe sequences stay short.
+        if (((m_size + 1) * 4) > (m_capacity * 3)) {
+            if (!Rehash((m_capacity == 0) ? InitialCapacity : (m_capacity * 2))) {
+                return false;
+            }
+        }
+        for (std::size_t i = Home(key); ; i = Next(i)) {
+            Slot &slot = m_slots[i];
+            if (slot.Key == key) {
+                slot.Value = value;
+                return true;
+            }
+            if (!slot.Key) {
+                slot.Key = key;
+                slot.Value = value;
+                ++m_size;
+                return true;
+            }
+        }
+    }
+
+    inline void Erase(const Handle key) noexcept {
+        if (!key || (m_size == 0)) {
+            return;
+        }
+        std::size_t hole = Home(key);
+        while (m_slots[hole].Key != key) {
+            if (!m_slots[hole].Key) {
+                return;
+            }
+            hole = Next(hole);
+        }
+        // Backward shift deletion: move every following entry of the cluster that
+        // would be unreachable otherwise into the hole. No tombstones, so lookups
+        // never get slower over time.
+        for (std::size_t i = Next(hole); m_slots[i].Key; i = Next(i)) {
+            const std::size_t home = Home(m_slots[i].Key);
+            // Whether "home" lies cyclically in (hole, i], the entry is fine then.
+            const bool reachable = ((hole <= i) ? ((hole < home) && (home <= i)) : ((hole < home) || (home <= i)));
+            if (!reachable) {
+                m_slots[hole] = m_slots[i];
+                hole = i;
+            }
+        }
+        m_slots[hole] = {};
+        --m_size;
+    }
+
+private:
+    HandleMap(const HandleMap &) = delete;
+    HandleMap &operator=(const HandleMap &) = delete;
+    HandleMap(HandleMap &&) = delete;
+    HandleMap &operator=(HandleMap &&) = delete;
+
+private:
+    struct Slot
+    {
+        Handle Key = {};
+        Object *Value = nullptr;
+    };
+
+    static inline constexpr const std::size_t InitialCapacity = 16; // Must be a power of two.
+
+    [[nodiscard]] inline std::size_t Home(const Handle key) const noexcept {
+        // Handles are usually multiples of 4 or 8 and close to each other,
+        // Fibonacci hashing spreads them over the whole table.
+        const auto value = static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(key));
+        return static_cast<std::size_t>((value * 0x9E3779B97F4A7C15ull) >> 32) & (m_capacity - 1);
+    }
+
+    [[nodiscard]] inline std::size_t Next(const std::size_t index) const noexcept {
+        return ((index + 1) & (m_capacity - 1));
+    }
+
+    [[nodiscard]] inline bool Rehash(const std::size_t capacity) noexcept {
+        std::unique_ptr<Slot[]> slots(new (std::nothrow) Slot[capacity]);
+        if (!slots) {
+            return false;
+        }
+        std::unique_ptr<Slot[]> old = std::move(m_slots);
+        const std::size_t oldCapacity = m_capacity;
+        m_slots = std::move(slots);
+        m_capacity = capacity;
+        for (std::size_t i = 0; i != oldCapacity; ++i) {
+            if (old[i].Key) {
+                std::size_t j = Home(old[i].Key);
+                while (m_slots[j].Key) {
+                    j = Next(j);
+                }
+                m_slots[j] = old[i];
+            }
+        }
+        return true;
+    }
+
+private:
+    std::unique_ptr<Slot[]> m_slots = nullptr;
+    std::size_t m_capacity = 0;
+    std::size_t m_size = 0;
+};
@@ -0,0 +1,199 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+// A precomputed non-client hit-test map. Deliberately free of any Windows
+// dependency, the caller translates the result into the "HT*" constants.
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <utility>
+
+enum class HitTestResult : std::uint8_t
+{
+    Client = 0,
+    Caption,
+    Left,
+    Right,
+    Top,
+    TopLeft,
+    TopRight,
+    Bottom,
+    BottomLeft,
+    BottomRight
+};
+
+// Everything the hit test depends on, in client coordinates.
+struct HitTestGeometry
+{
+    int Width = 0;
+    int Height = 0;
+    int ResizeBorderThicknessX = 0;
+    int ResizeBorderThicknessY = 0;
+    int TitleBarHeight = 0;
+    bool HasTitleBar = false; // Only the windowed and maximized windows have one.
+    bool ResizableTop = false; // Only the windowed windows can be resized from the top.
+    bool ResizableEdges = false; // The left, right and bottom edges and the corners.
+};
+
+// The client area split into horizontal bands, each band split into segments.
+// Built once whenever the geometry changes, a lookup is a handful of integer
+// comparisons instead of redoing the geometry math for every mouse move.
+class HitTestMap
+{
+    // Three horizontal edges at most (top border, title bar, bottom border),
+    // two vertical edges at most (left and right border) inside every band.
+    static inline constexpr const std::size_t MaximumBandCount = 4;
+    static inline constexpr const std::size_t MaximumSegmentCount = 3;
+
+    struct Segment
+    {
+        int End = 0; // Exclusive.
+        HitTestResult Result = HitTestResult::Client;
+    };
+
+    struct Band
+    {
+        int End = 0; // Exclusive.
+        std::uint8_t SegmentCount = 0;
+        std::array<Segment, MaximumSegmentCount> Segments = {};
+    };
+
+public:
+    inline constexpr explicit HitTestMap() noexcept = default;
+    inline ~HitTestMap() noexcept = default;
+
+    inline constexpr void Build(const HitTestGeometry &geometry) noexcept {
+        m_bandCount = 0;
+        const auto AddBand = [this, &geometry](const int first, const int end) -> void {
+            if (first >= end) {
+                return;
+            }
+            Band &band = m_bands[m_bandCount];
+            band = Band();
+            band.End = end;
+            // Every row inside the band is classified the same way, so it's
+            // enough to look at its first row.
+            const int xThickness = HorizontalThickness(geometry, first);
+            const auto AddSegment = [&band, &geometry, first](const int segmentFirst, const int segmentEnd) -> void {
+                if (segmentFirst >= segmentEnd) {
+                    return;
+                }
+                const HitTestResult result = Classify(geometry, segmentFirst, first);
+                if ((band.SegmentCount > 0) && (band.Segments[band.SegmentCount - 1].Result == result)) {
+                    band.Segments[band.SegmentCount - 1].End = segmentEnd;
+                    return;
+                }
+                band.Segments[band.SegmentCount] = {segmentEnd, result};
+                ++band.SegmentCount;
+            };
+            const int leftEnd = Clamp(xThickness + 1);
+            const int rightFirst = Clamp(std::max(geometry.Width - xThickness, leftEnd));
+            AddSegment(Minimum, leftEnd);
+            AddSegment(leftEnd, rightFirst);
+            AddSegment(rightFirst, Maximum);
+            ++m_bandCount;
+        };
+        std::array<int, MaximumBandCount + 1> edges = {
+            Minimum,
+            Clamp(geometry.ResizeBorderThicknessY + 1),
+            Clamp(geometry.TitleBarHeight + 1),
+            Clamp(geometry.Height - geometry.ResizeBorderThicknessY),
+            Maximum
+        };
+        // Insertion sort, there are only five of them.
+        for (std::size_t i = 1; i != edges.size(); ++i) {
+            for (std::size_t j = i; (j > 0) && (edges[j - 1] > edges[j]); --j) {
+                std::swap(edges[j - 1], edges[j]);
+            }
+        }
+        for (std::size_t i = 1; i != edges.size(); ++i) {
+            AddBand(edges[i - 1], edges[i]);
+        }
+    }
+
+    [[nodiscard]] inline constexpr HitTestResult Find(const int x, const int y) const noexcept {
+        for (std::uint8_t i = 0; i != m_bandCount; ++i) {
+            const Band &band = m_bands[i];
+            if (y < band.End) {
+                for (std::uint8_t j = 0; j != band.SegmentCount; ++j) {
+                    if (x < band.Segments[j].End) {
+                        return band.Segments[j].Result;
+                    }
+                }
+                break;
+            }
+        }
+        return HitTestResult::Client;
+    }
+
+    // The reference implementation, the map must give the same answer for every point.
+    [[nodiscard]] static inline constexpr HitTestResult Classify(const HitTestGeometry &geometry, const int x, const int y) noexcept {
+        const bool isTop = (geometry.ResizableTop && (y <= geometry.ResizeBorderThicknessY));
+        const bool isBottom = (geometry.ResizableEdges && (y >= (geometry.Height - geometry.ResizeBorderThicknessY)));
+        const int xThickness = HorizontalThickness(geometry, y);
+        const bool isLeft = (geometry.ResizableEdges && (x <= xThickness));
+        const bool isRight = (geometry.ResizableEdges && (x >= (geometry.Width - xThickness)));
+        if (isTop) {
+            return (isLeft ? HitTestResult::TopLeft : (isRight ? HitTestResult::TopRight : HitTestResult::Top));
+        }
+        if (isBottom) {
+            return (isLeft ? HitTestResult::BottomLeft : (isRight ? HitTestResult::BottomRight : HitTestResult::Bottom));
+        }
+        if (isLeft) {
+            return HitTestResult::Left;
+        }
+        if (isRight) {
+            return HitTestResult::Right;
+        }
+        if (geometry.HasTitleBar && (y <= geometry.TitleBarHeight)) {
+            return HitTestResult::Caption;
+        }
+        return HitTestResult::Client;
+    }
+
+private:
+    // Keep one unit of headroom so "x + 1" and "End" never overflow.
+    static inline constexpr const int Minimum = (std::numeric_limits<int>::min() + 1);
+    static inline constexpr const int Maximum = (std::numeric_limits<int>::max() - 1);
+
+    [[nodiscard]] static inline constexpr int Clamp(const int value) noexcept {
+        return ((value < Minimum) ? Minimum : ((value > Maximum) ? Maximum : value));
+    }
+
+    // The side borders are twice as wide next to the top and bottom borders,
+    // to make the corners easier to grab.
+    [[nodiscard]] static inline constexpr int HorizontalThickness(const HitTestGeometry &geometry, const int y) noexcept {
+        const bool isTop = (geometry.ResizableTop && (y <= geometry.ResizeBorderThicknessY));
+        const bool isBottom = (geometry.ResizableEdges && (y >= (geometry.Height - geometry.ResizeBorderThicknessY)));
+        return (geometry.ResizeBorderThicknessX * ((isTop || isBottom) ? 2 : 1));
+    }
+
+private:
+    std::array<Band, MaximumBandCount> m_bands = {};
+    std::uint8_t m_bandCount = 0;
+};
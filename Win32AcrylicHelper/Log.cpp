@@ -0,0 +1,287 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "Log.h"
+#include <array>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <mutex>
+#include <vector>
+#include <functional>
+#include <thread>
+
+#ifdef _WIN32
+#include "ErrorSink.h"
+#include "OperationResult.h"
+#endif // _WIN32
+
+static constexpr const std::size_t ThreadBufferSize = (64 * 1024);
+
+struct ThreadBuffer
+{
+    std::array<std::byte, ThreadBufferSize> Data = {};
+    std::size_t Used = 0;
+};
+
+// Flushes the buffer of its thread when the thread exits.
+struct ThreadBufferGuard
+{
+    ~ThreadBufferGuard() noexcept;
+};
+
+static std::mutex g_registryMutex = {};
+// Index N holds the descriptor with the identifier N + 1.
+static std::vector<Log::Descriptor *> g_descriptors = {};
+
+class LogOutput
+{
+public:
+    explicit LogOutput() noexcept;
+    ~LogOutput() noexcept;
+
+    void Write(const std::byte *data, const std::size_t size) noexcept;
+
+private:
+    LogOutput(const LogOutput &) = delete;
+    LogOutput &operator=(const LogOutput &) = delete;
+    LogOutput(LogOutput &&) = delete;
+    LogOutput &operator=(LogOutput &&) = delete;
+
+private:
+    void WriteNewDescriptors() noexcept;
+    void WriteText(const std::byte *data, const std::size_t size) noexcept;
+
+private:
+    std::mutex m_mutex = {};
+    std::FILE *m_file = nullptr;
+    std::size_t m_writtenDescriptors = 0;
+};
+
+[[nodiscard]] static inline LogOutput &GetLogOutput() noexcept
+{
+    // Never destroyed: the libraries are still logging while they are unloaded at exit.
+    // Every write is flushed, so nothing is lost.
+    static LogOutput * const output = new LogOutput;
+    return *output;
+}
+
+// Plain pointers and flags, they stay usable after the guard has been destroyed.
+static thread_local ThreadBuffer *t_buffer = nullptr;
+static thread_local bool t_threadExiting = false;
+static thread_local ThreadBufferGuard t_bufferGuard = {};
+
+[[nodiscard]] static inline std::wstring DescribeErrorCode(const LogFormat::ErrorCode &code) noexcept
+{
+#ifdef _WIN32
+    const OperationResult result = ((code.Domain == static_cast<std::uint8_t>(OperationResultDomain::HResult))
+                                    ? OperationResult(static_cast<HRESULT>(code.Value)) : OperationResult(static_cast<DWORD>(code.Value)));
+    std::wstring message = result.Message();
+    while (!message.empty() && ((message.back() == L'\r') || (message.back() == L'\n'))) {
+        message.pop_back();
+    }
+    const std::wstring number = std::to_wstring(result.Code());
+    return (message.empty() ? number : (number + std::wstring(L" (") + message + std::wstring(L")")));
+#else // _WIN32
+    return std::to_wstring(code.Value);
+#endif // _WIN32
+}
+
+ThreadBufferGuard::~ThreadBufferGuard() noexcept
+{
+    Log::Flush();
+    delete t_buffer;
+    t_buffer = nullptr;
+    // Anything recorded from now on is written out right away.
+    t_threadExiting = true;
+}
+
+LogOutput::LogOutput() noexcept
+{
+#ifdef _WIN32
+    const wchar_t * const path = _wgetenv(L"WIN32ACRYLICHELPER_LOG");
+    if (path && (path[0] != L'\0')) {
+        m_file = _wfopen(path, L"wb");
+    }
+#else // _WIN32
+    const char * const path = std::getenv("WIN32ACRYLICHELPER_LOG");
+    if (path && (path[0] != '\0')) {
+        m_file = std::fopen(path, "wb");
+    }
+#endif // _WIN32
+    if (m_file) {
+        const auto wcharSize = static_cast<std::uint8_t>(sizeof(wchar_t));
+        std::fwrite(LogFormat::Magic, sizeof(LogFormat::Magic), 1, m_file);
+        std::fwrite(&LogFormat::Version, sizeof(LogFormat::Version), 1, m_file);
+        std::fwrite(&wcharSize, sizeof(wcharSize), 1, m_file);
+    }
+}
+
+LogOutput::~LogOutput() noexcept
+{
+    if (m_file) {
+        std::fclose(m_file);
+        m_file = nullptr;
+    }
+}
+
+void LogOutput::WriteNewDescriptors() noexcept
+{
+    const std::scoped_lock lock(g_registryMutex);
+    for (; m_writtenDescriptors < g_descriptors.size(); ++m_writtenDescriptors) {
+        const Log::Descriptor *descriptor = g_descriptors[m_writtenDescriptors];
+        const std::string_view file = (descriptor->File ? descriptor->File : "");
+        const std::string_view function = (descriptor->Function ? descriptor->Function : "");
+        const std::wstring_view format = (descriptor->Format ? descriptor->Format : L"");
+        const auto id = static_cast<std::uint32_t>(m_writtenDescriptors + 1);
+        const auto level = static_cast<std::uint8_t>(descriptor->Level);
+        const auto fileLength = static_cast<std::uint32_t>(file.size());
+        const auto functionLength = static_cast<std::uint32_t>(function.size());
+        const auto formatLength = static_cast<std::uint32_t>(format.size());
+        const auto kind = LogFormat::EntryKind::Descriptor;
+        std::fwrite(&kind, sizeof(kind), 1, m_file);
+        std::fwrite(&id, sizeof(id), 1, m_file);
+        std::fwrite(&level, sizeof(level), 1, m_file);
+        std::fwrite(&descriptor->Line, sizeof(descriptor->Line), 1, m_file);
+        std::fwrite(&fileLength, sizeof(fileLength), 1, m_file);
+        std::fwrite(file.data(), 1, file.size(), m_file);
+        std::fwrite(&functionLength, sizeof(functionLength), 1, m_file);
+        std::fwrite(function.data(), 1, function.size(), m_file);
+        std::fwrite(&formatLength, sizeof(formatLength), 1, m_file);
+        std::fwrite(format.data(), sizeof(wchar_t), format.size(), m_file);
+    }
+}
+
+void LogOutput::WriteText(const std::byte *data, const std::size_t size) noexcept
+{
+    LogFormat::Reader reader(data, size, sizeof(wchar_t));
+    LogFormat::RecordEntry record = {};
+    while (!reader.AtEnd()) {
+        LogFormat::EntryKind kind = {};
+        if (!reader.Get(kind) || (kind != LogFormat::EntryKind::Record) || !reader.GetRecord(record)) {
+            return;
+        }
+        const Log::Descriptor *descriptor = nullptr;
+        {
+            const std::scoped_lock lock(g_registryMutex);
+            if ((record.Id > 0) && (record.Id <= g_descriptors.size())) {
+                descriptor = g_descriptors[record.Id - 1];
+            }
+        }
+        if (!descriptor || !descriptor->Format) {
+            continue;
+        }
+        const std::wstring text = LogFormat::Format(descriptor->Format, record.Arguments, DescribeErrorCode);
+#ifdef _WIN32
+        if (descriptor->Level >= LogLevel::Error) {
+            ErrorSink::Current().Report(ErrorSeverity::Error, text);
+        } else {
+            const std::wstring textWithNewLine = text + L'\n';
+            OutputDebugStringW(textWithNewLine.c_str());
+        }
+#else // _WIN32
+        std::fwprintf(stderr, L"%ls\n", text.c_str());
+#endif // _WIN32
+    }
+}
+
+void LogOutput::Write(const std::byte *data, const std::size_t size) noexcept
+{
+    if (!data || (size == 0)) {
+        return;
+    }
+    const std::scoped_lock lock(m_mutex);
+    if (!m_file) {
+        WriteText(data, size);
+        return;
+    }
+    // The descriptors must precede the first record which refers to them.
+    WriteNewDescriptors();
+    std::fwrite(data, 1, size, m_file);
+    std::fflush(m_file);
+}
+
+std::uint32_t Log::Register(Descriptor &descriptor, const wchar_t *format) noexcept
+{
+    const std::scoped_lock lock(g_registryMutex);
+    // Another thread may have won the race.
+    const std::uint32_t existing = descriptor.Id.load(std::memory_order_acquire);
+    if (existing != 0) {
+        return existing;
+    }
+    descriptor.Format = format;
+    g_descriptors.push_back(&descriptor);
+    const auto id = static_cast<std::uint32_t>(g_descriptors.size());
+    descriptor.Id.store(id, std::memory_order_release);
+    return id;
+}
+
+std::byte *Log::Reserve(const std::size_t size) noexcept
+{
+    if (size > ThreadBufferSize) {
+        return nullptr;
+    }
+    if (!t_buffer) {
+        t_buffer = new (std::nothrow) ThreadBuffer;
+        if (!t_buffer) {
+            return nullptr;
+        }
+        if (!t_threadExiting) {
+            [[maybe_unused]] const ThreadBufferGuard &guard = t_bufferGuard;
+        }
+    }
+    if ((t_buffer->Used + size) > ThreadBufferSize) {
+        Flush();
+    }
+    return (t_buffer->Data.data() + t_buffer->Used);
+}
+
+void Log::Commit(const std::size_t size, const LogLevel level) noexcept
+{
+    t_buffer->Used += size;
+    // Errors are rare and should not wait for the buffer to fill up.
+    if ((level >= LogLevel::Error) || t_threadExiting) {
+        Flush();
+    }
+}
+
+std::uint32_t Log::CurrentThreadId() noexcept
+{
+#ifdef _WIN32
+    static thread_local const DWORD id = GetCurrentThreadId();
+    return static_cast<std::uint32_t>(id);
+#else // _WIN32
+    static thread_local const auto id = static_cast<std::uint32_t>(std::hash<std::thread::id>{}(std::this_thread::get_id()));
+    return id;
+#endif // _WIN32
+}
+
+void Log::Flush() noexcept
+{
+    if (!t_buffer || (t_buffer->Used == 0)) {
+        return;
+    }
+    GetLogOutput().Write(t_buffer->Data.data(), t_buffer->Used);
+    t_buffer->Used = 0;
+}
@@ -0,0 +1,116 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include "LogFormat.hpp"
+#include <atomic>
+#include <chrono>
+
+enum class LogLevel : int
+{
+    Debug = 0,
+    Info = 1,
+    Warning = 2,
+    Error = 3
+};
+
+// A binary log with deferred formatting: a call site only stores the identifier of its
+// static descriptor and the raw arguments into a buffer owned by the current thread.
+// The buffers are written out when they are full, when an error is recorded, when
+// their thread exits or when "Log::Flush()" is called. If the environment variable
+// "WIN32ACRYLICHELPER_LOG" names a file, the binary records go there and can be read
+// with the "LogReader" tool, otherwise they are formatted and sent to the debugger.
+namespace Log
+{
+    // One per call site, created by the "LOG_*()" macros.
+    struct Descriptor
+    {
+        const LogLevel Level = LogLevel::Debug;
+        const char * const File = nullptr;
+        const std::uint32_t Line = 0;
+        const char * const Function = nullptr;
+        // Set when the call site is reached for the first time.
+        const wchar_t *Format = nullptr;
+        std::atomic<std::uint32_t> Id = 0;
+    };
+
+    [[nodiscard]] std::uint32_t Register(Descriptor &descriptor, const wchar_t *format) noexcept;
+    // Returns space for one record in the buffer of the current thread, or null if the
+    // record can never fit. "Commit()" must follow with the same size.
+    [[nodiscard]] std::byte *Reserve(const std::size_t size) noexcept;
+    void Commit(const std::size_t size, const LogLevel level) noexcept;
+    [[nodiscard]] std::uint32_t CurrentThreadId() noexcept;
+    // Writes out the buffer of the current thread.
+    void Flush() noexcept;
+
+    template<typename... Args>
+    inline void Record(Descriptor &descriptor, const wchar_t *format, const Args &...args) noexcept
+    {
+        static_assert(sizeof...(Args) <= 255, "Too many arguments.");
+        std::uint32_t id = descriptor.Id.load(std::memory_order_acquire);
+        if (id == 0) {
+            id = Register(descriptor, format);
+        }
+        const std::size_t size = (LogFormat::RecordHeaderSize + ... + LogFormat::EncodedSize(args));
+        std::byte *data = Reserve(size);
+        if (!data) {
+            return;
+        }
+        const auto timestamp = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+        data = LogFormat::Put(data, LogFormat::EntryKind::Record);
+        data = LogFormat::Put(data, id);
+        data = LogFormat::Put(data, CurrentThreadId());
+        data = LogFormat::Put(data, timestamp);
+        data = LogFormat::Put(data, static_cast<std::uint8_t>(sizeof...(Args)));
+        ((data = LogFormat::Encode(data, args)), ...);
+        Commit(size, descriptor.Level);
+    }
+} // namespace Log
+
+// The first argument is the format, "{}" stands for the next argument. It must be a
+// string literal: only its address is recorded.
+#ifndef __LOG_RECORD
+#define __LOG_RECORD(level, ...) \
+do { \
+    static Log::Descriptor __log_descriptor = { level, __FILE__, __LINE__, __func__ }; \
+    Log::Record(__log_descriptor, __VA_ARGS__); \
+} while (false)
+#endif // __LOG_RECORD
+
+#ifndef LOG_DEBUG
+#define LOG_DEBUG(...) __LOG_RECORD(LogLevel::Debug, __VA_ARGS__)
+#endif // LOG_DEBUG
+
+#ifndef LOG_INFO
+#define LOG_INFO(...) __LOG_RECORD(LogLevel::Info, __VA_ARGS__)
+#endif // LOG_INFO
+
+#ifndef LOG_WARNING
+#define LOG_WARNING(...) __LOG_RECORD(LogLevel::Warning, __VA_ARGS__)
+#endif // LOG_WARNING
+
+#ifndef LOG_ERROR
+#define LOG_ERROR(...) __LOG_RECORD(LogLevel::Error, __VA_ARGS__)
+#endif // LOG_ERROR
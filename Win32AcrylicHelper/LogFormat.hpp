@@ -0,0 +1,346 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+// The binary format of the log files written by "Log.h". Deliberately free of any
+// Windows dependency, the reader tool has to build everywhere.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <type_traits>
+
+namespace LogFormat
+{
+    // File header: magic, version (uint32), size of wchar_t on the writer (uint8).
+    [[maybe_unused]] constexpr const char Magic[8] = { 'W', '3', '2', 'A', 'L', 'O', 'G', '\0' };
+    [[maybe_unused]] constexpr const std::uint32_t Version = 1;
+    [[maybe_unused]] constexpr const std::size_t MaximumStringLength = 1024;
+
+    enum class EntryKind : std::uint8_t
+    {
+        // id (uint32), level (uint8), line (uint32), file, function (narrow strings), format (wide string)
+        Descriptor = 1,
+        // id (uint32), thread (uint32), timestamp in nanoseconds (uint64), argument count (uint8), arguments
+        Record = 2
+    };
+
+    // Every argument starts with its type (uint8).
+    enum class ArgumentType : std::uint8_t
+    {
+        Int = 1, // int64
+        UInt = 2, // uint64
+        Double = 3, // double
+        Bool = 4, // uint8
+        Pointer = 5, // uint64
+        String = 6, // length (uint32), code units of wchar_t
+        ErrorCode = 7 // value (uint32), domain (uint8)
+    };
+
+    // Formatted by the reader, which looks the message up if it can.
+    struct ErrorCode
+    {
+        std::uint32_t Value = 0;
+        std::uint8_t Domain = 0; // The same values as "OperationResultDomain".
+    };
+
+    [[maybe_unused]] constexpr const std::size_t RecordHeaderSize = (sizeof(EntryKind) + sizeof(std::uint32_t) + sizeof(std::uint32_t) + sizeof(std::uint64_t) + sizeof(std::uint8_t));
+
+    template<typename T>
+    inline std::byte *Put(std::byte *data, const T &value) noexcept
+    {
+        std::memcpy(data, &value, sizeof(T));
+        return (data + sizeof(T));
+    }
+
+    template<typename T>
+    [[nodiscard]] inline constexpr bool IsString() noexcept
+    {
+        using Type = std::remove_cv_t<std::remove_reference_t<T>>;
+        return (std::is_same_v<Type, std::wstring> || std::is_same_v<Type, std::wstring_view>
+                || std::is_same_v<std::decay_t<Type>, const wchar_t *> || std::is_same_v<std::decay_t<Type>, wchar_t *>);
+    }
+
+    template<typename T>
+    [[nodiscard]] inline std::wstring_view ToStringView(const T &value) noexcept
+    {
+        if constexpr (std::is_pointer_v<T>) {
+            return (value ? std::wstring_view(value) : std::wstring_view{});
+        } else {
+            return std::wstring_view(value);
+        }
+    }
+
+    template<typename T>
+    [[nodiscard]] inline std::size_t EncodedSize(const T &value) noexcept
+    {
+        if constexpr (IsString<T>()) {
+            const std::size_t length = std::min(ToStringView(value).size(), MaximumStringLength);
+            return (sizeof(ArgumentType) + sizeof(std::uint32_t) + (length * sizeof(wchar_t)));
+        } else if constexpr (std::is_same_v<T, ErrorCode>) {
+            return (sizeof(ArgumentType) + sizeof(std::uint32_t) + sizeof(std::uint8_t));
+        } else if constexpr (std::is_same_v<T, bool>) {
+            return (sizeof(ArgumentType) + sizeof(std::uint8_t));
+        } else {
+            static_assert(std::is_arithmetic_v<T> || std::is_enum_v<T> || std::is_pointer_v<T>, "This type can't be logged.");
+            return (sizeof(ArgumentType) + sizeof(std::uint64_t));
+        }
+    }
+
+    template<typename T>
+    inline std::byte *Encode(std::byte *data, const T &value) noexcept
+    {
+        if constexpr (IsString<T>()) {
+            const std::wstring_view view = ToStringView(value);
+            const auto length = static_cast<std::uint32_t>(std::min(view.size(), MaximumStringLength));
+            data = Put(data, ArgumentType::String);
+            data = Put(data, length);
+            std::memcpy(data, view.data(), (length * sizeof(wchar_t)));
+            return (data + (length * sizeof(wchar_t)));
+        } else if constexpr (std::is_same_v<T, ErrorCode>) {
+            data = Put(data, ArgumentType::ErrorCode);
+            data = Put(data, value.Value);
+            return Put(data, value.Domain);
+        } else if constexpr (std::is_same_v<T, bool>) {
+            data = Put(data, ArgumentType::Bool);
+            return Put(data, static_cast<std::uint8_t>(value ? 1 : 0));
+        } else if constexpr (std::is_enum_v<T>) {
+            return Encode(data, static_cast<std::underlying_type_t<T>>(value));
+        } else if constexpr (std::is_floating_point_v<T>) {
+            data = Put(data, ArgumentType::Double);
+            return Put(data, static_cast<double>(value));
+        } else if constexpr (std::is_pointer_v<T>) {
+            data = Put(data, ArgumentType::Pointer);
+            return Put(data, static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(value)));
+        } else if constexpr (std::is_signed_v<T>) {
+            data = Put(data, ArgumentType::Int);
+            return Put(data, static_cast<std::int64_t>(value));
+        } else {
+            data = Put(data, ArgumentType::UInt);
+            return Put(data, static_cast<std::uint64_t>(value));
+        }
+    }
+
+    struct Argument
+    {
+        ArgumentType Type = ArgumentType::Int;
+        std::int64_t Int = 0;
+        std::uint64_t UInt = 0;
+        double Double = 0.0;
+        std::wstring String = {};
+        ErrorCode Code = {};
+    };
+
+    struct DescriptorEntry
+    {
+        std::uint32_t Id = 0;
+        std::uint8_t Level = 0;
+        std::uint32_t Line = 0;
+        std::string File = {};
+        std::string Function = {};
+        std::wstring Format = {};
+    };
+
+    struct RecordEntry
+    {
+        std::uint32_t Id = 0;
+        std::uint32_t Thread = 0;
+        std::uint64_t Timestamp = 0;
+        std::vector<Argument> Arguments = {};
+    };
+
+    // Reads the entries back. "wcharSize" is the size of wchar_t on the writer.
+    class Reader
+    {
+    public:
+        inline explicit Reader(const std::byte *data, const std::size_t size, const std::size_t wcharSize) noexcept
+            : m_data(data), m_end(data + size), m_wcharSize(wcharSize) {}
+        inline ~Reader() noexcept = default;
+
+        [[nodiscard]] inline bool AtEnd() const noexcept {
+            return (m_data >= m_end);
+        }
+
+        template<typename T>
+        [[nodiscard]] inline bool Get(T &value) noexcept {
+            if (static_cast<std::size_t>(m_end - m_data) < sizeof(T)) {
+                return false;
+            }
+            std::memcpy(&value, m_data, sizeof(T));
+            m_data += sizeof(T);
+            return true;
+        }
+
+        [[nodiscard]] inline bool GetString(std::string &value) noexcept {
+            std::uint32_t length = 0;
+            if (!Get(length) || (static_cast<std::size_t>(m_end - m_data) < length)) {
+                return false;
+            }
+            value.assign(reinterpret_cast<const char *>(m_data), length);
+            m_data += length;
+            return true;
+        }
+
+        [[nodiscard]] inline bool GetString(std::wstring &value) noexcept {
+            std::uint32_t length = 0;
+            if (!Get(length) || ((m_wcharSize != 2) && (m_wcharSize != 4))
+                || ((static_cast<std::size_t>(m_end - m_data) / m_wcharSize) < length)) {
+                return false;
+            }
+            value.clear();
+            value.reserve(length);
+            for (std::uint32_t index = 0; index != length; ++index) {
+                if (m_wcharSize == 2) {
+                    std::uint16_t unit = 0;
+                    std::memcpy(&unit, m_data, sizeof(unit));
+                    value += static_cast<wchar_t>(unit);
+                } else {
+                    std::uint32_t unit = 0;
+                    std::memcpy(&unit, m_data, sizeof(unit));
+                    value += static_cast<wchar_t>(unit);
+                }
+                m_data += m_wcharSize;
+            }
+            return true;
+        }
+
+        [[nodiscard]] inline bool GetDescriptor(DescriptorEntry &entry) noexcept {
+            return (Get(entry.Id) && Get(entry.Level) && Get(entry.Line)
+                    && GetString(entry.File) && GetString(entry.Function) && GetString(entry.Format));
+        }
+
+        [[nodiscard]] inline bool GetRecord(RecordEntry &entry) noexcept {
+            std::uint8_t count = 0;
+            if (!(Get(entry.Id) && Get(entry.Thread) && Get(entry.Timestamp) && Get(count))) {
+                return false;
+            }
+            entry.Arguments.clear();
+            for (std::uint8_t index = 0; index != count; ++index) {
+                Argument argument = {};
+                if (!Get(argument.Type)) {
+                    return false;
+                }
+                bool ok = false;
+                switch (argument.Type) {
+                case ArgumentType::Int:
+                    ok = Get(argument.Int);
+                    break;
+                case ArgumentType::UInt:
+                case ArgumentType::Pointer:
+                    ok = Get(argument.UInt);
+                    break;
+                case ArgumentType::Double:
+                    ok = Get(argument.Double);
+                    break;
+                case ArgumentType::Bool: {
+                    std::uint8_t value = 0;
+                    ok = Get(value);
+                    argument.UInt = value;
+                } break;
+                case ArgumentType::String:
+                    ok = GetString(argument.String);
+                    break;
+                case ArgumentType::ErrorCode:
+                    ok = (Get(argument.Code.Value) && Get(argument.Code.Domain));
+                    break;
+                }
+                if (!ok) {
+                    return false;
+                }
+                entry.Arguments.push_back(std::move(argument));
+            }
+            return true;
+        }
+
+    private:
+        const std::byte *m_data = nullptr;
+        const std::byte *m_end = nullptr;
+        std::size_t m_wcharSize = sizeof(wchar_t);
+    };
+
+    // Replaces each "{}" with the next argument, "{{" and "}}" are literal braces.
+    template<typename DescribeErrorCode>
+    [[nodiscard]] inline std::wstring Format(const std::wstring_view format, const std::vector<Argument> &arguments, const DescribeErrorCode &describe) noexcept
+    {
+        std::wstring result = {};
+        result.reserve(format.size());
+        std::size_t next = 0;
+        for (std::size_t index = 0; index < format.size(); ++index) {
+            const wchar_t ch = format[index];
+            const bool hasNext = ((index + 1) < format.size());
+            if ((ch == L'{') && hasNext && (format[index + 1] == L'{')) {
+                result += L'{';
+                ++index;
+            } else if ((ch == L'}') && hasNext && (format[index + 1] == L'}')) {
+                result += L'}';
+                ++index;
+            } else if ((ch == L'{') && hasNext && (format[index + 1] == L'}')) {
+                ++index;
+                if (next >= arguments.size()) {
+                    result += L"{?}";
+                    continue;
+                }
+                const Argument &argument = arguments[next++];
+                switch (argument.Type) {
+                case ArgumentType::Int:
+                    result += std::to_wstring(argument.Int);
+                    break;
+                case ArgumentType::UInt:
+                    result += std::to_wstring(argument.UInt);
+                    break;
+                case ArgumentType::Double:
+                    result += std::to_wstring(argument.Double);
+                    break;
+                case ArgumentType::Bool:
+                    result += ((argument.UInt != 0) ? L"true" : L"false");
+                    break;
+                case ArgumentType::Pointer: {
+                    static constexpr const wchar_t digits[] = L"0123456789ABCDEF";
+                    std::wstring hex = {};
+                    std::uint64_t value = argument.UInt;
+                    do {
+                        hex.insert(hex.begin(), digits[value & 0xF]);
+                        value >>= 4;
+                    } while (value != 0);
+                    result += L"0x" + hex;
+                } break;
+                case ArgumentType::String:
+                    result += argument.String;
+                    break;
+                case ArgumentType::ErrorCode:
+                    result += describe(argument.Code);
+                    break;
+                }
+            } else {
+                result += ch;
+            }
+        }
+        return result;
+    }
+} // namespace LogFormat
@@ -0,0 +1,150 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "MessageDispatcher.h"
+#include <algorithm>
+
+template<typename Iterator>
+[[nodiscard]] static inline Iterator FindFirstEntry(const Iterator first, const Iterator last, const UINT message) noexcept
+{
+    return std::lower_bound(first, last, message, [](const auto &entry, const UINT value){ return (entry.Message < value); });
+}
+
+MessageDispatcher::MessageDispatcher() noexcept = default;
+
+MessageDispatcher::~MessageDispatcher() noexcept = default;
+
+std::uint32_t MessageDispatcher::Subscribe(const UINT message, const MessageHandlerCallback &cb) noexcept
+{
+    if (!cb) {
+        return 0;
+    }
+    ++m_lastId;
+    if (m_lastId == 0) {
+        ++m_lastId;
+    }
+    Entry entry = {message, m_lastId, cb};
+    if (m_dispatching > 0) {
+        m_pending.push_back(std::move(entry));
+    } else {
+        Insert(std::move(entry));
+    }
+    return m_lastId;
+}
+
+void MessageDispatcher::Unsubscribe(const std::uint32_t id) noexcept
+{
+    if (id == 0) {
+        return;
+    }
+    const auto match = [id](const Entry &entry){ return (entry.Id == id); };
+    if (std::erase_if(m_pending, match) > 0) {
+        return;
+    }
+    const auto it = std::find_if(m_entries.begin(), m_entries.end(), match);
+    if (it == m_entries.end()) {
+        return;
+    }
+    if (m_dispatching > 0) {
+        // Only mark it, the entry may be running right now.
+        it->Id = 0;
+        m_dirty = true;
+    } else {
+        m_entries.erase(it);
+        RebuildFilter();
+    }
+}
+
+bool MessageDispatcher::Contains(const UINT message) const noexcept
+{
+    if (message < WM_USER) {
+        return m_filter.test(message);
+    }
+    const auto it = FindFirstEntry(m_entries.cbegin(), m_entries.cend(), message);
+    return ((it != m_entries.cend()) && (it->Message == message));
+}
+
+bool MessageDispatcher::Dispatch(const UINT message, const WPARAM wParam, const LPARAM lParam, LRESULT *result) noexcept
+{
+    if ((message < WM_USER) && !m_filter.test(message)) {
+        return false;
+    }
+    const auto first = FindFirstEntry(m_entries.cbegin(), m_entries.cend(), message);
+    if ((first == m_entries.cend()) || (first->Message != message)) {
+        return false;
+    }
+    // Indices instead of iterators: nothing is inserted or erased while
+    // dispatching, but a nested dispatch may still run the same entries.
+    const std::size_t begin = std::distance(m_entries.cbegin(), first);
+    const std::size_t end = m_entries.size();
+    bool handled = false;
+    ++m_dispatching;
+    for (std::size_t i = begin; (i != end) && (m_entries[i].Message == message); ++i) {
+        const Entry &entry = m_entries[i];
+        if ((entry.Id != 0) && entry.Callback(message, wParam, lParam, result)) {
+            handled = true;
+            break;
+        }
+    }
+    --m_dispatching;
+    if (m_dispatching == 0) {
+        Cleanup();
+    }
+    return handled;
+}
+
+void MessageDispatcher::Insert(Entry &&entry) noexcept
+{
+    // In front of the existing handlers of the same message.
+    const auto position = FindFirstEntry(m_entries.begin(), m_entries.end(), entry.Message);
+    if (entry.Message < WM_USER) {
+        m_filter.set(entry.Message);
+    }
+    m_entries.insert(position, std::move(entry));
+}
+
+void MessageDispatcher::Cleanup() noexcept
+{
+    if (m_dirty) {
+        m_dirty = false;
+        std::erase_if(m_entries, [](const Entry &entry){ return (entry.Id == 0); });
+        RebuildFilter();
+    }
+    if (!m_pending.empty()) {
+        for (auto &&entry : m_pending) {
+            Insert(std::move(entry));
+        }
+        m_pending.clear();
+    }
+}
+
+void MessageDispatcher::RebuildFilter() noexcept
+{
+    m_filter.reset();
+    for (auto &&entry : m_entries) {
+        if (entry.Message < WM_USER) {
+            m_filter.set(entry.Message);
+        }
+    }
+}
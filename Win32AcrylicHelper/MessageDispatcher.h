@@ -0,0 +1,85 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <SDKDDKVer.h>
+#include <Windows.h>
+#include <bitset>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+using MessageHandlerCallback = std::function<bool (const UINT, const WPARAM, const LPARAM, LRESULT *)>;
+
+// Maps window messages to chains of handlers. A window receives hundreds of
+// messages it doesn't care about, for those dispatching is a single bit test;
+// everything else is a binary search over the registered messages.
+//
+// Within a chain the latest subscriber runs first, just like window subclassing,
+// and the first handler returning true stops the chain. Handlers may subscribe
+// and unsubscribe freely, also while a message is being dispatched, new handlers
+// only see the messages dispatched after that.
+class MessageDispatcher
+{
+public:
+    explicit MessageDispatcher() noexcept;
+    ~MessageDispatcher() noexcept;
+
+    // Returns an id for "Unsubscribe()", never zero.
+    [[nodiscard]] std::uint32_t Subscribe(const UINT message, const MessageHandlerCallback &cb) noexcept;
+    void Unsubscribe(const std::uint32_t id) noexcept;
+
+    [[nodiscard]] bool Contains(const UINT message) const noexcept;
+    [[nodiscard]] bool Dispatch(const UINT message, const WPARAM wParam, const LPARAM lParam, LRESULT *result) noexcept;
+
+private:
+    MessageDispatcher(const MessageDispatcher &) = delete;
+    MessageDispatcher &operator=(const MessageDispatcher &) = delete;
+    MessageDispatcher(MessageDispatcher &&) = delete;
+    MessageDispatcher &operator=(MessageDispatcher &&) = delete;
+
+private:
+    struct Entry
+    {
+        UINT Message = 0;
+        std::uint32_t Id = 0; // Zero once unsubscribed during a dispatch.
+        MessageHandlerCallback Callback = nullptr;
+    };
+
+    void Insert(Entry &&entry) noexcept;
+    void Cleanup() noexcept;
+    void RebuildFilter() noexcept;
+
+private:
+    // Sorted by message, and by subscription order (newest first) within a message.
+    std::vector<Entry> m_entries = {};
+    // Subscribed while dispatching, the entries must not move until it's over.
+    std::vector<Entry> m_pending = {};
+    // One bit for each system message, everything above is rare enough to always search.
+    std::bitset<WM_USER> m_filter = {};
+    std::uint32_t m_lastId = 0;
+    UINT m_dispatching = 0; // Nesting depth, handlers may send messages themselves.
+    bool m_dirty = false;
+};
@@ -0,0 +1,298 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "MessageInstrumentation.h"
+#include "TimingService.h"
+#include "Utils.h"
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+#include <utility>
+
+namespace MessageInstrumentation
+{
+
+struct StageCounters
+{
+    std::atomic<std::uint64_t> Count = 0;
+    std::atomic<std::uint64_t> TotalTicks = 0;
+    std::array<std::atomic<std::uint64_t>, HistogramBucketCount> Histogram = {};
+};
+
+// The counters of this many message slots are allocated at once, about 8.7 KB.
+static constexpr const std::size_t SlotChunkSize = 16;
+static constexpr const std::size_t SlotChunkCount = ((MessageSlotCount + SlotChunkSize - 1) / SlotChunkSize);
+
+struct SlotChunk
+{
+    std::array<std::array<StageCounters, static_cast<std::size_t>(MessageStage::Count)>, SlotChunkSize> Slots = {};
+};
+
+// Slots are numbered in the order their messages are first dispatched (by any
+// thread, see "GetSlotIndex()") and their chunks are only allocated when used, so
+// a thread costs about 0.5 KB plus a chunk per 16 distinct messages it handles,
+// instead of the counters of every message below WM_USER.
+struct ThreadCounters
+{
+    std::array<std::atomic<SlotChunk *>, SlotChunkCount> Chunks = {};
+    ThreadCounters *Next = nullptr;
+};
+
+// Both clocks sampled at the first recorded message, used to find out the
+// frequency of the time stamp counter when taking a snapshot.
+struct CalibrationPoint
+{
+    std::uint64_t Ticks = 0;
+    std::uint64_t Counter = 0;
+};
+
+// All per-thread counter blocks ever created. They are never freed so that the
+// statistics of finished threads are still part of the final snapshot.
+static std::atomic<ThreadCounters *> g_threadCounters = nullptr;
+static thread_local ThreadCounters *t_threadCounters = nullptr;
+
+// The slot of each message plus one, zero until the message is first dispatched.
+static std::array<std::atomic<std::uint16_t>, MessageSlotCount> g_slotIndices = {};
+static std::uint16_t g_slotCount = 0;
+static std::mutex g_slotMutex = {};
+
+[[nodiscard]] static inline std::uint64_t GetPerformanceCounter() noexcept
+{
+    LARGE_INTEGER counter = {};
+    QueryPerformanceCounter(&counter);
+    return static_cast<std::uint64_t>(counter.QuadPart);
+}
+
+[[nodiscard]] static inline const CalibrationPoint &GetCalibrationPoint() noexcept
+{
+    static const CalibrationPoint point = { Now(), GetPerformanceCounter() };
+    return point;
+}
+
+[[nodiscard]] static inline std::uint64_t GetTicksPerSecond() noexcept
+{
+#if defined(_M_IX86) || defined(_M_X64)
+    const CalibrationPoint &start = GetCalibrationPoint();
+    const std::uint64_t ticks = (Now() - start.Ticks);
+    const std::uint64_t counter = (GetPerformanceCounter() - start.Counter);
+    if ((ticks == 0) || (counter == 0)) {
+        return 0;
+    }
+    const std::uint64_t frequency = static_cast<std::uint64_t>(TimingService::PerformanceFrequency());
+    // Split the conversion to avoid overflowing for long runs.
+    return (((ticks / counter) * frequency) + (((ticks % counter) * frequency) / counter));
+#else
+    return static_cast<std::uint64_t>(TimingService::PerformanceFrequency());
+#endif
+}
+
+[[nodiscard]] static inline ThreadCounters *GetThreadCounters() noexcept
+{
+    if (t_threadCounters) {
+        return t_threadCounters;
+    }
+    [[maybe_unused]] static const bool dumpRegistered = (std::atexit(Dump) == 0);
+    [[maybe_unused]] static const CalibrationPoint &calibrationPoint = GetCalibrationPoint();
+    const auto counters = new (std::nothrow) ThreadCounters;
+    if (!counters) {
+        return nullptr;
+    }
+    ThreadCounters *head = g_threadCounters.load(std::memory_order_relaxed);
+    do {
+        counters->Next = head;
+    } while (!g_threadCounters.compare_exchange_weak(head, counters, std::memory_order_release, std::memory_order_relaxed));
+    t_threadCounters = counters;
+    return counters;
+}
+
+[[nodiscard]] static inline std::size_t GetSlotIndex(const std::size_t message) noexcept
+{
+    std::atomic<std::uint16_t> &entry = g_slotIndices[message];
+    std::uint16_t index = entry.load(std::memory_order_relaxed);
+    if (index == 0) {
+        const std::scoped_lock lock(g_slotMutex);
+        index = entry.load(std::memory_order_relaxed);
+        if (index == 0) {
+            index = ++g_slotCount;
+            entry.store(index, std::memory_order_relaxed);
+        }
+    }
+    return (index - 1);
+}
+
+// Only the owning thread writes its own counters, so a plain load/store pair is
+// enough and we can avoid the locked read-modify-write instructions.
+static inline void Add(std::atomic<std::uint64_t> &counter, const std::uint64_t value) noexcept
+{
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+[[nodiscard]] static inline std::size_t BucketFromTicks(const std::uint64_t ticks) noexcept
+{
+    const auto width = static_cast<std::size_t>(std::bit_width(ticks));
+    return ((width == 0) ? 0 : std::min(width - 1, HistogramBucketCount - 1));
+}
+
+[[nodiscard]] static inline std::wstring StageName(const MessageStage stage) noexcept
+{
+    switch (stage) {
+    case MessageStage::WindowProc:
+        return L"WindowProc";
+    case MessageStage::CustomHandler:
+        return L"CustomHandler";
+    default:
+        break;
+    }
+    return L"Unknown";
+}
+
+[[nodiscard]] static inline std::wstring MessageName(const UINT message) noexcept
+{
+    if (message >= WM_USER) {
+        return L"WM_USER+";
+    }
+    wchar_t buffer[16] = { L'\0' };
+    swprintf_s(buffer, L"0x%04X", message);
+    return buffer;
+}
+
+void Record(const MessageStage stage, const UINT message, const std::uint64_t ticks) noexcept
+{
+    const auto stageIndex = static_cast<std::size_t>(stage);
+    if (stageIndex >= static_cast<std::size_t>(MessageStage::Count)) {
+        return;
+    }
+    const auto counters = GetThreadCounters();
+    if (!counters) {
+        return;
+    }
+    const std::size_t slotIndex = GetSlotIndex(std::min(static_cast<std::size_t>(message), MessageSlotCount - 1));
+    std::atomic<SlotChunk *> &chunkEntry = counters->Chunks[slotIndex / SlotChunkSize];
+    SlotChunk *chunk = chunkEntry.load(std::memory_order_relaxed);
+    if (!chunk) {
+        chunk = new (std::nothrow) SlotChunk;
+        if (!chunk) {
+            return;
+        }
+        chunkEntry.store(chunk, std::memory_order_release);
+    }
+    StageCounters &slot = chunk->Slots[slotIndex % SlotChunkSize][stageIndex];
+    Add(slot.Count, 1);
+    Add(slot.TotalTicks, ticks);
+    Add(slot.Histogram[BucketFromTicks(ticks)], 1);
+}
+
+MessageStatisticsSnapshot Snapshot() noexcept
+{
+    MessageStatisticsSnapshot snapshot = {};
+    snapshot.TicksPerSecond = GetTicksPerSecond();
+    const ThreadCounters *head = g_threadCounters.load(std::memory_order_acquire);
+    if (!head) {
+        return snapshot;
+    }
+    for (std::size_t message = 0; message != MessageSlotCount; ++message) {
+        const std::size_t entry = g_slotIndices[message].load(std::memory_order_relaxed);
+        if (entry == 0) {
+            continue;
+        }
+        const std::size_t slotIndex = (entry - 1);
+        for (std::size_t stage = 0; stage != static_cast<std::size_t>(MessageStage::Count); ++stage) {
+            MessageStatistics item = {};
+            item.Message = static_cast<UINT>(message);
+            item.Stage = static_cast<MessageStage>(stage);
+            for (auto counters = head; counters; counters = counters->Next) {
+                const SlotChunk * const chunk = counters->Chunks[slotIndex / SlotChunkSize].load(std::memory_order_acquire);
+                if (!chunk) {
+                    continue;
+                }
+                const StageCounters &slot = chunk->Slots[slotIndex % SlotChunkSize][stage];
+                item.Count += slot.Count.load(std::memory_order_relaxed);
+                item.TotalTicks += slot.TotalTicks.load(std::memory_order_relaxed);
+                for (std::size_t bucket = 0; bucket != HistogramBucketCount; ++bucket) {
+                    item.Histogram[bucket] += slot.Histogram[bucket].load(std::memory_order_relaxed);
+                }
+            }
+            if (item.Count != 0) {
+                snapshot.Messages.push_back(std::move(item));
+            }
+        }
+    }
+    return snapshot;
+}
+
+std::wstring ToCSV(const MessageStatisticsSnapshot &snapshot) noexcept
+{
+    std::wstring result = L"message,stage,count,total_ticks,ticks_per_second";
+    for (std::size_t bucket = 0; bucket != HistogramBucketCount; ++bucket) {
+        result += L",lt_" + std::to_wstring(std::uint64_t(2) << bucket) + L"ticks";
+    }
+    result += L'\n';
+    const std::wstring frequency = std::to_wstring(snapshot.TicksPerSecond);
+    for (auto &&item : std::as_const(snapshot.Messages)) {
+        result += MessageName(item.Message) + L',' + StageName(item.Stage) + L',' + std::to_wstring(item.Count)
+                + L',' + std::to_wstring(item.TotalTicks) + L',' + frequency;
+        for (auto &&count : std::as_const(item.Histogram)) {
+            result += L',' + std::to_wstring(count);
+        }
+        result += L'\n';
+    }
+    return result;
+}
+
+std::wstring ToJSON(const MessageStatisticsSnapshot &snapshot) noexcept
+{
+    std::wstring result = L"{\n  \"ticks_per_second\": " + std::to_wstring(snapshot.TicksPerSecond) + L",\n  \"messages\": [\n";
+    bool first = true;
+    for (auto &&item : std::as_const(snapshot.Messages)) {
+        if (!first) {
+            result += L",\n";
+        }
+        first = false;
+        result += L"    {\"message\": \"" + MessageName(item.Message) + L"\", \"stage\": \"" + StageName(item.Stage)
+                + L"\", \"count\": " + std::to_wstring(item.Count) + L", \"total_ticks\": " + std::to_wstring(item.TotalTicks)
+                + L", \"histogram\": [";
+        for (std::size_t bucket = 0; bucket != HistogramBucketCount; ++bucket) {
+            if (bucket != 0) {
+                result += L", ";
+            }
+            result += std::to_wstring(item.Histogram[bucket]);
+        }
+        result += L"]}";
+    }
+    result += L"\n  ]\n}\n";
+    return result;
+}
+
+void Dump() noexcept
+{
+    const MessageStatisticsSnapshot snapshot = Snapshot();
+    Utils::WriteReport(L"WIN32ACRYLICHELPER_MESSAGE_STATISTICS", [&snapshot](const ReportFormat format) -> std::wstring {
+        return ((format == ReportFormat::CSV) ? ToCSV(snapshot) : ToJSON(snapshot));
+    });
+}
+
+} // namespace MessageInstrumentation
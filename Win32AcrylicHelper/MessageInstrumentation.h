@@ -0,0 +1,123 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <SDKDDKVer.h>
+#include <Windows.h>
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#if defined(_M_IX86) || defined(_M_X64)
+#include <intrin.h>
+#endif
+
+// Optional per-message statistics of the window procedure. Only compiled in when
+// "WIN32ACRYLICHELPER_MESSAGE_INSTRUMENTATION" is defined, see "MESSAGE_INSTRUMENTATION_SCOPE()".
+// Durations are measured in time stamp counter ticks, converted when reported.
+namespace MessageInstrumentation
+{
+    // Bucket N counts the messages which took [2^N, 2^(N+1)) ticks.
+    [[maybe_unused]] constexpr const std::size_t HistogramBucketCount = 32;
+    // Messages from WM_USER on (registered ones included) share the last slot.
+    [[maybe_unused]] constexpr const std::size_t MessageSlotCount = (WM_USER + 1);
+
+    enum class MessageStage : int
+    {
+        WindowProc = 0, // The whole window procedure, including the stages below.
+        CustomHandler, // The user supplied "CustomMessageHandler()".
+        Count
+    };
+
+    struct MessageStatistics
+    {
+        UINT Message = 0; // WM_USER stands for every message from WM_USER on.
+        MessageStage Stage = MessageStage::WindowProc;
+        std::uint64_t Count = 0;
+        std::uint64_t TotalTicks = 0;
+        std::array<std::uint64_t, HistogramBucketCount> Histogram = {};
+    };
+
+    struct MessageStatisticsSnapshot
+    {
+        std::uint64_t TicksPerSecond = 0; // Measured against the performance counter.
+        std::vector<MessageStatistics> Messages = {}; // Only the messages seen at least once.
+    };
+
+    void Record(const MessageStage stage, const UINT message, const std::uint64_t ticks) noexcept;
+
+    [[nodiscard]] MessageStatisticsSnapshot Snapshot() noexcept;
+    [[nodiscard]] std::wstring ToCSV(const MessageStatisticsSnapshot &snapshot) noexcept;
+    [[nodiscard]] std::wstring ToJSON(const MessageStatisticsSnapshot &snapshot) noexcept;
+
+    // Writes the snapshot to the file named by the "WIN32ACRYLICHELPER_MESSAGE_STATISTICS"
+    // environment variable (CSV if it ends with ".csv", JSON otherwise), or to the
+    // debugger output if the variable is not set. Called automatically at exit.
+    void Dump() noexcept;
+
+    [[nodiscard]] inline std::uint64_t Now() noexcept
+    {
+#if defined(_M_IX86) || defined(_M_X64)
+        return __rdtsc();
+#else
+        // No time stamp counter to read directly, the performance counter is the next best thing.
+        LARGE_INTEGER counter = {};
+        QueryPerformanceCounter(&counter);
+        return static_cast<std::uint64_t>(counter.QuadPart);
+#endif
+    }
+
+    class ScopeTimer
+    {
+    public:
+        inline explicit ScopeTimer(const MessageStage stage, const UINT message) noexcept : m_stage(stage), m_message(message), m_start(Now()) {}
+        inline ~ScopeTimer() noexcept {
+            Record(m_stage, m_message, (Now() - m_start));
+        }
+
+    private:
+        ScopeTimer(const ScopeTimer &) = delete;
+        ScopeTimer &operator=(const ScopeTimer &) = delete;
+        ScopeTimer(ScopeTimer &&) = delete;
+        ScopeTimer &operator=(ScopeTimer &&) = delete;
+
+    private:
+        MessageStage m_stage = MessageStage::WindowProc;
+        UINT m_message = 0;
+        std::uint64_t m_start = 0;
+    };
+} // namespace MessageInstrumentation
+
+// Times the rest of the enclosing scope. Expands to nothing unless the
+// instrumentation is enabled, so there's no cost at all otherwise.
+#ifndef MESSAGE_INSTRUMENTATION_SCOPE
+#ifdef WIN32ACRYLICHELPER_MESSAGE_INSTRUMENTATION
+#define MESSAGE_INSTRUMENTATION_SCOPE(stage, message) \
+    const MessageInstrumentation::ScopeTimer __messageInstrumentationScopeTimer(MessageInstrumentation::MessageStage::stage, message);
+#else // WIN32ACRYLICHELPER_MESSAGE_INSTRUMENTATION
+#define MESSAGE_INSTRUMENTATION_SCOPE(stage, message)
+#endif // WIN32ACRYLICHELPER_MESSAGE_INSTRUMENTATION
+#endif // MESSAGE_INSTRUMENTATION_SCOPE
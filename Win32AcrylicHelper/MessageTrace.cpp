@@ -0,0 +1,310 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "MessageTrace.h"
+#include "MessageTraceFormat.hpp"
+#include "OperationResult.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <vector>
+
+static_assert(MessageTraceFormat::Messages::Move == WM_MOVE);
+static_assert(MessageTraceFormat::Messages::Size == WM_SIZE);
+static_assert(MessageTraceFormat::Messages::WindowPosChanging == WM_WINDOWPOSCHANGING);
+static_assert(MessageTraceFormat::Messages::WindowPosChanged == WM_WINDOWPOSCHANGED);
+static_assert(MessageTraceFormat::Messages::NcCalcSize == WM_NCCALCSIZE);
+static_assert(MessageTraceFormat::Messages::NcHitTest == WM_NCHITTEST);
+static_assert(MessageTraceFormat::Messages::EnterSizeMove == WM_ENTERSIZEMOVE);
+static_assert(MessageTraceFormat::Messages::ExitSizeMove == WM_EXITSIZEMOVE);
+static_assert(MessageTraceFormat::Messages::DpiChanged == WM_DPICHANGED);
+static_assert(sizeof(MessageTraceFormat::HitTestGeometryEntry) == 32);
+
+// Written out whenever this much has been recorded.
+static constexpr const std::size_t FlushThreshold = (64 * 1024);
+
+class MessageTraceOutput
+{
+public:
+    explicit MessageTraceOutput() noexcept;
+    ~MessageTraceOutput() noexcept;
+
+    [[nodiscard]] bool Start(const std::wstring &path) noexcept;
+    void Stop() noexcept;
+    void RecordMessage(const HWND hWnd, const UINT message, const WPARAM wParam, const LPARAM lParam) noexcept;
+    void RecordHitTestGeometry(const HWND hWnd, const POINT origin, const HitTestGeometry &geometry) noexcept;
+
+    std::atomic<bool> Recording = false;
+
+private:
+    MessageTraceOutput(const MessageTraceOutput &) = delete;
+    MessageTraceOutput &operator=(const MessageTraceOutput &) = delete;
+    MessageTraceOutput(MessageTraceOutput &&) = delete;
+    MessageTraceOutput &operator=(MessageTraceOutput &&) = delete;
+
+private:
+    [[nodiscard]] std::uint64_t Timestamp() const noexcept;
+    [[nodiscard]] std::uint32_t WindowIndex(const HWND hWnd) noexcept;
+    void Flush() noexcept;
+
+private:
+    std::mutex m_mutex = {};
+    std::FILE *m_file = nullptr;
+    std::vector<std::byte> m_buffer = {};
+    std::vector<HWND> m_windows = {}; // Handles are recorded as indices into this.
+    std::chrono::steady_clock::time_point m_start = {};
+};
+
+[[nodiscard]] static inline MessageTraceOutput &GetMessageTraceOutput() noexcept
+{
+    // Leaked on purpose, windows may still receive messages during the static destruction.
+    static MessageTraceOutput * const output = new MessageTraceOutput;
+    return *output;
+}
+
+MessageTraceOutput::MessageTraceOutput() noexcept
+{
+    const wchar_t * const path = _wgetenv(L"WIN32ACRYLICHELPER_MESSAGE_TRACE");
+    if (path && (path[0] != L'\0')) {
+        if (!Start(path)) {
+            LOG_ERROR(L"Failed to start recording the message trace.");
+        }
+    }
+}
+
+MessageTraceOutput::~MessageTraceOutput() noexcept
+{
+    Stop();
+}
+
+bool MessageTraceOutput::Start(const std::wstring &path) noexcept
+{
+    if (path.empty()) {
+        return false;
+    }
+    const std::scoped_lock lock(m_mutex);
+    if (m_file) {
+        return false;
+    }
+    m_file = _wfopen(path.c_str(), L"wb");
+    if (!m_file) {
+        return false;
+    }
+    std::fwrite(MessageTraceFormat::Magic, sizeof(MessageTraceFormat::Magic), 1, m_file);
+    std::fwrite(&MessageTraceFormat::Version, sizeof(MessageTraceFormat::Version), 1, m_file);
+    m_buffer.reserve(FlushThreshold + sizeof(MessageTraceFormat::Entry));
+    m_windows.clear();
+    m_start = std::chrono::steady_clock::now();
+    Recording.store(true, std::memory_order_release);
+    return true;
+}
+
+void MessageTraceOutput::Stop() noexcept
+{
+    const std::scoped_lock lock(m_mutex);
+    Recording.store(false, std::memory_order_release);
+    if (!m_file) {
+        return;
+    }
+    Flush();
+    std::fclose(m_file);
+    m_file = nullptr;
+}
+
+void MessageTraceOutput::RecordMessage(const HWND hWnd, const UINT message, const WPARAM wParam, const LPARAM lParam) noexcept
+{
+    using namespace MessageTraceFormat;
+    const std::uint64_t timestamp = Timestamp();
+    const std::scoped_lock lock(m_mutex);
+    if (!m_file) {
+        return;
+    }
+    NcCalcSizeParams params = {};
+    PayloadType payload = PayloadType::None;
+    const auto toRect = [](const RECT &rect) -> Rect {
+        return {rect.left, rect.top, rect.right, rect.bottom};
+    };
+    const auto toWindowPos = [](const WINDOWPOS &pos) -> WindowPos {
+        return {pos.x, pos.y, pos.cx, pos.cy, pos.flags};
+    };
+    if (lParam != 0) {
+        switch (message) {
+        case WM_NCCALCSIZE: {
+            if (wParam != FALSE) {
+                const auto ncParams = reinterpret_cast<const NCCALCSIZE_PARAMS *>(lParam);
+                for (int i = 0; i != 3; ++i) {
+                    params.Rects[i] = toRect(ncParams->rgrc[i]);
+                }
+                if (ncParams->lppos) {
+                    params.Position = toWindowPos(*ncParams->lppos);
+                }
+                payload = PayloadType::NcCalcSize;
+            } else {
+                params.Rects[0] = toRect(*reinterpret_cast<const RECT *>(lParam));
+                payload = PayloadType::Rect;
+            }
+        } break;
+        case WM_DPICHANGED: {
+            params.Rects[0] = toRect(*reinterpret_cast<const RECT *>(lParam));
+            payload = PayloadType::Rect;
+        } break;
+        case WM_WINDOWPOSCHANGING:
+        case WM_WINDOWPOSCHANGED: {
+            params.Position = toWindowPos(*reinterpret_cast<const WINDOWPOS *>(lParam));
+            payload = PayloadType::WindowPos;
+        } break;
+        default:
+            break;
+        }
+    }
+    Put(m_buffer, EntryKind::Message);
+    Put(m_buffer, timestamp);
+    Put(m_buffer, WindowIndex(hWnd));
+    Put(m_buffer, static_cast<std::uint32_t>(message));
+    Put(m_buffer, static_cast<std::uint64_t>(wParam));
+    Put(m_buffer, static_cast<std::uint64_t>(lParam));
+    Put(m_buffer, payload);
+    switch (payload) {
+    case PayloadType::Rect:
+        Put(m_buffer, params.Rects[0]);
+        break;
+    case PayloadType::WindowPos:
+        Put(m_buffer, params.Position);
+        break;
+    case PayloadType::NcCalcSize:
+        Put(m_buffer, params);
+        break;
+    default:
+        break;
+    }
+    if (m_buffer.size() >= FlushThreshold) {
+        Flush();
+    }
+}
+
+void MessageTraceOutput::RecordHitTestGeometry(const HWND hWnd, const POINT origin, const HitTestGeometry &geometry) noexcept
+{
+    using namespace MessageTraceFormat;
+    const std::uint64_t timestamp = Timestamp();
+    const std::scoped_lock lock(m_mutex);
+    if (!m_file) {
+        return;
+    }
+    HitTestGeometryEntry entry = {};
+    entry.OriginX = origin.x;
+    entry.OriginY = origin.y;
+    entry.Width = geometry.Width;
+    entry.Height = geometry.Height;
+    entry.ResizeBorderThicknessX = geometry.ResizeBorderThicknessX;
+    entry.ResizeBorderThicknessY = geometry.ResizeBorderThicknessY;
+    entry.TitleBarHeight = geometry.TitleBarHeight;
+    entry.HasTitleBar = (geometry.HasTitleBar ? 1 : 0);
+    entry.ResizableTop = (geometry.ResizableTop ? 1 : 0);
+    entry.ResizableEdges = (geometry.ResizableEdges ? 1 : 0);
+    Put(m_buffer, EntryKind::HitTestGeometry);
+    Put(m_buffer, timestamp);
+    Put(m_buffer, WindowIndex(hWnd));
+    Put(m_buffer, entry);
+    if (m_buffer.size() >= FlushThreshold) {
+        Flush();
+    }
+}
+
+std::uint64_t MessageTraceOutput::Timestamp() const noexcept
+{
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_start).count());
+}
+
+std::uint32_t MessageTraceOutput::WindowIndex(const HWND hWnd) noexcept
+{
+    // A handful of windows at most, no need for anything smarter.
+    for (std::size_t i = 0; i != m_windows.size(); ++i) {
+        if (m_windows[i] == hWnd) {
+            return static_cast<std::uint32_t>(i);
+        }
+    }
+    m_windows.push_back(hWnd);
+    return static_cast<std::uint32_t>(m_windows.size() - 1);
+}
+
+void MessageTraceOutput::Flush() noexcept
+{
+    if (m_file && !m_buffer.empty()) {
+        if (std::fwrite(m_buffer.data(), 1, m_buffer.size(), m_file) != m_buffer.size()) {
+            LOG_ERROR(L"Failed to write the message trace.");
+        }
+    }
+    m_buffer.clear();
+}
+
+// Writes out the rest of the trace when the process exits normally.
+class MessageTraceExitGuard
+{
+public:
+    inline explicit MessageTraceExitGuard() noexcept = default;
+    inline ~MessageTraceExitGuard() noexcept
+    {
+        MessageTrace::Stop();
+    }
+
+private:
+    MessageTraceExitGuard(const MessageTraceExitGuard &) = delete;
+    MessageTraceExitGuard &operator=(const MessageTraceExitGuard &) = delete;
+    MessageTraceExitGuard(MessageTraceExitGuard &&) = delete;
+    MessageTraceExitGuard &operator=(MessageTraceExitGuard &&) = delete;
+};
+
+static const MessageTraceExitGuard g_exitGuard;
+
+bool MessageTrace::Start(const std::wstring &path) noexcept
+{
+    return GetMessageTraceOutput().Start(path);
+}
+
+void MessageTrace::Stop() noexcept
+{
+    GetMessageTraceOutput().Stop();
+}
+
+bool MessageTrace::Recording() noexcept
+{
+    return GetMessageTraceOutput().Recording.load(std::memory_order_relaxed);
+}
+
+void MessageTrace::RecordMessage(const HWND hWnd, const UINT message, const WPARAM wParam, const LPARAM lParam) noexcept
+{
+    MessageTraceOutput &output = GetMessageTraceOutput();
+    if (output.Recording.load(std::memory_order_relaxed)) {
+        output.RecordMessage(hWnd, message, wParam, lParam);
+    }
+}
+
+void MessageTrace::RecordHitTestGeometry(const HWND hWnd, const POINT origin, const HitTestGeometry &geometry) noexcept
+{
+    MessageTraceOutput &output = GetMessageTraceOutput();
+    if (output.Recording.load(std::memory_order_relaxed)) {
+        output.RecordHitTestGeometry(hWnd, origin, geometry);
+    }
+}
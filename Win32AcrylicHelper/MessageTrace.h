@@ -0,0 +1,47 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <SDKDDKVer.h>
+#include <Windows.h>
+#include <string>
+#include "HitTestMap.hpp"
+
+// Records the messages of the windows, with timestamps and the structures some of
+// them point to, for replaying them without a desktop ("MessageTraceReplay").
+// Recording starts with "Start()", or right away if the environment variable
+// "WIN32ACRYLICHELPER_MESSAGE_TRACE" names a file. While not recording, every call
+// is a single atomic load.
+namespace MessageTrace
+{
+    [[nodiscard]] bool Start(const std::wstring &path) noexcept;
+    // Writes out everything recorded so far and closes the file.
+    void Stop() noexcept;
+    [[nodiscard]] bool Recording() noexcept;
+
+    // Must be called before the message is handled, the structures may change meanwhile.
+    void RecordMessage(const HWND hWnd, const UINT message, const WPARAM wParam, const LPARAM lParam) noexcept;
+    void RecordHitTestGeometry(const HWND hWnd, const POINT origin, const HitTestGeometry &geometry) noexcept;
+} // namespace MessageTrace
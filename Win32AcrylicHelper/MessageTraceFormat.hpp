@@ -0,0 +1,199 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+// The binary format of the message traces written by "MessageTrace.h". Deliberately
+// free of any Windows dependency, the replay tool has to build everywhere.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace MessageTraceFormat
+{
+    // File header: magic, version (uint32).
+    [[maybe_unused]] constexpr const char Magic[8] = { 'W', '3', '2', 'A', 'M', 'T', 'R', '\0' };
+    [[maybe_unused]] constexpr const std::uint32_t Version = 1;
+
+    // The messages the replay knows about. Window message values are part of the
+    // Windows ABI, the recorder makes sure they match.
+    namespace Messages
+    {
+        [[maybe_unused]] constexpr const std::uint32_t Move = 0x0003;
+        [[maybe_unused]] constexpr const std::uint32_t Size = 0x0005;
+        [[maybe_unused]] constexpr const std::uint32_t WindowPosChanging = 0x0046;
+        [[maybe_unused]] constexpr const std::uint32_t WindowPosChanged = 0x0047;
+        [[maybe_unused]] constexpr const std::uint32_t NcCalcSize = 0x0083;
+        [[maybe_unused]] constexpr const std::uint32_t NcHitTest = 0x0084;
+        [[maybe_unused]] constexpr const std::uint32_t EnterSizeMove = 0x0231;
+        [[maybe_unused]] constexpr const std::uint32_t ExitSizeMove = 0x0232;
+        [[maybe_unused]] constexpr const std::uint32_t DpiChanged = 0x02E0;
+    } // namespace Messages
+
+    enum class EntryKind : std::uint8_t
+    {
+        // timestamp in nanoseconds since the start (uint64), window (uint32), message (uint32),
+        // wParam (uint64), lParam (uint64), payload type (uint8), payload
+        Message = 1,
+        // timestamp (uint64), window (uint32), a "HitTestGeometryEntry"
+        HitTestGeometry = 2
+    };
+
+    // The structure lParam points to, if the message has one worth keeping.
+    enum class PayloadType : std::uint8_t
+    {
+        None = 0,
+        Rect = 1, // A "Rect": WM_NCCALCSIZE without wParam, the suggested rectangle of WM_DPICHANGED.
+        WindowPos = 2, // A "WindowPos": WM_WINDOWPOSCHANGING and WM_WINDOWPOSCHANGED.
+        NcCalcSize = 3 // Three "Rect"s and a "WindowPos": WM_NCCALCSIZE with wParam.
+    };
+
+    struct Rect
+    {
+        std::int32_t Left = 0;
+        std::int32_t Top = 0;
+        std::int32_t Right = 0;
+        std::int32_t Bottom = 0;
+    };
+
+    // Without the window handles, they are meaningless outside of the session.
+    struct WindowPos
+    {
+        std::int32_t X = 0;
+        std::int32_t Y = 0;
+        std::int32_t Width = 0;
+        std::int32_t Height = 0;
+        std::uint32_t Flags = 0;
+    };
+
+    struct NcCalcSizeParams
+    {
+        Rect Rects[3] = {};
+        WindowPos Position = {};
+    };
+
+    // What the window based its hit testing on, recorded whenever that changes.
+    struct HitTestGeometryEntry
+    {
+        std::int32_t OriginX = 0; // The client area origin, in screen coordinates.
+        std::int32_t OriginY = 0;
+        std::int32_t Width = 0;
+        std::int32_t Height = 0;
+        std::int32_t ResizeBorderThicknessX = 0;
+        std::int32_t ResizeBorderThicknessY = 0;
+        std::int32_t TitleBarHeight = 0;
+        std::uint8_t HasTitleBar = 0;
+        std::uint8_t ResizableTop = 0;
+        std::uint8_t ResizableEdges = 0;
+        std::uint8_t Reserved = 0; // No padding, the structure is written as it is.
+    };
+
+    struct MessageEntry
+    {
+        std::uint64_t Timestamp = 0;
+        std::uint32_t Window = 0;
+        std::uint32_t Message = 0;
+        std::uint64_t WParam = 0;
+        std::uint64_t LParam = 0;
+        PayloadType Payload = PayloadType::None;
+        NcCalcSizeParams Params = {}; // "Rects[0]" holds a lonely "Rect", "Position" a lonely "WindowPos".
+    };
+
+    struct Entry
+    {
+        EntryKind Kind = EntryKind::Message;
+        MessageEntry Message = {};
+        HitTestGeometryEntry Geometry = {}; // Only for "EntryKind::HitTestGeometry", with "Message.Timestamp" and "Message.Window".
+    };
+
+    template<typename T>
+    inline void Put(std::vector<std::byte> &buffer, const T &value) noexcept
+    {
+        const std::size_t offset = buffer.size();
+        buffer.resize(offset + sizeof(T));
+        std::memcpy(buffer.data() + offset, &value, sizeof(T));
+    }
+
+    // Reads the entries back, the structures are stored as they are in memory.
+    class Reader
+    {
+    public:
+        inline explicit Reader(const std::byte *data, const std::size_t size) noexcept
+            : m_data(data), m_end(data + size) {}
+        inline ~Reader() noexcept = default;
+
+        [[nodiscard]] inline bool AtEnd() const noexcept {
+            return (m_data >= m_end);
+        }
+
+        template<typename T>
+        [[nodiscard]] inline bool Get(T &value) noexcept {
+            if (static_cast<std::size_t>(m_end - m_data) < sizeof(T)) {
+                return false;
+            }
+            std::memcpy(&value, m_data, sizeof(T));
+            m_data += sizeof(T);
+            return true;
+        }
+
+        [[nodiscard]] inline bool GetEntry(Entry &entry) noexcept {
+            if (!Get(entry.Kind) || !Get(entry.Message.Timestamp) || !Get(entry.Message.Window)) {
+                return false;
+            }
+            if (entry.Kind == EntryKind::HitTestGeometry) {
+                return Get(entry.Geometry);
+            }
+            if (entry.Kind != EntryKind::Message) {
+                return false;
+            }
+            MessageEntry &message = entry.Message;
+            if (!Get(message.Message) || !Get(message.WParam) || !Get(message.LParam) || !Get(message.Payload)) {
+                return false;
+            }
+            switch (message.Payload) {
+            case PayloadType::None:
+                return true;
+            case PayloadType::Rect:
+                return Get(message.Params.Rects[0]);
+            case PayloadType::WindowPos:
+                return Get(message.Params.Position);
+            case PayloadType::NcCalcSize:
+                return Get(message.Params);
+            }
+            return false;
+        }
+
+    private:
+        Reader(const Reader &) = delete;
+        Reader &operator=(const Reader &) = delete;
+        Reader(Reader &&) = delete;
+        Reader &operator=(Reader &&) = delete;
+
+    private:
+        const std::byte *m_data = nullptr;
+        const std::byte *m_end = nullptr;
+    };
+} // namespace MessageTraceFormat
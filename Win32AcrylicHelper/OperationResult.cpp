@@ -24,126 +24,47 @@
 
 #include "OperationResult.h"
 #include "Utils.h"
-
-class OperationResultPrivate
-{
-public:
-    explicit OperationResultPrivate(OperationResult *q) noexcept;
-    ~OperationResultPrivate() noexcept;
-
-    [[nodiscard]] bool Succeeded() const noexcept;
-
-    [[nodiscard]] bool Failed() const noexcept;
-
-    [[nodiscard]] DWORD Code() const noexcept;
-    void Code(const DWORD code) noexcept;
-
-    [[nodiscard]] std::wstring Message() const noexcept;
-
-private:
-    void TryQueryErrorMessageFromSystem() noexcept;
-
-private:
-    OperationResultPrivate(const OperationResultPrivate &) = delete;
-    OperationResultPrivate &operator=(const OperationResultPrivate &) = delete;
-    OperationResultPrivate(OperationResultPrivate &&) = delete;
-    OperationResultPrivate &operator=(OperationResultPrivate &&) = delete;
-
-private:
-    OperationResult *q_ptr = nullptr;
-    DWORD m_code = 0;
-    std::wstring m_message = {};
-};
-
-OperationResultPrivate::OperationResultPrivate(OperationResult *q) noexcept
-{
-    q_ptr = q;
-}
-
-OperationResultPrivate::~OperationResultPrivate() noexcept = default;
-
-bool OperationResultPrivate::Succeeded() const noexcept
-{
-    return (m_code == ERROR_SUCCESS);
-}
-
-bool OperationResultPrivate::Failed() const noexcept
-{
-    return (m_code != ERROR_SUCCESS);
-}
-
-DWORD OperationResultPrivate::Code() const noexcept
-{
-    return m_code;
-}
-
-void OperationResultPrivate::Code(const DWORD code) noexcept
-{
-    if (m_code != code) {
-        m_code = code;
-        TryQueryErrorMessageFromSystem();
+#include <unordered_map>
+#include <shared_mutex>
+#include <mutex>
+
+// Error messages shared by the whole process, most codes are looked up more than once.
+static std::shared_mutex g_errorMessagesMutex = {};
+static std::unordered_map<DWORD, std::wstring> g_errorMessages = {};
+
+[[nodiscard]] static inline std::wstring GetErrorMessageFromSystem(const DWORD code) noexcept
+{
+    {
+        const std::shared_lock lock(g_errorMessagesMutex);
+        const auto search = g_errorMessages.find(code);
+        if (search != g_errorMessages.cend()) {
+            return search->second;
+        }
     }
-}
-
-std::wstring OperationResultPrivate::Message() const noexcept
-{
-    return m_message;
-}
-
-void OperationResultPrivate::TryQueryErrorMessageFromSystem() noexcept
-{
+    // Don't hold the lock while formatting, the error dialog below may take a while.
+    std::wstring message = {};
     LPWSTR buf = nullptr;
     if (FormatMessageW(FORMAT_MESSAGE_ALLOCATE_BUFFER | FORMAT_MESSAGE_FROM_SYSTEM | FORMAT_MESSAGE_IGNORE_INSERTS,
-                       nullptr, m_code, MAKELANGID(LANG_NEUTRAL, SUBLANG_DEFAULT), reinterpret_cast<LPWSTR>(&buf), 0, nullptr) == 0) {
+                       nullptr, code, MAKELANGID(LANG_NEUTRAL, SUBLANG_DEFAULT), reinterpret_cast<LPWSTR>(&buf), 0, nullptr) == 0) {
         Utils::DisplayErrorDialog(L"Failed to retrieve error message from system.");
     } else {
-        m_message = buf;
+        message = buf;
         LocalFree(buf);
     }
-}
-
-OperationResult::OperationResult(const DWORD code) noexcept
-{
-    d_ptr = std::make_unique<OperationResultPrivate>(this);
-    d_ptr->Code(code);
-}
-
-OperationResult::OperationResult(const HRESULT hr) noexcept : OperationResult(CODE_FROM_HRESULT(hr))
-{
-}
-
-OperationResult::OperationResult() noexcept : OperationResult(GetLastError())
-{
-}
-
-OperationResult::~OperationResult() noexcept = default;
-
-bool OperationResult::Succeeded() const noexcept
-{
-    return d_ptr->Succeeded();
-}
-
-bool OperationResult::Failed() const noexcept
-{
-    return d_ptr->Failed();
-}
-
-DWORD OperationResult::Code() const noexcept
-{
-    return d_ptr->Code();
+    // Failures are cached as well, an empty message is what the callers get anyway.
+    const std::unique_lock lock(g_errorMessagesMutex);
+    return g_errorMessages.insert({code, message}).first->second;
 }
 
 std::wstring OperationResult::Message() const noexcept
 {
-    return d_ptr->Message();
-}
-
-OperationResult OperationResult::FromWin32(const DWORD code) noexcept
-{
-    return OperationResult(code);
-}
-
-OperationResult OperationResult::FromHResult(const HRESULT hr) noexcept
-{
-    return OperationResult(hr);
+    if (Succeeded()) {
+        return {};
+    }
+    // Formatted on demand: most results are checked for success only.
+    // The system knows the full HRESULTs of the other facilities, but not their code parts.
+    if ((m_domain == OperationResultDomain::HResult) && (HRESULT_FACILITY(static_cast<HRESULT>(m_value)) != FACILITY_WIN32)) {
+        return GetErrorMessageFromSystem(m_value);
+    }
+    return GetErrorMessageFromSystem(Code());
 }
@@ -27,66 +27,93 @@
 #include <SDKDDKVer.h>
 #include <Windows.h>
 #include <string>
-#include <memory>
+#include <type_traits>
+#include "Log.h"
 
-class OperationResultPrivate;
+enum class OperationResultDomain : int
+{
+    Win32 = 0,
+    HResult = 1
+};
 
+// A plain value, the message is looked up (and cached) on demand only.
 class OperationResult
 {
 public:
-    explicit OperationResult(const DWORD code) noexcept;
-    explicit OperationResult(const HRESULT hr) noexcept;
-    explicit OperationResult() noexcept;
-    ~OperationResult() noexcept;
+    inline explicit constexpr OperationResult(const DWORD code) noexcept : m_value(code), m_domain(OperationResultDomain::Win32) {}
+    inline explicit constexpr OperationResult(const HRESULT hr) noexcept : m_value(static_cast<DWORD>(hr)), m_domain(OperationResultDomain::HResult) {}
+    inline explicit OperationResult() noexcept : OperationResult(GetLastError()) {}
+    inline ~OperationResult() noexcept = default;
 
-    [[nodiscard]] bool Succeeded() const noexcept;
-    [[nodiscard]] bool Failed() const noexcept;
-    [[nodiscard]] DWORD Code() const noexcept;
+    inline constexpr OperationResult(const OperationResult &) noexcept = default;
+    inline constexpr OperationResult &operator=(const OperationResult &) noexcept = default;
+
+    [[nodiscard]] inline constexpr OperationResultDomain Domain() const noexcept {
+        return m_domain;
+    }
+    // The original value, i.e. the HRESULT itself for the HResult domain.
+    [[nodiscard]] inline constexpr DWORD Value() const noexcept {
+        return m_value;
+    }
+    [[nodiscard]] inline constexpr bool Succeeded() const noexcept {
+        if (m_domain == OperationResultDomain::HResult) {
+            return (static_cast<HRESULT>(m_value) >= 0);
+        }
+        return (m_value == ERROR_SUCCESS);
+    }
+    [[nodiscard]] inline constexpr bool Failed() const noexcept {
+        return !Succeeded();
+    }
+    // Always a Win32 error code, the HRESULTs are reduced to their code part.
+    [[nodiscard]] inline constexpr DWORD Code() const noexcept {
+        if (m_domain == OperationResultDomain::HResult) {
+            return static_cast<DWORD>(HRESULT_CODE(static_cast<HRESULT>(m_value)));
+        }
+        return m_value;
+    }
     [[nodiscard]] std::wstring Message() const noexcept;
 
-    [[nodiscard]] static OperationResult FromWin32(const DWORD code) noexcept;
-    [[nodiscard]] static OperationResult FromHResult(const HRESULT hr) noexcept;
+    [[nodiscard]] inline static constexpr OperationResult FromWin32(const DWORD code) noexcept {
+        return OperationResult(code);
+    }
+    [[nodiscard]] inline static constexpr OperationResult FromHResult(const HRESULT hr) noexcept {
+        return OperationResult(hr);
+    }
 
-    [[nodiscard]] inline friend bool operator==(const OperationResult &lhs, const OperationResult &rhs) noexcept {
+    [[nodiscard]] inline friend constexpr bool operator==(const OperationResult &lhs, const OperationResult &rhs) noexcept {
         return (lhs.Code() == rhs.Code());
     }
-    [[nodiscard]] inline friend bool operator!=(const OperationResult &lhs, const OperationResult &rhs) noexcept {
+    [[nodiscard]] inline friend constexpr bool operator!=(const OperationResult &lhs, const OperationResult &rhs) noexcept {
         return (lhs.Code() != rhs.Code());
     }
-    [[nodiscard]] inline friend bool operator>(const OperationResult &lhs, const OperationResult &rhs) noexcept {
+    [[nodiscard]] inline friend constexpr bool operator>(const OperationResult &lhs, const OperationResult &rhs) noexcept {
         return (lhs.Code() > rhs.Code());
     }
-    [[nodiscard]] inline friend bool operator<(const OperationResult &lhs, const OperationResult &rhs) noexcept {
+    [[nodiscard]] inline friend constexpr bool operator<(const OperationResult &lhs, const OperationResult &rhs) noexcept {
         return (lhs.Code() < rhs.Code());
     }
-    [[nodiscard]] inline friend bool operator>=(const OperationResult &lhs, const OperationResult &rhs) noexcept {
+    [[nodiscard]] inline friend constexpr bool operator>=(const OperationResult &lhs, const OperationResult &rhs) noexcept {
         return ((lhs > rhs) || (lhs == rhs));
     }
-    [[nodiscard]] inline friend bool operator<=(const OperationResult &lhs, const OperationResult &rhs) noexcept {
+    [[nodiscard]] inline friend constexpr bool operator<=(const OperationResult &lhs, const OperationResult &rhs) noexcept {
         return ((lhs < rhs) || (lhs == rhs));
     }
 
 private:
-    OperationResult(const OperationResult &) = delete;
-    OperationResult &operator=(const OperationResult &) = delete;
-    OperationResult(OperationResult &&) = delete;
-    OperationResult &operator=(OperationResult &&) = delete;
-
-private:
-    std::unique_ptr<OperationResultPrivate> d_ptr;
+    DWORD m_value = ERROR_SUCCESS;
+    OperationResultDomain m_domain = OperationResultDomain::Win32;
 };
 
+static_assert(std::is_trivially_copyable_v<OperationResult>);
+static_assert(sizeof(OperationResult) <= sizeof(unsigned long long));
+
+// Only the error code is recorded, the system message is looked up when the log is
+// formatted. "additionalMessage" must be a string literal.
 #ifndef __PRINT_SYSTEM_ERROR_MESSAGE
 #define __PRINT_SYSTEM_ERROR_MESSAGE(function, additionalMessage) \
 if (__operation_result.Failed()) { \
-    const std::wstring __error_message_from_system = __operation_result.Message(); \
-    std::wstring __final_error_message = std::wstring(L"Function \"") + std::wstring(L#function) + std::wstring(L"()\" failed with error code ") + std::to_wstring(__operation_result.Code()) + std::wstring(L": "); \
-    if (__error_message_from_system.empty()) { \
-        __final_error_message += std::wstring(additionalMessage); \
-    } else { \
-        __final_error_message += __error_message_from_system; \
-    } \
-    Utils::DisplayErrorDialog(__final_error_message); \
+    LOG_ERROR(L"Function \"" L#function L"()\" failed with error code {}: " additionalMessage, \
+              LogFormat::ErrorCode{ static_cast<std::uint32_t>(__operation_result.Value()), static_cast<std::uint8_t>(__operation_result.Domain()) }); \
 }
 #endif
 
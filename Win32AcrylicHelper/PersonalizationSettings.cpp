@@ -0,0 +1,75 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "PersonalizationSettings.h"
+
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free);
+
+PersonalizationSettings::PersonalizationSettings(SettingsBackend &backend) noexcept : m_backend(backend)
+{
+    Refresh();
+    m_watcher = std::thread([this](){
+        while (m_backend.WaitForChange()) {
+            Refresh();
+        }
+    });
+}
+
+PersonalizationSettings::~PersonalizationSettings() noexcept
+{
+    m_backend.Stop();
+    if (m_watcher.joinable()) {
+        m_watcher.join();
+    }
+}
+
+PersonalizationSnapshot PersonalizationSettings::Snapshot() const noexcept
+{
+    return PersonalizationSnapshot::Unpack(m_snapshot.load(std::memory_order_acquire));
+}
+
+void PersonalizationSettings::Refresh() noexcept
+{
+    // Read and publish together, otherwise the watcher and a forced refresh could
+    // publish their reads in the opposite order, leaving the older values in place.
+    const std::scoped_lock lock(m_refreshMutex);
+    PersonalizationSnapshot snapshot = {};
+    snapshot.ColorizationColor = m_backend.ColorizationColor();
+    snapshot.AppsUseLightTheme = (m_backend.ReadDWORD(SettingsKey::Personalize, L"AppsUseLightTheme") != 0);
+    snapshot.DwmColorPrevalence = (m_backend.ReadDWORD(SettingsKey::Dwm, L"ColorPrevalence") != 0);
+    snapshot.ThemeColorPrevalence = (m_backend.ReadDWORD(SettingsKey::Personalize, L"ColorPrevalence") != 0);
+    snapshot.HighContrast = m_backend.HighContrast();
+    const PersonalizationSnapshot current = Snapshot();
+    if (current.SameSettings(snapshot)) {
+        return;
+    }
+    snapshot.Generation = ((current.Generation + 1) & PersonalizationSnapshot::GenerationMask);
+    m_snapshot.store(PersonalizationSnapshot::Pack(snapshot), std::memory_order_release);
+}
+
+PersonalizationSettings &PersonalizationSettings::Instance() noexcept
+{
+    static PersonalizationSettings settings(SettingsBackend::Default());
+    return settings;
+}
@@ -0,0 +1,205 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+// Deliberately free of any Windows dependency, so that the cache can be
+// exercised with "MockSettingsBackend" everywhere.
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+
+// The registry keys the personalization settings live in, all under HKEY_CURRENT_USER.
+enum class SettingsKey : int
+{
+    Dwm = 0, // Software\Microsoft\Windows\DWM
+    Personalize // Software\Microsoft\Windows\CurrentVersion\Themes\Personalize
+};
+
+// Everything the windows need to know about the user's personalization, small
+// enough to be published as a single 64-bit word.
+struct PersonalizationSnapshot
+{
+    std::uint32_t ColorizationColor = 0; // 0xAARRGGBB
+    bool AppsUseLightTheme = false;
+    bool DwmColorPrevalence = false;
+    bool ThemeColorPrevalence = false;
+    bool HighContrast = false;
+    std::uint32_t Generation = 0; // Bumped whenever anything above changes, wraps at 24 bits.
+
+    static inline constexpr const std::uint32_t GenerationMask = 0x00FFFFFF;
+
+    [[nodiscard]] static inline constexpr std::uint64_t Pack(const PersonalizationSnapshot &value) noexcept {
+        return (static_cast<std::uint64_t>(value.ColorizationColor)
+                | (static_cast<std::uint64_t>(value.AppsUseLightTheme) << 32)
+                | (static_cast<std::uint64_t>(value.DwmColorPrevalence) << 33)
+                | (static_cast<std::uint64_t>(value.ThemeColorPrevalence) << 34)
+                | (static_cast<std::uint64_t>(value.HighContrast) << 35)
+                | (static_cast<std::uint64_t>(value.Generation & GenerationMask) << 40));
+    }
+    [[nodiscard]] static inline constexpr PersonalizationSnapshot Unpack(const std::uint64_t value) noexcept {
+        PersonalizationSnapshot result = {};
+        result.ColorizationColor = static_cast<std::uint32_t>(value & 0xFFFFFFFF);
+        result.AppsUseLightTheme = (((value >> 32) & 1) != 0);
+        result.DwmColorPrevalence = (((value >> 33) & 1) != 0);
+        result.ThemeColorPrevalence = (((value >> 34) & 1) != 0);
+        result.HighContrast = (((value >> 35) & 1) != 0);
+        result.Generation = static_cast<std::uint32_t>((value >> 40) & GenerationMask);
+        return result;
+    }
+    // Equal settings, regardless of the generation.
+    [[nodiscard]] inline constexpr bool SameSettings(const PersonalizationSnapshot &other) const noexcept {
+        return (ColorizationColor == other.ColorizationColor) && (AppsUseLightTheme == other.AppsUseLightTheme)
+                && (DwmColorPrevalence == other.DwmColorPrevalence) && (ThemeColorPrevalence == other.ThemeColorPrevalence)
+                && (HighContrast == other.HighContrast);
+    }
+};
+
+// Where the settings come from.
+class SettingsBackend
+{
+public:
+    virtual ~SettingsBackend() noexcept = default;
+
+    // Missing or unreadable values read as zero.
+    [[nodiscard]] virtual std::uint32_t ReadDWORD(const SettingsKey key, const std::wstring &name) noexcept = 0;
+    [[nodiscard]] virtual std::uint32_t ColorizationColor() noexcept = 0;
+    [[nodiscard]] virtual bool HighContrast() noexcept = 0;
+    // Block until any of the keys changes. Returns false once "Stop()" is called.
+    [[nodiscard]] virtual bool WaitForChange() noexcept = 0;
+    // Wake up "WaitForChange()" for good, may be called from any thread.
+    virtual void Stop() noexcept = 0;
+
+    // "RegNotifyChangeKeyValue()" & friends on Windows. Nothing to read and nothing
+    // to watch on POSIX systems, everything reads as zero there.
+    [[nodiscard]] static SettingsBackend &Default() noexcept;
+};
+
+// An in-memory registry. Every "Write()" wakes up the watcher just like a
+// registry change notification would.
+class MockSettingsBackend final : public SettingsBackend
+{
+public:
+    inline explicit MockSettingsBackend() noexcept = default;
+    inline ~MockSettingsBackend() noexcept override = default;
+
+    [[nodiscard]] inline std::uint32_t ReadDWORD(const SettingsKey key, const std::wstring &name) noexcept override {
+        const std::scoped_lock lock(m_mutex);
+        const auto it = m_values.find(std::make_pair(key, name));
+        return ((it == m_values.end()) ? 0 : it->second);
+    }
+    [[nodiscard]] inline std::uint32_t ColorizationColor() noexcept override {
+        const std::scoped_lock lock(m_mutex);
+        return m_colorizationColor;
+    }
+    [[nodiscard]] inline bool HighContrast() noexcept override {
+        const std::scoped_lock lock(m_mutex);
+        return m_highContrast;
+    }
+    [[nodiscard]] inline bool WaitForChange() noexcept override {
+        std::unique_lock lock(m_mutex);
+        m_condition.wait(lock, [this](){ return (m_changed || m_stopped); });
+        m_changed = false;
+        return !m_stopped;
+    }
+    inline void Stop() noexcept override {
+        const std::scoped_lock lock(m_mutex);
+        m_stopped = true;
+        m_condition.notify_all();
+    }
+
+    inline void Write(const SettingsKey key, const std::wstring &name, const std::uint32_t value) noexcept {
+        const std::scoped_lock lock(m_mutex);
+        m_values.insert_or_assign(std::make_pair(key, name), value);
+        Changed();
+    }
+    inline void ColorizationColor(const std::uint32_t value) noexcept {
+        const std::scoped_lock lock(m_mutex);
+        m_colorizationColor = value;
+        Changed();
+    }
+    inline void HighContrast(const bool value) noexcept {
+        const std::scoped_lock lock(m_mutex);
+        m_highContrast = value;
+        Changed();
+    }
+
+private:
+    MockSettingsBackend(const MockSettingsBackend &) = delete;
+    MockSettingsBackend &operator=(const MockSettingsBackend &) = delete;
+    MockSettingsBackend(MockSettingsBackend &&) = delete;
+    MockSettingsBackend &operator=(MockSettingsBackend &&) = delete;
+
+private:
+    inline void Changed() noexcept {
+        m_changed = true;
+        m_condition.notify_all();
+    }
+
+private:
+    std::mutex m_mutex = {};
+    std::condition_variable m_condition = {};
+    std::map<std::pair<SettingsKey, std::wstring>, std::uint32_t> m_values = {};
+    std::uint32_t m_colorizationColor = 0;
+    bool m_highContrast = false;
+    bool m_changed = false;
+    bool m_stopped = false;
+};
+
+// The personalization settings of the current user, read once and kept up to
+// date by a background thread which watches the registry. Reading is a single
+// atomic load, no matter how many windows ask how often.
+class PersonalizationSettings
+{
+public:
+    // Starts watching the backend right away.
+    explicit PersonalizationSettings(SettingsBackend &backend) noexcept;
+    ~PersonalizationSettings() noexcept;
+
+    [[nodiscard]] PersonalizationSnapshot Snapshot() const noexcept;
+    // Read everything again right now, without waiting for the watcher. Some
+    // settings (high contrast) are not in the registry and can't be watched.
+    void Refresh() noexcept;
+
+    // Backed by "SettingsBackend::Default()".
+    [[nodiscard]] static PersonalizationSettings &Instance() noexcept;
+
+private:
+    PersonalizationSettings(const PersonalizationSettings &) = delete;
+    PersonalizationSettings &operator=(const PersonalizationSettings &) = delete;
+    PersonalizationSettings(PersonalizationSettings &&) = delete;
+    PersonalizationSettings &operator=(PersonalizationSettings &&) = delete;
+
+private:
+    SettingsBackend &m_backend;
+    std::atomic<std::uint64_t> m_snapshot = 0;
+    std::mutex m_refreshMutex = {}; // Serializes the writers, the readers never lock.
+    std::thread m_watcher = {};
+};
@@ -0,0 +1,85 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _WIN32
+
+#include "PersonalizationSettings.h"
+
+// No registry: everything reads as zero and nothing ever changes.
+class POSIXSettingsBackend final : public SettingsBackend
+{
+public:
+    explicit POSIXSettingsBackend() noexcept = default;
+    ~POSIXSettingsBackend() noexcept override = default;
+
+    [[nodiscard]] std::uint32_t ReadDWORD(const SettingsKey key, const std::wstring &name) noexcept override
+    {
+        static_cast<void>(key);
+        static_cast<void>(name);
+        return 0;
+    }
+
+    [[nodiscard]] std::uint32_t ColorizationColor() noexcept override
+    {
+        return 0;
+    }
+
+    [[nodiscard]] bool HighContrast() noexcept override
+    {
+        return false;
+    }
+
+    [[nodiscard]] bool WaitForChange() noexcept override
+    {
+        std::unique_lock lock(m_mutex);
+        m_condition.wait(lock, [this](){ return m_stopped; });
+        return false;
+    }
+
+    void Stop() noexcept override
+    {
+        const std::scoped_lock lock(m_mutex);
+        m_stopped = true;
+        m_condition.notify_all();
+    }
+
+private:
+    POSIXSettingsBackend(const POSIXSettingsBackend &) = delete;
+    POSIXSettingsBackend &operator=(const POSIXSettingsBackend &) = delete;
+    POSIXSettingsBackend(POSIXSettingsBackend &&) = delete;
+    POSIXSettingsBackend &operator=(POSIXSettingsBackend &&) = delete;
+
+private:
+    std::mutex m_mutex = {};
+    std::condition_variable m_condition = {};
+    bool m_stopped = false;
+};
+
+SettingsBackend &SettingsBackend::Default() noexcept
+{
+    static POSIXSettingsBackend backend;
+    return backend;
+}
+
+#endif // _WIN32
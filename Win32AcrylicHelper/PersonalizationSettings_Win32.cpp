@@ -0,0 +1,208 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifdef _WIN32
+
+#include <SDKDDKVer.h>
+#include <Windows.h>
+#include <DwmApi.h>
+#include "PersonalizationSettings.h"
+#include "OperationResult.h"
+#include "Undocumented.h"
+
+class Win32SettingsBackend final : public SettingsBackend
+{
+public:
+    explicit Win32SettingsBackend() noexcept;
+    ~Win32SettingsBackend() noexcept override;
+
+    [[nodiscard]] std::uint32_t ReadDWORD(const SettingsKey key, const std::wstring &name) noexcept override;
+    [[nodiscard]] std::uint32_t ColorizationColor() noexcept override;
+    [[nodiscard]] bool HighContrast() noexcept override;
+    [[nodiscard]] bool WaitForChange() noexcept override;
+    void Stop() noexcept override;
+
+private:
+    Win32SettingsBackend(const Win32SettingsBackend &) = delete;
+    Win32SettingsBackend &operator=(const Win32SettingsBackend &) = delete;
+    Win32SettingsBackend(Win32SettingsBackend &&) = delete;
+    Win32SettingsBackend &operator=(Win32SettingsBackend &&) = delete;
+
+private:
+    [[nodiscard]] bool Watch(const std::size_t index) noexcept;
+
+private:
+    static inline constexpr const std::size_t KeyCount = 2;
+
+    // Kept open for the whole life time of the process, both for reading and
+    // for the change notifications. Null if the key doesn't exist.
+    HKEY m_keys[KeyCount] = {};
+    HANDLE m_changeEvents[KeyCount] = {};
+    HANDLE m_stopEvent = nullptr;
+    bool m_armed = false;
+};
+
+Win32SettingsBackend::Win32SettingsBackend() noexcept
+{
+    static constexpr const wchar_t *paths[KeyCount] = { DwmRegistryKeyPath, PersonalizeRegistryKeyPath };
+    for (std::size_t i = 0; i != KeyCount; ++i) {
+        // The personalize key doesn't exist on old systems, that's not an error.
+        if (RegOpenKeyExW(HKEY_CURRENT_USER, paths[i], 0, (KEY_READ | KEY_NOTIFY), &m_keys[i]) != ERROR_SUCCESS) {
+            m_keys[i] = nullptr;
+        }
+        m_changeEvents[i] = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+        if (!m_changeEvents[i]) {
+            PRINT_WIN32_ERROR_MESSAGE(CreateEventW, L"Failed to create the registry change event.")
+        }
+    }
+    m_stopEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    if (!m_stopEvent) {
+        PRINT_WIN32_ERROR_MESSAGE(CreateEventW, L"Failed to create the stop event of the registry watcher.")
+    }
+}
+
+Win32SettingsBackend::~Win32SettingsBackend() noexcept
+{
+    for (std::size_t i = 0; i != KeyCount; ++i) {
+        if (m_keys[i]) {
+            RegCloseKey(m_keys[i]);
+            m_keys[i] = nullptr;
+        }
+        if (m_changeEvents[i]) {
+            CloseHandle(m_changeEvents[i]);
+            m_changeEvents[i] = nullptr;
+        }
+    }
+    if (m_stopEvent) {
+        CloseHandle(m_stopEvent);
+        m_stopEvent = nullptr;
+    }
+}
+
+std::uint32_t Win32SettingsBackend::ReadDWORD(const SettingsKey key, const std::wstring &name) noexcept
+{
+    const HKEY hKey = m_keys[static_cast<std::size_t>(key)];
+    if (!hKey || name.empty()) {
+        return 0;
+    }
+    DWORD dwValue = 0;
+    DWORD dwType = REG_DWORD;
+    DWORD dwSize = sizeof(dwValue);
+    if (RegQueryValueExW(hKey, name.c_str(), nullptr, &dwType, reinterpret_cast<LPBYTE>(&dwValue), &dwSize) != ERROR_SUCCESS) {
+        PRINT_WIN32_ERROR_MESSAGE(RegQueryValueExW, L"Failed to query the registry key value.")
+        return 0;
+    }
+    return dwValue;
+}
+
+std::uint32_t Win32SettingsBackend::ColorizationColor() noexcept
+{
+    DWORD color = 0; // The color format of the value is 0xAARRGGBB.
+    BOOL opaque = FALSE;
+    const HRESULT hr = DwmGetColorizationColor(&color, &opaque);
+    if (FAILED(hr)) {
+        PRINT_HR_ERROR_MESSAGE(DwmGetColorizationColor, hr, L"Failed to retrieve the colorization color.")
+        return 0;
+    }
+    return color;
+}
+
+bool Win32SettingsBackend::HighContrast() noexcept
+{
+    HIGHCONTRASTW hc;
+    SecureZeroMemory(&hc, sizeof(hc));
+    hc.cbSize = sizeof(hc);
+    if (SystemParametersInfoW(SPI_GETHIGHCONTRAST, sizeof(hc), &hc, 0) == FALSE) {
+        PRINT_WIN32_ERROR_MESSAGE(SystemParametersInfoW, L"Failed to retrieve the high contrast mode state.")
+        return false;
+    }
+    return (hc.dwFlags & HCF_HIGHCONTRASTON);
+}
+
+bool Win32SettingsBackend::Watch(const std::size_t index) noexcept
+{
+    if (!m_keys[index] || !m_changeEvents[index]) {
+        return false;
+    }
+    // One shot: has to be armed again after every notification. Called from
+    // the watcher thread only, the notification goes away with the thread.
+    const LSTATUS status = RegNotifyChangeKeyValue(m_keys[index], FALSE, REG_NOTIFY_CHANGE_LAST_SET, m_changeEvents[index], TRUE);
+    if (status != ERROR_SUCCESS) {
+        PRINT_WIN32_ERROR_MESSAGE(RegNotifyChangeKeyValue, L"Failed to watch the registry key for changes.")
+        return false;
+    }
+    return true;
+}
+
+bool Win32SettingsBackend::WaitForChange() noexcept
+{
+    if (!m_stopEvent) {
+        return false;
+    }
+    // Arm everything before the first wait. Later on only the key which fired
+    // is armed again, before returning, so that no change can slip through
+    // between the notification and the caller reading the new values.
+    if (!m_armed) {
+        m_armed = true;
+        for (std::size_t i = 0; i != KeyCount; ++i) {
+            [[maybe_unused]] const bool watching = Watch(i);
+        }
+    }
+    HANDLE handles[KeyCount + 1] = { m_stopEvent };
+    std::size_t keyOfHandle[KeyCount + 1] = {};
+    DWORD count = 1;
+    for (std::size_t i = 0; i != KeyCount; ++i) {
+        if (m_keys[i] && m_changeEvents[i]) {
+            handles[count] = m_changeEvents[i];
+            keyOfHandle[count] = i;
+            ++count;
+        }
+    }
+    const DWORD ret = WaitForMultipleObjects(count, handles, FALSE, INFINITE);
+    if ((ret <= WAIT_OBJECT_0) || (ret >= (WAIT_OBJECT_0 + count))) {
+        if (ret == WAIT_FAILED) {
+            PRINT_WIN32_ERROR_MESSAGE(WaitForMultipleObjects, L"Failed to wait for the registry changes.")
+        }
+        return false;
+    }
+    [[maybe_unused]] const bool watching = Watch(keyOfHandle[ret - WAIT_OBJECT_0]);
+    return true;
+}
+
+void Win32SettingsBackend::Stop() noexcept
+{
+    if (m_stopEvent) {
+        if (SetEvent(m_stopEvent) == FALSE) {
+            PRINT_WIN32_ERROR_MESSAGE(SetEvent, L"Failed to stop the registry watcher.")
+        }
+    }
+}
+
+SettingsBackend &SettingsBackend::Default() noexcept
+{
+    static Win32SettingsBackend backend;
+    return backend;
+}
+
+#endif // _WIN32
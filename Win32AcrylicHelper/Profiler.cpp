@@ -0,0 +1,187 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <SDKDDKVer.h>
+#include <Windows.h>
+#include "Profiler.h"
+#include "TimingService.h"
+#include "Utils.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <utility>
+
+namespace Profiler
+{
+
+struct Span
+{
+    const wchar_t *Name = nullptr;
+    std::uint64_t Start = 0;
+    std::uint64_t Finish = 0;
+};
+
+// Spans are appended to fixed-size chunks so that a published span never moves
+// and the dump can read the buffers of other threads without any locking.
+struct SpanChunk
+{
+    std::array<Span, 512> Spans = {};
+    std::atomic<std::size_t> Count = 0;
+    std::atomic<SpanChunk *> Next = nullptr;
+};
+
+struct ThreadSpans
+{
+    DWORD ThreadId = 0;
+    SpanChunk *First = nullptr;
+    SpanChunk *Last = nullptr;
+    ThreadSpans *Next = nullptr;
+};
+
+// All per-thread span buffers ever created. They are never freed so that the
+// spans of finished threads are still part of the trace.
+static std::atomic<ThreadSpans *> g_threadSpans = nullptr;
+static thread_local ThreadSpans *t_threadSpans = nullptr;
+
+[[nodiscard]] static inline ThreadSpans *GetThreadSpans() noexcept
+{
+    if (t_threadSpans) {
+        return t_threadSpans;
+    }
+    [[maybe_unused]] static const bool dumpRegistered = (std::atexit(Dump) == 0);
+    const auto spans = new (std::nothrow) ThreadSpans;
+    if (!spans) {
+        return nullptr;
+    }
+    spans->ThreadId = GetCurrentThreadId();
+    spans->First = new (std::nothrow) SpanChunk;
+    if (!spans->First) {
+        delete spans;
+        return nullptr;
+    }
+    spans->Last = spans->First;
+    ThreadSpans *head = g_threadSpans.load(std::memory_order_relaxed);
+    do {
+        spans->Next = head;
+    } while (!g_threadSpans.compare_exchange_weak(head, spans, std::memory_order_release, std::memory_order_relaxed));
+    t_threadSpans = spans;
+    return spans;
+}
+
+// Microseconds with a nanosecond fraction, the unit of the trace event format.
+[[nodiscard]] static inline std::wstring TicksToMicroseconds(const std::uint64_t ticks) noexcept
+{
+    const std::uint64_t nanoseconds = TimingService::TicksToNanoseconds(ticks);
+    std::wstring fraction = std::to_wstring(nanoseconds % 1000);
+    fraction.insert(0, (3 - fraction.size()), L'0');
+    return std::to_wstring(nanoseconds / 1000) + L'.' + fraction;
+}
+
+std::uint64_t Now() noexcept
+{
+    LARGE_INTEGER counter = {};
+    QueryPerformanceCounter(&counter);
+    return static_cast<std::uint64_t>(counter.QuadPart);
+}
+
+void Record(const wchar_t *name, const std::uint64_t start, const std::uint64_t finish) noexcept
+{
+    if (!name) {
+        return;
+    }
+    const auto spans = GetThreadSpans();
+    if (!spans) {
+        return;
+    }
+    SpanChunk *chunk = spans->Last;
+    std::size_t count = chunk->Count.load(std::memory_order_relaxed);
+    if (count == chunk->Spans.size()) {
+        const auto next = new (std::nothrow) SpanChunk;
+        if (!next) {
+            return;
+        }
+        chunk->Next.store(next, std::memory_order_release);
+        spans->Last = next;
+        chunk = next;
+        count = 0;
+    }
+    chunk->Spans[count] = { name, start, finish };
+    // Publish the span only after it has been completely written.
+    chunk->Count.store(count + 1, std::memory_order_release);
+}
+
+[[nodiscard]] static inline std::uint64_t GetOrigin() noexcept
+{
+    std::uint64_t origin = UINT64_MAX;
+    for (auto spans = g_threadSpans.load(std::memory_order_acquire); spans; spans = spans->Next) {
+        for (auto chunk = spans->First; chunk; chunk = chunk->Next.load(std::memory_order_acquire)) {
+            const std::size_t count = chunk->Count.load(std::memory_order_acquire);
+            for (std::size_t index = 0; index != count; ++index) {
+                origin = std::min(origin, chunk->Spans[index].Start);
+            }
+        }
+    }
+    return origin;
+}
+
+std::wstring ToJSON() noexcept
+{
+    // Timestamps in the trace are relative to the earliest span.
+    const std::uint64_t origin = GetOrigin();
+    const std::wstring processId = std::to_wstring(GetCurrentProcessId());
+    std::wstring result = L"{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+    bool first = true;
+    for (auto spans = g_threadSpans.load(std::memory_order_acquire); spans; spans = spans->Next) {
+        const std::wstring threadId = std::to_wstring(spans->ThreadId);
+        for (auto chunk = spans->First; chunk; chunk = chunk->Next.load(std::memory_order_acquire)) {
+            const std::size_t count = chunk->Count.load(std::memory_order_acquire);
+            for (std::size_t index = 0; index != count; ++index) {
+                const Span &span = chunk->Spans[index];
+                if (!first) {
+                    result += L",\n";
+                }
+                first = false;
+                const std::uint64_t start = ((span.Start > origin) ? (span.Start - origin) : 0);
+                const std::uint64_t duration = ((span.Finish > span.Start) ? (span.Finish - span.Start) : 0);
+                result += L"  {\"name\": \"" + Utils::EscapeJSONString(span.Name) + L"\", \"cat\": \"Win32AcrylicHelper\", \"ph\": \"X\", \"ts\": "
+                        + TicksToMicroseconds(start) + L", \"dur\": " + TicksToMicroseconds(duration)
+                        + L", \"pid\": " + processId + L", \"tid\": " + threadId + L'}';
+            }
+        }
+    }
+    result += L"\n]}\n";
+    return result;
+}
+
+void Dump() noexcept
+{
+    // The trace event format is JSON only, even for a file ending with ".csv".
+    Utils::WriteReport(L"WIN32ACRYLICHELPER_PROFILE_TRACE", []([[maybe_unused]] const ReportFormat format) -> std::wstring {
+        return ToJSON();
+    });
+}
+
+} // namespace Profiler
@@ -0,0 +1,79 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+// Kept free of any Windows dependency: the loader cache uses the spans too and
+// has to compile unchanged on POSIX systems.
+
+#include <cstdint>
+#include <string>
+
+// Optional scoped-span profiler, mainly meant for finding out where the startup
+// time goes. Only compiled in when "WIN32ACRYLICHELPER_PROFILER" is defined, see
+// "PROFILE_SCOPE()". The spans are written in the Chrome trace event format at
+// exit, load the file in "chrome://tracing" or "ui.perfetto.dev" to view them.
+namespace Profiler
+{
+    [[nodiscard]] std::uint64_t Now() noexcept;
+
+    // "name" must outlive the process, string literals only.
+    void Record(const wchar_t *name, const std::uint64_t start, const std::uint64_t finish) noexcept;
+
+    [[nodiscard]] std::wstring ToJSON() noexcept;
+
+    // Writes the trace to the file named by the "WIN32ACRYLICHELPER_PROFILE_TRACE"
+    // environment variable, or to the debugger output if the variable is not set.
+    // Called automatically at exit.
+    void Dump() noexcept;
+
+    class Scope
+    {
+    public:
+        inline explicit Scope(const wchar_t *name) noexcept : m_name(name), m_start(Now()) {}
+        inline ~Scope() noexcept {
+            Record(m_name, m_start, Now());
+        }
+
+    private:
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+        Scope(Scope &&) = delete;
+        Scope &operator=(Scope &&) = delete;
+
+    private:
+        const wchar_t *m_name = nullptr;
+        std::uint64_t m_start = 0;
+    };
+} // namespace Profiler
+
+#ifndef PROFILE_SCOPE
+#ifdef WIN32ACRYLICHELPER_PROFILER
+#define __PROFILE_SCOPE_NAME2(line) __profilerScope##line
+#define __PROFILE_SCOPE_NAME(line) __PROFILE_SCOPE_NAME2(line)
+#define PROFILE_SCOPE(name) const Profiler::Scope __PROFILE_SCOPE_NAME(__LINE__)(name);
+#else // WIN32ACRYLICHELPER_PROFILER
+#define PROFILE_SCOPE(name)
+#endif // WIN32ACRYLICHELPER_PROFILER
+#endif // PROFILE_SCOPE
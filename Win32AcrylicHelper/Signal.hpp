@@ -0,0 +1,300 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+// A signal with any number of subscribers. Small callables live inside the slot
+// itself, so neither connecting them nor emitting allocates; bigger ones are
+// allocated once, when they are connected. Emitting without any subscriber is a
+// single size check, and a single subscriber is called without going through the
+// loop which copes with slots (dis)connecting others.
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Identifies one subscription, for disconnecting it later. The signal must outlive
+// every use of its connections.
+class SignalConnection
+{
+public:
+    inline constexpr explicit SignalConnection() noexcept = default;
+    inline constexpr explicit SignalConnection(void *signal, const std::uint32_t id, void (*disconnect)(void *, const std::uint32_t) noexcept) noexcept {
+        m_signal = signal;
+        m_id = id;
+        m_disconnect = disconnect;
+    }
+    inline ~SignalConnection() noexcept = default;
+
+    [[nodiscard]] inline constexpr bool Valid() const noexcept {
+        return (m_signal && m_disconnect && (m_id != 0));
+    }
+    inline void Disconnect() noexcept {
+        if (Valid()) {
+            m_disconnect(m_signal, m_id);
+        }
+        m_signal = nullptr;
+        m_id = 0;
+        m_disconnect = nullptr;
+    }
+
+private:
+    void *m_signal = nullptr;
+    std::uint32_t m_id = 0;
+    void (*m_disconnect)(void *, const std::uint32_t) noexcept = nullptr;
+};
+
+template<typename... Args>
+class Signal
+{
+    class Slot
+    {
+    public:
+        // Enough for a member function pointer bound to an object, or a lambda
+        // capturing a few pointers.
+        static inline constexpr const std::size_t BufferSize = (4 * sizeof(void *));
+
+        template<typename Callable>
+        inline explicit Slot(const std::uint32_t id, Callable &&callable) noexcept {
+            using Type = std::decay_t<Callable>;
+            m_id = id;
+            if constexpr (IsInline<Type>()) {
+                new (m_buffer) Type(std::forward<Callable>(callable));
+                m_invoke = [](void *storage, Args... args) -> void {
+                    (*std::launder(reinterpret_cast<Type *>(storage)))(args...);
+                };
+                m_manage = [](void *storage, void *destination) noexcept -> void {
+                    auto object = std::launder(reinterpret_cast<Type *>(storage));
+                    if (destination) {
+                        new (destination) Type(std::move(*object));
+                    }
+                    object->~Type();
+                };
+            } else {
+                *reinterpret_cast<Type **>(m_buffer) = new Type(std::forward<Callable>(callable));
+                m_invoke = [](void *storage, Args... args) -> void {
+                    (**reinterpret_cast<Type **>(storage))(args...);
+                };
+                m_manage = [](void *storage, void *destination) noexcept -> void {
+                    auto object = reinterpret_cast<Type **>(storage);
+                    if (destination) {
+                        *reinterpret_cast<Type **>(destination) = *object;
+                    } else {
+                        delete *object;
+                    }
+                    *object = nullptr;
+                };
+            }
+        }
+        inline Slot(Slot &&other) noexcept {
+            MoveFrom(other);
+        }
+        inline Slot &operator=(Slot &&other) noexcept {
+            if (this != &other) {
+                Reset();
+                MoveFrom(other);
+            }
+            return *this;
+        }
+        inline ~Slot() noexcept {
+            Reset();
+        }
+
+        // Zero once disconnected during an emission.
+        [[nodiscard]] inline std::uint32_t Id() const noexcept {
+            return m_id;
+        }
+        [[nodiscard]] inline bool Connected() const noexcept {
+            return ((m_id != 0) && (m_invoke != nullptr));
+        }
+        // The callable may be running right now, it's destroyed later by "Cleanup()".
+        inline void MarkDisconnected() noexcept {
+            m_id = 0;
+        }
+        // Only for the slots of the signal, which always hold a callable.
+        inline void Invoke(Args... args) noexcept {
+            m_invoke(m_buffer, args...);
+        }
+        inline void Reset() noexcept {
+            if (m_manage) {
+                m_manage(m_buffer, nullptr);
+            }
+            m_invoke = nullptr;
+            m_manage = nullptr;
+        }
+
+    private:
+        Slot(const Slot &) = delete;
+        Slot &operator=(const Slot &) = delete;
+
+    private:
+        template<typename Type>
+        [[nodiscard]] static inline constexpr bool IsInline() noexcept {
+            return ((sizeof(Type) <= BufferSize) && (alignof(Type) <= alignof(std::max_align_t)) && std::is_nothrow_move_constructible_v<Type>);
+        }
+        inline void MoveFrom(Slot &other) noexcept {
+            m_id = other.m_id;
+            m_invoke = other.m_invoke;
+            m_manage = other.m_manage;
+            if (m_manage) {
+                m_manage(other.m_buffer, m_buffer);
+            }
+            other.m_invoke = nullptr;
+            other.m_manage = nullptr;
+        }
+
+    private:
+        alignas(std::max_align_t) std::byte m_buffer[BufferSize] = {};
+        void (*m_invoke)(void *, Args...) = nullptr;
+        void (*m_manage)(void *, void *) noexcept = nullptr; // Moves to the destination (if any), then destroys.
+        std::uint32_t m_id = 0;
+    };
+
+public:
+    inline explicit Signal() noexcept = default;
+    inline ~Signal() noexcept = default;
+
+    template<typename Callable>
+    [[nodiscard]] inline SignalConnection Connect(Callable &&callable) noexcept {
+        static_assert(std::is_invocable_v<std::decay_t<Callable> &, Args...>, "The slot can't be called with the arguments of the signal.");
+        // Zero marks the slots disconnected during an emission.
+        ++m_lastId;
+        if (m_lastId == 0) {
+            ++m_lastId;
+        }
+        const std::uint32_t id = m_lastId;
+        // Slots connected while emitting are kept aside until the emission is
+        // over, the vector must not move while its slots are running.
+        if (m_emitting) {
+            m_pending.emplace_back(id, std::forward<Callable>(callable));
+            m_dirty = true;
+        } else {
+            m_slots.emplace_back(id, std::forward<Callable>(callable));
+        }
+        return SignalConnection(this, id, &Signal::DisconnectSlot);
+    }
+
+    inline void Disconnect(const std::uint32_t id) noexcept {
+        if (id == 0) {
+            return;
+        }
+        for (auto it = m_slots.begin(); it != m_slots.end(); ++it) {
+            if (it->Id() == id) {
+                if (m_emitting) {
+                    // Just mark it, it's destroyed once the emission is over:
+                    // it may be the very slot which is running.
+                    it->MarkDisconnected();
+                    m_dirty = true;
+                } else {
+                    m_slots.erase(it);
+                }
+                return;
+            }
+        }
+        std::erase_if(m_pending, [id](const Slot &slot){ return (slot.Id() == id); });
+    }
+
+    inline void DisconnectAll() noexcept {
+        if (m_emitting) {
+            for (auto &&slot : m_slots) {
+                slot.MarkDisconnected();
+            }
+            // None of these has run yet.
+            m_pending.clear();
+            m_dirty = true;
+        } else {
+            m_slots.clear();
+            m_pending.clear();
+        }
+    }
+
+    [[nodiscard]] inline bool Empty() const noexcept {
+        return m_slots.empty();
+    }
+
+    inline void Emit(Args... args) const noexcept {
+        if (m_slots.empty()) {
+            return;
+        }
+        if ((m_slots.size() == 1) && !m_emitting) {
+            // The usual case: outside of an emission the only slot is connected and
+            // nothing is deferred, only what the call itself changes is left to clean up.
+            m_emitting = true;
+            m_slots.front().Invoke(args...);
+            m_emitting = false;
+            if (m_dirty) {
+                Cleanup();
+            }
+            return;
+        }
+        const bool outermost = !m_emitting;
+        m_emitting = true;
+        // Index based, slots may disconnect (themselves or others) while running.
+        const std::size_t count = m_slots.size();
+        for (std::size_t i = 0; i != count; ++i) {
+            if (m_slots[i].Connected()) {
+                m_slots[i].Invoke(args...);
+            }
+        }
+        if (outermost) {
+            m_emitting = false;
+            if (m_dirty) {
+                Cleanup();
+            }
+        }
+    }
+
+private:
+    Signal(const Signal &) = delete;
+    Signal &operator=(const Signal &) = delete;
+    Signal(Signal &&) = delete;
+    Signal &operator=(Signal &&) = delete;
+
+private:
+    static inline void DisconnectSlot(void *signal, const std::uint32_t id) noexcept {
+        static_cast<Signal *>(signal)->Disconnect(id);
+    }
+
+    inline void Cleanup() const noexcept {
+        m_dirty = false;
+        std::erase_if(m_slots, [](const Slot &slot){ return !slot.Connected(); });
+        if (!m_pending.empty()) {
+            for (auto &&slot : m_pending) {
+                m_slots.push_back(std::move(slot));
+            }
+            m_pending.clear();
+        }
+    }
+
+private:
+    // Mutable: emitting is logically const, but slots may (dis)connect meanwhile.
+    mutable std::vector<Slot> m_slots = {};
+    mutable std::vector<Slot> m_pending = {};
+    mutable bool m_emitting = false;
+    mutable bool m_dirty = false; // Slots to remove or pending ones to add once the emission is over.
+    std::uint32_t m_lastId = 0;
+};
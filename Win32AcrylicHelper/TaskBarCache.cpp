@@ -0,0 +1,178 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "TaskBarCache.h"
+#include "OperationResult.h"
+#include "WindowsVersion.h"
+#include <ShellApi.h>
+#include <mutex>
+#include <unordered_map>
+#include <cwchar>
+#include <cstdint>
+
+#ifndef ABM_GETAUTOHIDEBAREX
+#define ABM_GETAUTOHIDEBAREX (0x0000000b)
+#endif
+
+static std::mutex g_taskBarMutex;
+static std::unordered_map<HMONITOR, TaskBarEdge> g_taskBarEdges = {};
+// Bumped by "Invalidate()", guarded by "g_taskBarMutex" as well.
+static std::uint64_t g_taskBarGeneration = 0;
+
+[[nodiscard]] static inline TaskBarEdge EdgeFromABE(const UINT edge) noexcept
+{
+    switch (edge) {
+    case ABE_TOP:
+        return TaskBarEdge::Top;
+    case ABE_BOTTOM:
+        return TaskBarEdge::Bottom;
+    case ABE_LEFT:
+        return TaskBarEdge::Left;
+    case ABE_RIGHT:
+        return TaskBarEdge::Right;
+    default:
+        break;
+    }
+    return TaskBarEdge::None;
+}
+
+[[nodiscard]] static inline bool QueryAutoHideEdge(const HMONITOR monitor, TaskBarEdge &result) noexcept
+{
+    result = TaskBarEdge::None;
+    APPBARDATA abd;
+    SecureZeroMemory(&abd, sizeof(abd));
+    abd.cbSize = sizeof(abd);
+    // First, check if we have an auto-hide taskbar at all:
+    if (!(SHAppBarMessage(ABM_GETSTATE, &abd) & ABS_AUTOHIDE)) {
+        return true;
+    }
+    // "ABM_GETAUTOHIDEBAREX" was introduced on Windows 8.1
+    if (WindowsVersion::CurrentVersion() >= WindowsVersion::Windows_8_1) {
+        MONITORINFO mi;
+        SecureZeroMemory(&mi, sizeof(mi));
+        mi.cbSize = sizeof(mi);
+        if (GetMonitorInfoW(monitor, &mi) == FALSE) {
+            PRINT_WIN32_ERROR_MESSAGE(GetMonitorInfoW, L"Failed to retrieve the screen information.")
+            return false;
+        }
+        const RECT screenRect = mi.rcMonitor;
+        // This helper can be used to determine if there's a
+        // auto-hide taskbar on the given edge of the monitor.
+        const auto hasAutohideTaskbar = [&screenRect](const UINT edge) -> bool {
+            APPBARDATA abd2;
+            SecureZeroMemory(&abd2, sizeof(abd2));
+            abd2.cbSize = sizeof(abd2);
+            abd2.uEdge = edge;
+            abd2.rc = screenRect;
+            return (reinterpret_cast<HWND>(SHAppBarMessage(ABM_GETAUTOHIDEBAREX, &abd2)) != nullptr);
+        };
+        for (auto &&edge : {ABE_TOP, ABE_BOTTOM, ABE_LEFT, ABE_RIGHT}) {
+            if (hasAutohideTaskbar(edge)) {
+                result = EdgeFromABE(edge);
+                break;
+            }
+        }
+        return true;
+    }
+    APPBARDATA _abd;
+    SecureZeroMemory(&_abd, sizeof(_abd));
+    _abd.cbSize = sizeof(_abd);
+    _abd.hWnd = FindWindowW(L"Shell_TrayWnd", nullptr);
+    if (!_abd.hWnd) {
+        PRINT_WIN32_ERROR_MESSAGE(FindWindowW, L"Failed to retrieve the window handle of the task bar.")
+        return false;
+    }
+    const HMONITOR taskBarScreen = MonitorFromWindow(_abd.hWnd, MONITOR_DEFAULTTOPRIMARY);
+    if (!taskBarScreen) {
+        PRINT_WIN32_ERROR_MESSAGE(MonitorFromWindow, L"Failed to retrieve the task bar screen.")
+        return false;
+    }
+    if (taskBarScreen == monitor) {
+        SHAppBarMessage(ABM_GETTASKBARPOS, &_abd);
+        result = EdgeFromABE(_abd.uEdge);
+    }
+    return true;
+}
+
+TaskBarEdge TaskBarCache::AutoHideEdge(const HMONITOR monitor) noexcept
+{
+    if (!monitor) {
+        return TaskBarEdge::None;
+    }
+    std::uint64_t generation = 0;
+    {
+        const std::scoped_lock lock(g_taskBarMutex);
+        const auto it = g_taskBarEdges.find(monitor);
+        if (it != g_taskBarEdges.end()) {
+            return it->second;
+        }
+        generation = g_taskBarGeneration;
+    }
+    // Don't hold the lock while talking to the shell, two threads asking at the
+    // same time just store the same answer.
+    TaskBarEdge edge = TaskBarEdge::None;
+    if (!QueryAutoHideEdge(monitor, edge)) {
+        // Don't cache failures, try again next time.
+        return TaskBarEdge::None;
+    }
+    const std::scoped_lock lock(g_taskBarMutex);
+    // The answer may predate an "Invalidate()" which happened meanwhile, return it
+    // but don't cache it, the next query asks the shell again.
+    if (generation == g_taskBarGeneration) {
+        g_taskBarEdges.insert_or_assign(monitor, edge);
+    }
+    return edge;
+}
+
+void TaskBarCache::Invalidate() noexcept
+{
+    const std::scoped_lock lock(g_taskBarMutex);
+    g_taskBarEdges.clear();
+    ++g_taskBarGeneration;
+}
+
+bool TaskBarCache::IsChangeNotification(const UINT message, const WPARAM wParam, const LPARAM lParam) noexcept
+{
+    switch (message) {
+    case WM_SETTINGCHANGE: {
+        // The task bar settings page broadcasts "TraySettings", and the work
+        // area changes whenever the task bar moves or toggles auto-hide.
+        if ((wParam == SPI_SETWORKAREA) || ((lParam != 0) && (std::wcscmp(reinterpret_cast<LPCWSTR>(lParam), L"TraySettings") == 0))) {
+            return true;
+        }
+    } break;
+    case WM_DISPLAYCHANGE:
+        return true;
+    default:
+        break;
+    }
+    const UINT taskBarCreated = TaskBarCreatedMessage();
+    return ((taskBarCreated != 0) && (message == taskBarCreated));
+}
+
+UINT TaskBarCache::TaskBarCreatedMessage() noexcept
+{
+    static const UINT message = RegisterWindowMessageW(L"TaskbarCreated");
+    return message;
+}
@@ -0,0 +1,46 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <SDKDDKVer.h>
+#include <Windows.h>
+#include "WindowFrameGeometry.hpp"
+
+// The auto-hide task bar state of every monitor, queried from the shell once
+// and kept until "Invalidate()". Asking the shell is a cross process round trip,
+// far too slow for the frame calculation of a window that is being resized.
+namespace TaskBarCache
+{
+    // The edge of the given monitor with an auto-hide task bar, if any.
+    [[nodiscard]] TaskBarEdge AutoHideEdge(const HMONITOR monitor) noexcept;
+    // Forget everything, the next query asks the shell again.
+    void Invalidate() noexcept;
+    // Whether the given top level window message tells that the task bar
+    // state may have changed.
+    [[nodiscard]] bool IsChangeNotification(const UINT message, const WPARAM wParam, const LPARAM lParam) noexcept;
+    // Broadcasted by the shell when Explorer (and thus the task bar) restarts,
+    // zero if the message couldn't be registered.
+    [[nodiscard]] UINT TaskBarCreatedMessage() noexcept;
+} // namespace TaskBarCache
@@ -0,0 +1,108 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "ThemeChangeCoalescer.h"
+#include "PersonalizationSettings.h"
+#include "OperationResult.h"
+#include <algorithm>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+static std::mutex g_coalescerMutex;
+static std::vector<HWND> g_coalescerWindows = {};
+static UINT_PTR g_coalescerTimer = 0;
+static DWORD g_coalescerTimerThread = 0;
+static ULONGLONG g_coalescerBurstStart = 0;
+
+static void CALLBACK CoalescerTimerProc(HWND hWnd, UINT message, UINT_PTR id, DWORD time) noexcept
+{
+    UNREFERENCED_PARAMETER(hWnd);
+    UNREFERENCED_PARAMETER(message);
+    UNREFERENCED_PARAMETER(time);
+    if (KillTimer(nullptr, id) == FALSE) {
+        PRINT_WIN32_ERROR_MESSAGE(KillTimer, L"Failed to kill the theme change timer.")
+    }
+    std::vector<HWND> windows = {};
+    {
+        const std::scoped_lock lock(g_coalescerMutex);
+        g_coalescerTimer = 0;
+        g_coalescerTimerThread = 0;
+        windows = g_coalescerWindows;
+    }
+    // Once for the whole burst, no matter how many windows there are.
+    PersonalizationSettings::Instance().Refresh();
+    const UINT notification = ThemeChangeCoalescer::NotificationMessage();
+    for (auto &&window : std::as_const(windows)) {
+        if (PostMessageW(window, notification, 0, 0) == FALSE) {
+            PRINT_WIN32_ERROR_MESSAGE(PostMessageW, L"Failed to notify the window about the theme change.")
+        }
+    }
+}
+
+void ThemeChangeCoalescer::Register(const HWND hWnd) noexcept
+{
+    if (!hWnd) {
+        return;
+    }
+    const std::scoped_lock lock(g_coalescerMutex);
+    if (std::find(g_coalescerWindows.cbegin(), g_coalescerWindows.cend(), hWnd) == g_coalescerWindows.cend()) {
+        g_coalescerWindows.push_back(hWnd);
+    }
+}
+
+void ThemeChangeCoalescer::Unregister(const HWND hWnd) noexcept
+{
+    const std::scoped_lock lock(g_coalescerMutex);
+    g_coalescerWindows.erase(std::remove(g_coalescerWindows.begin(), g_coalescerWindows.end(), hWnd), g_coalescerWindows.end());
+}
+
+void ThemeChangeCoalescer::Schedule() noexcept
+{
+    const std::scoped_lock lock(g_coalescerMutex);
+    const ULONGLONG now = GetTickCount64();
+    if (g_coalescerTimer != 0) {
+        // Timers belong to the thread which created them, only that thread can
+        // push the deadline back. And don't push it back forever.
+        if ((g_coalescerTimerThread != GetCurrentThreadId()) || ((now - g_coalescerBurstStart) >= MaximumDelay)) {
+            return;
+        }
+    } else {
+        g_coalescerBurstStart = now;
+    }
+    // Passing the id of an existing timer resets it instead of creating a new one.
+    const UINT_PTR timer = SetTimer(nullptr, g_coalescerTimer, DebounceInterval, CoalescerTimerProc);
+    if (timer == 0) {
+        PRINT_WIN32_ERROR_MESSAGE(SetTimer, L"Failed to start the theme change timer.")
+        return;
+    }
+    g_coalescerTimer = timer;
+    g_coalescerTimerThread = GetCurrentThreadId();
+}
+
+UINT ThemeChangeCoalescer::NotificationMessage() noexcept
+{
+    static const UINT message = RegisterWindowMessageW(L"Win32AcrylicHelper_ThemeChanged");
+    return message;
+}
@@ -0,0 +1,50 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <SDKDDKVer.h>
+#include <Windows.h>
+
+// Theme changes arrive in bursts: every theme flip broadcasts "WM_SETTINGCHANGE"
+// several times, to every top level window. Instead of re-reading the settings and
+// notifying everyone for each of them, the windows only schedule an update here.
+// Once the burst is over (a frame without further requests), the settings are read
+// once and every registered window receives "NotificationMessage()" exactly once.
+namespace ThemeChangeCoalescer
+{
+    // Milliseconds without a new request before the update goes out.
+    [[maybe_unused]] constexpr const UINT DebounceInterval = 16;
+    // An endless burst still gets an update this often, in milliseconds.
+    [[maybe_unused]] constexpr const ULONGLONG MaximumDelay = 100;
+
+    void Register(const HWND hWnd) noexcept;
+    void Unregister(const HWND hWnd) noexcept;
+    // Must be called from a thread with a message loop, the update goes out from
+    // a timer of that thread.
+    void Schedule() noexcept;
+    // Posted to the registered windows, wParam and lParam are unused. The new
+    // state is in "PersonalizationSettings::Instance().Snapshot()".
+    [[nodiscard]] UINT NotificationMessage() noexcept;
+} // namespace ThemeChangeCoalescer
@@ -37,3 +37,4 @@
 __THUNK_API(__ADVAPI32_DLL_FILENAME, RegOpenKeyExW, LSTATUS, DEFAULT_INT, (HKEY arg1, LPCWSTR arg2, DWORD arg3, REGSAM arg4, PHKEY arg5), (arg1, arg2, arg3, arg4, arg5))
 __THUNK_API(__ADVAPI32_DLL_FILENAME, RegQueryValueExW, LSTATUS, DEFAULT_INT, (HKEY arg1, LPCWSTR arg2, LPDWORD arg3, LPDWORD arg4, LPBYTE arg5, LPDWORD arg6), (arg1, arg2, arg3, arg4, arg5, arg6))
 __THUNK_API(__ADVAPI32_DLL_FILENAME, RegCloseKey, LSTATUS, DEFAULT_INT, (HKEY arg1), (arg1))
+__THUNK_API(__ADVAPI32_DLL_FILENAME, RegNotifyChangeKeyValue, LSTATUS, DEFAULT_INT, (HKEY arg1, BOOL arg2, DWORD arg3, HANDLE arg4, BOOL arg5), (arg1, arg2, arg3, arg4, arg5))
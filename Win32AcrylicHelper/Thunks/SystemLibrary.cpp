@@ -23,46 +23,26 @@
  */
 
 #include "SystemLibrary.h"
-#include "WindowsVersion.h"
+#include "Log.h"
+#include "Profiler.h"
 #include <unordered_map>
+#include <utility>
+#include <atomic>
 
-static bool g_bSystemEnvironmentDetected = false;
-static bool g_bLoadFromSystem32Available = false;
+// Starts from 1 so that a zero-initialized stamp always looks outdated.
+static std::atomic<std::uint64_t> g_generation = 1;
 
-[[nodiscard]] static inline std::string UTF16ToUTF8(const std::wstring &UTF16String) noexcept
+struct SystemLibrarySymbol
 {
-    if (UTF16String.empty()) {
-        return {};
-    }
-    const auto originalString = &UTF16String[0];
-    const int newLength = WideCharToMultiByte(CP_UTF8, 0, originalString, -1, nullptr, 0, nullptr, nullptr);
-    if (newLength <= 0) {
-        return {};
-    }
-    std::string UTF8String(newLength, '\0');
-    WideCharToMultiByte(CP_UTF8, 0, originalString, -1, &UTF8String[0], newLength, nullptr, nullptr);
-    return UTF8String;
-}
-
-[[maybe_unused]] [[nodiscard]] static inline std::wstring UTF8ToUTF16(const std::string &UTF8String) noexcept
-{
-    if (UTF8String.empty()) {
-        return {};
-    }
-    const auto originalString = &UTF8String[0];
-    const int newLength = MultiByteToWideChar(CP_UTF8, 0, originalString, -1, nullptr, 0);
-    if (newLength <= 0) {
-        return {};
-    }
-    std::wstring UTF16String(newLength, L'\0');
-    MultiByteToWideChar(CP_UTF8, 0, originalString, -1, &UTF16String[0], newLength);
-    return UTF16String;
-}
+    // Null if the symbol could not be resolved in "Generation".
+    FARPROC Address = nullptr;
+    std::uint64_t Generation = 0;
+};
 
 class SystemLibraryPrivate
 {
 public:
-    explicit SystemLibraryPrivate(SystemLibrary *q) noexcept;
+    explicit SystemLibraryPrivate(SystemLibrary *q, SystemLibraryBackend *backend) noexcept;
     ~SystemLibraryPrivate() noexcept;
 
     void FileName(const std::wstring &fileName) noexcept;
@@ -70,11 +50,18 @@ public:
 
     [[nodiscard]] bool Loaded() const noexcept;
     [[nodiscard]] bool Load(const bool load) noexcept;
+    [[nodiscard]] bool ShouldLoad() const noexcept;
 
     [[nodiscard]] FARPROC GetSymbol(const std::wstring &function) noexcept;
 
+    [[nodiscard]] SystemLibraryRetryPolicy RetryPolicy() const noexcept;
+    void RetryPolicy(const SystemLibraryRetryPolicy policy) noexcept;
+
     [[nodiscard]] static FARPROC GetSymbolNoCache(const std::wstring &fileName, const std::wstring &function) noexcept;
 
+private:
+    [[nodiscard]] bool ShouldRetry(const std::uint64_t failureGeneration) const noexcept;
+
 private:
     explicit SystemLibraryPrivate(const SystemLibraryPrivate &) noexcept = delete;
     explicit SystemLibraryPrivate(SystemLibraryPrivate &&) noexcept = delete;
@@ -84,37 +71,26 @@ private:
 
 private:
     SystemLibrary *q_ptr = nullptr;
+    SystemLibraryBackend *m_backend = nullptr;
+    SystemLibraryRetryPolicy m_retryPolicy = SystemLibraryRetryPolicy::AfterRescan;
     bool m_failedToLoad = false;
+    std::uint64_t m_failureGeneration = 0;
     std::wstring m_fileName = {};
     HMODULE m_module = nullptr;
-    std::unordered_map<std::wstring, FARPROC> m_resolvedSymbols = {};
+    std::unordered_map<std::wstring, SystemLibrarySymbol> m_resolvedSymbols = {};
 };
 
-SystemLibraryPrivate::SystemLibraryPrivate(SystemLibrary *q) noexcept
+SystemLibraryPrivate::SystemLibraryPrivate(SystemLibrary *q, SystemLibraryBackend *backend) noexcept
 {
     q_ptr = q;
-    if (!g_bSystemEnvironmentDetected) {
-        g_bSystemEnvironmentDetected = true;
-        if (WindowsVersion::CurrentVersion() >= WindowsVersion::Windows_8) {
-            g_bLoadFromSystem32Available = true;
-        } else {
-            g_bLoadFromSystem32Available = (GetSymbolNoCache(L"kernel32.dll", L"AddDllDirectory") != nullptr);
-        }
-        std::wstring dbgMsg = LR"("LOAD_LIBRARY_SEARCH_SYSTEM32" is )";
-        if (!g_bLoadFromSystem32Available) {
-            dbgMsg += L"not ";
-        }
-        dbgMsg += std::wstring(L"available on the current platform.\n");
-        OutputDebugStringW(dbgMsg.c_str());
-    }
+    m_backend = (backend ? backend : &SystemLibraryBackend::Default());
 }
 
 SystemLibraryPrivate::~SystemLibraryPrivate() noexcept
 {
     if (Loaded()) {
-        const bool result = Load(false);
         // The result is not important here.
-        UNREFERENCED_PARAMETER(result);
+        [[maybe_unused]] const bool result = Load(false);
     }
 }
 
@@ -151,166 +127,141 @@ bool SystemLibraryPrivate::Load(const bool load) noexcept
             // No need to reload an already loaded library.
             return true;
         }
-        if (m_failedToLoad) {
+        if (m_failedToLoad && !ShouldRetry(m_failureGeneration)) {
             // Avoid loading a library which can't be loaded over and over again.
             return false;
         }
         if (m_fileName.empty()) {
-            OutputDebugStringW(L"Can't load the system library now due to the file name has not been set yet.");
+            LOG_DEBUG(L"Can't load the system library now due to the file name has not been set yet.");
             return false;
         }
-        {
-            const std::wstring dbgMsg = std::wstring(LR"(Loading system library ")") + m_fileName + std::wstring(LR"(" ......)") + L'\n';
-            OutputDebugStringW(dbgMsg.c_str());
-        }
-        HMODULE module = nullptr;
-        if (g_bLoadFromSystem32Available) {
-            module = LoadLibraryExW(m_fileName.c_str(), nullptr, LOAD_LIBRARY_SEARCH_SYSTEM32);
-        } else {
-            module = LoadLibraryW(m_fileName.c_str());
-        }
+        LOG_DEBUG(L"Loading system library \"{}\" ......", m_fileName);
+        // Read it before trying, a rescan in the meantime must not be missed.
+        const std::uint64_t generation = g_generation.load(std::memory_order_acquire);
+        const HMODULE module = m_backend->Open(m_fileName);
         if (!module) {
-            const std::wstring dbgMsg = std::wstring(L"Loading failed.\n");
-            OutputDebugStringW(dbgMsg.c_str());
+            LOG_DEBUG(L"Loading failed.");
             m_failedToLoad = true;
+            m_failureGeneration = generation;
             return false;
         }
-        {
-            const std::wstring dbgMsg = std::wstring(L"Loading finished successfully.\n");
-            OutputDebugStringW(dbgMsg.c_str());
-        }
+        m_failedToLoad = false;
+        LOG_DEBUG(L"Loading finished successfully.");
         m_module = module;
     } else {
         if (!Loaded()) {
             // No need to unload a library which has not been loaded yet.
             return true;
         }
-        {
-            const std::wstring dbgMsg = std::wstring(LR"(Unloading system library ")") + m_fileName + std::wstring(LR"(" ......)") + L'\n';
-            OutputDebugStringW(dbgMsg.c_str());
-        }
+        LOG_DEBUG(L"Unloading system library \"{}\" ......", m_fileName);
         m_fileName = {};
         if (!m_resolvedSymbols.empty()) {
-            bool hasContent = false;
-            std::wstring dbgMsg = L"Cached symbols: [";
+            std::wstring names = {};
             for (auto &&symbol : std::as_const(m_resolvedSymbols)) {
                 const std::wstring &name = symbol.first;
                 // It may never be empty, but let's be safe.
                 if (!name.empty()) {
-                    dbgMsg += name + std::wstring(L"(), ");
-                    if (!hasContent) {
-                        hasContent = true;
+                    if (!names.empty()) {
+                        names += std::wstring(L", ");
                     }
+                    names += name + std::wstring(L"()");
                 }
             }
-            if (hasContent) {
-                dbgMsg.erase(dbgMsg.cend() - 2);
-            }
-            dbgMsg += std::wstring(L"]\n");
-            OutputDebugStringW(dbgMsg.c_str());
+            LOG_DEBUG(L"Cached symbols: [{}]", names);
             m_resolvedSymbols = {};
         }
         // Reset it to "false" to avoid blocking us from re-use the current instance.
         m_failedToLoad = false;
-        const BOOL result = FreeLibrary(m_module);
+        m_failureGeneration = 0;
+        const bool result = m_backend->Close(m_module);
         m_module = nullptr;
-        if (result == FALSE) {
-            const std::wstring dbgMsg = std::wstring(L"Unloading failed.\n");
-            OutputDebugStringW(dbgMsg.c_str());
+        if (!result) {
+            LOG_DEBUG(L"Unloading failed.");
             return false;
         }
-        {
-            const std::wstring dbgMsg = std::wstring(L"Unloading finished successfully.\n");
-            OutputDebugStringW(dbgMsg.c_str());
-        }
+        LOG_DEBUG(L"Unloading finished successfully.");
     }
     return true;
 }
 
-FARPROC SystemLibraryPrivate::GetSymbol(const std::wstring &function) noexcept
+bool SystemLibraryPrivate::ShouldLoad() const noexcept
 {
-    if (m_failedToLoad) {
-        // Don't try further if the library can't be loaded successfully.
-        return nullptr;
+    if (Loaded()) {
+        return false;
     }
+    return (!m_failedToLoad || ShouldRetry(m_failureGeneration));
+}
+
+FARPROC SystemLibraryPrivate::GetSymbol(const std::wstring &function) noexcept
+{
     // Return early if the parameter is not valid.
     if (function.empty()) {
         return nullptr;
     }
     if (!Loaded()) {
+        // "Load()" doesn't touch the file system again unless the retry policy allows it.
         if (!Load(true)) {
             return nullptr;
         }
     }
-    bool shouldInsert = true;
-    FARPROC address = nullptr;
-    const auto resolve = [this](const std::wstring &nameWide) -> FARPROC {
-        // "nameWide" may never be empty, but let's be safe.
-        if (nameWide.empty()) {
-            return nullptr;
-        }
-        const std::string nameMultiByte = UTF16ToUTF8(nameWide);
-        // "nameMultiByte" may never be empty, but let's be safe.
-        if (nameMultiByte.empty()) {
-            return nullptr;
-        }
-        const FARPROC address = GetProcAddress(m_module, nameMultiByte.c_str());
-        if (!address) {
-            const std::wstring dbgMsg = std::wstring(LR"(Failed to resolve symbol ")") + nameWide + std::wstring(L"()\" from \"") + m_fileName + std::wstring(LR"(".)") + L'\n';
-            OutputDebugStringW(dbgMsg.c_str());
-            return nullptr;
-        }
-        return address;
-    };
-    if (m_resolvedSymbols.empty()) {
-        address = resolve(function);
-    } else {
-        const auto search = m_resolvedSymbols.find(function);
-        if (search == m_resolvedSymbols.cend()) {
-            address = resolve(function);
-        } else {
-            shouldInsert = false;
-            address = search->second;
+    const auto search = m_resolvedSymbols.find(function);
+    if (search != m_resolvedSymbols.cend()) {
+        const SystemLibrarySymbol &symbol = search->second;
+        // Both a known address and a failure which should not be retried yet cost a single lookup.
+        if (symbol.Address || !ShouldRetry(symbol.Generation)) {
+            return symbol.Address;
         }
     }
-    if (shouldInsert) {
-        // We intend to append the symbol address to the cache list unconditionally even if
-        // we failed to resolve it to avoid unneeded resolving operations afterwards.
-        m_resolvedSymbols.insert({function, address});
+    PROFILE_SCOPE(L"SystemLibrary::Resolve")
+    // We intend to cache the symbol unconditionally even if we failed to resolve it
+    // to avoid unneeded resolving operations afterwards, see "ShouldRetry()".
+    SystemLibrarySymbol symbol = {};
+    symbol.Generation = g_generation.load(std::memory_order_acquire);
+    symbol.Address = m_backend->Resolve(m_module, function);
+    if (!symbol.Address) {
+        LOG_DEBUG(L"Failed to resolve symbol \"{}()\" from \"{}\".", function, m_fileName);
     }
-    return address;
+    m_resolvedSymbols.insert_or_assign(function, symbol);
+    return symbol.Address;
 }
 
-FARPROC SystemLibraryPrivate::GetSymbolNoCache(const std::wstring &fileName, const std::wstring &function) noexcept
+SystemLibraryRetryPolicy SystemLibraryPrivate::RetryPolicy() const noexcept
 {
-    if (fileName.empty() || function.empty()) {
-        return nullptr;
-    }
-    const HMODULE module = GetModuleHandleW(fileName.c_str());
-    if (!module) {
-        const std::wstring dbgMsg = std::wstring(LR"(Failed to retrieve the module handle of ")") + function + std::wstring(LR"(".)") + L'\n';
-        OutputDebugStringW(dbgMsg.c_str());
-        return nullptr;
-    }
-    // "functionMultiByte" may never be empty, but let's be safe.
-    const std::string functionMultiByte = UTF16ToUTF8(function);
-    if (functionMultiByte.empty()) {
-        return nullptr;
-    }
-    const FARPROC address = GetProcAddress(module, functionMultiByte.c_str());
-    if (!address) {
-        const std::wstring dbgMsg = std::wstring(LR"(Failed to resolve symbol ")") + function + std::wstring(L"()\" from \"") + fileName + std::wstring(LR"(".)") + L'\n';
-        OutputDebugStringW(dbgMsg.c_str());
-        return nullptr;
+    return m_retryPolicy;
+}
+
+void SystemLibraryPrivate::RetryPolicy(const SystemLibraryRetryPolicy policy) noexcept
+{
+    m_retryPolicy = policy;
+}
+
+bool SystemLibraryPrivate::ShouldRetry(const std::uint64_t failureGeneration) const noexcept
+{
+    switch (m_retryPolicy) {
+    case SystemLibraryRetryPolicy::Never:
+        return false;
+    case SystemLibraryRetryPolicy::AfterRescan:
+        return (failureGeneration != g_generation.load(std::memory_order_acquire));
+    case SystemLibraryRetryPolicy::Always:
+        return true;
     }
-    return address;
+    return false;
+}
+
+FARPROC SystemLibraryPrivate::GetSymbolNoCache(const std::wstring &fileName, const std::wstring &function) noexcept
+{
+    return SystemLibraryBackend::Default().ResolveNoCache(fileName, function);
 }
 
-SystemLibrary::SystemLibrary() noexcept : d_ptr(std::make_unique<SystemLibraryPrivate>(this))
+SystemLibrary::SystemLibrary() noexcept : d_ptr(std::make_unique<SystemLibraryPrivate>(this, nullptr))
 {
 }
 
-SystemLibrary::SystemLibrary(const std::wstring &fileName) noexcept : SystemLibrary()
+SystemLibrary::SystemLibrary(const std::wstring &fileName) noexcept : SystemLibrary(fileName, nullptr)
+{
+}
+
+SystemLibrary::SystemLibrary(const std::wstring &fileName, SystemLibraryBackend *backend) noexcept : d_ptr(std::make_unique<SystemLibraryPrivate>(this, backend))
 {
     FileName(fileName);
 }
@@ -337,11 +288,36 @@ bool SystemLibrary::Load(const bool load) noexcept
     return d_ptr->Load(load);
 }
 
+bool SystemLibrary::ShouldLoad() const noexcept
+{
+    return d_ptr->ShouldLoad();
+}
+
 FARPROC SystemLibrary::GetSymbol(const std::wstring &function) noexcept
 {
     return d_ptr->GetSymbol(function);
 }
 
+SystemLibraryRetryPolicy SystemLibrary::RetryPolicy() const noexcept
+{
+    return d_ptr->RetryPolicy();
+}
+
+void SystemLibrary::RetryPolicy(const SystemLibraryRetryPolicy policy) noexcept
+{
+    d_ptr->RetryPolicy(policy);
+}
+
+std::uint64_t SystemLibrary::Generation() noexcept
+{
+    return g_generation.load(std::memory_order_acquire);
+}
+
+void SystemLibrary::Rescan() noexcept
+{
+    g_generation.fetch_add(1, std::memory_order_acq_rel);
+}
+
 FARPROC SystemLibrary::GetSymbolNoCache(const std::wstring &fileName, const std::wstring &function) noexcept
 {
     return SystemLibraryPrivate::GetSymbolNoCache(fileName, function);
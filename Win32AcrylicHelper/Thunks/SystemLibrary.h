@@ -24,10 +24,18 @@
 
 #pragma once
 
-#include <SDKDDKVer.h>
-#include <Windows.h>
+#include "SystemLibraryBackend.h"
 #include <string>
 #include <memory>
+#include <cstdint>
+
+// What to do with a library or a symbol which could not be found before.
+enum class SystemLibraryRetryPolicy : int
+{
+    Never = 0, // Keep failing until the library is unloaded.
+    AfterRescan = 1, // Try once more after every "SystemLibrary::Rescan()".
+    Always = 2 // Don't remember failures at all.
+};
 
 class SystemLibraryPrivate;
 
@@ -36,6 +44,7 @@ class SystemLibrary
 public:
     explicit SystemLibrary() noexcept;
     explicit SystemLibrary(const std::wstring &fileName) noexcept;
+    explicit SystemLibrary(const std::wstring &fileName, SystemLibraryBackend *backend) noexcept;
     ~SystemLibrary() noexcept;
 
     void FileName(const std::wstring &fileName) noexcept;
@@ -43,9 +52,19 @@ public:
 
     [[nodiscard]] bool Loaded() const noexcept;
     [[nodiscard]] bool Load(const bool load) noexcept;
+    // False if the library is loaded already or a failed load may not be retried yet.
+    [[nodiscard]] bool ShouldLoad() const noexcept;
 
     [[nodiscard]] FARPROC GetSymbol(const std::wstring &function) noexcept;
 
+    [[nodiscard]] SystemLibraryRetryPolicy RetryPolicy() const noexcept;
+    void RetryPolicy(const SystemLibraryRetryPolicy policy) noexcept;
+
+    // Failures are stamped with the generation they happened in. Starting a new
+    // generation lets them be retried, e.g. after a component has been installed.
+    [[nodiscard]] static std::uint64_t Generation() noexcept;
+    static void Rescan() noexcept;
+
     [[nodiscard]] static FARPROC GetSymbolNoCache(const std::wstring &fileName, const std::wstring &function) noexcept;
 
 private:
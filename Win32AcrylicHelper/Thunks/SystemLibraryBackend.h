@@ -0,0 +1,139 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#ifdef _WIN32
+#include <SDKDDKVer.h>
+#include <Windows.h>
+#else // _WIN32
+// Keep the Win32 spellings so that the loader cache compiles unchanged on POSIX.
+using HMODULE = void *;
+using FARPROC = void (*)();
+#endif // _WIN32
+
+#include <string>
+#include <map>
+#include <mutex>
+
+// The platform specific part of the dynamic library loader. "SystemLibrary" and
+// "SystemLibraryManager" only contain the caching logic and talk to the operating
+// system exclusively through this interface.
+class SystemLibraryBackend
+{
+public:
+    virtual ~SystemLibraryBackend() noexcept = default;
+
+    // Map the given library into the current process and take a reference on it.
+    [[nodiscard]] virtual HMODULE Open(const std::wstring &fileName) noexcept = 0;
+    // Drop the reference taken by "Open()".
+    [[nodiscard]] virtual bool Close(const HMODULE module) noexcept = 0;
+    [[nodiscard]] virtual FARPROC Resolve(const HMODULE module, const std::wstring &function) noexcept = 0;
+    // Resolve a symbol from a library which has already been mapped into the current
+    // process, without loading it and without taking a reference on it.
+    [[nodiscard]] virtual FARPROC ResolveNoCache(const std::wstring &fileName, const std::wstring &function) noexcept = 0;
+    virtual void Trace(const std::wstring &message) noexcept = 0;
+
+    // The backend of the current platform: "LoadLibraryExW()" & friends on Windows,
+    // "dlopen()" & friends on POSIX systems.
+    [[nodiscard]] static SystemLibraryBackend &Default() noexcept;
+};
+
+// An in-memory loader. Libraries and symbols only exist once they have been added,
+// the way a component installed at run time shows up. Every call is counted.
+class MockSystemLibraryBackend final : public SystemLibraryBackend
+{
+public:
+    inline explicit MockSystemLibraryBackend() noexcept = default;
+    inline ~MockSystemLibraryBackend() noexcept override = default;
+
+    [[nodiscard]] inline HMODULE Open(const std::wstring &fileName) noexcept override {
+        const std::scoped_lock lock(m_mutex);
+        ++m_openCount;
+        const auto it = m_libraries.find(fileName);
+        return ((it == m_libraries.end()) ? nullptr : reinterpret_cast<HMODULE>(&it->second));
+    }
+    [[nodiscard]] inline bool Close(const HMODULE module) noexcept override {
+        const std::scoped_lock lock(m_mutex);
+        ++m_closeCount;
+        return (module != nullptr);
+    }
+    [[nodiscard]] inline FARPROC Resolve(const HMODULE module, const std::wstring &function) noexcept override {
+        const std::scoped_lock lock(m_mutex);
+        ++m_resolveCount;
+        if (!module) {
+            return nullptr;
+        }
+        const auto symbols = reinterpret_cast<const std::map<std::wstring, FARPROC> *>(module);
+        const auto it = symbols->find(function);
+        return ((it == symbols->end()) ? nullptr : it->second);
+    }
+    [[nodiscard]] inline FARPROC ResolveNoCache(const std::wstring &fileName, const std::wstring &function) noexcept override {
+        const std::scoped_lock lock(m_mutex);
+        const auto library = m_libraries.find(fileName);
+        if (library == m_libraries.end()) {
+            return nullptr;
+        }
+        const auto it = library->second.find(function);
+        return ((it == library->second.end()) ? nullptr : it->second);
+    }
+    // Nothing to trace, the counters tell what happened.
+    inline void Trace([[maybe_unused]] const std::wstring &message) noexcept override {
+    }
+
+    inline void AddLibrary(const std::wstring &fileName) noexcept {
+        const std::scoped_lock lock(m_mutex);
+        m_libraries[fileName];
+    }
+    inline void AddSymbol(const std::wstring &fileName, const std::wstring &function, const FARPROC address) noexcept {
+        const std::scoped_lock lock(m_mutex);
+        m_libraries[fileName].insert_or_assign(function, address);
+    }
+    [[nodiscard]] inline int OpenCount() const noexcept {
+        const std::scoped_lock lock(m_mutex);
+        return m_openCount;
+    }
+    [[nodiscard]] inline int CloseCount() const noexcept {
+        const std::scoped_lock lock(m_mutex);
+        return m_closeCount;
+    }
+    [[nodiscard]] inline int ResolveCount() const noexcept {
+        const std::scoped_lock lock(m_mutex);
+        return m_resolveCount;
+    }
+
+private:
+    MockSystemLibraryBackend(const MockSystemLibraryBackend &) = delete;
+    MockSystemLibraryBackend &operator=(const MockSystemLibraryBackend &) = delete;
+    MockSystemLibraryBackend(MockSystemLibraryBackend &&) = delete;
+    MockSystemLibraryBackend &operator=(MockSystemLibraryBackend &&) = delete;
+
+private:
+    mutable std::mutex m_mutex = {};
+    // The module handles point to the symbol tables, which never move in a "std::map".
+    std::map<std::wstring, std::map<std::wstring, FARPROC>> m_libraries = {};
+    int m_openCount = 0;
+    int m_closeCount = 0;
+    int m_resolveCount = 0;
+};
@@ -0,0 +1,148 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _WIN32
+
+#include "SystemLibraryBackend.h"
+#include <cstdio>
+#include <utility>
+#include <dlfcn.h>
+
+[[nodiscard]] static inline std::string UTF32ToUTF8(const std::wstring &UTF32String) noexcept
+{
+    // "wchar_t" is 32 bits wide on all the POSIX systems we care about.
+    std::string UTF8String = {};
+    UTF8String.reserve(UTF32String.size());
+    for (auto &&ch : std::as_const(UTF32String)) {
+        const auto cp = static_cast<char32_t>(ch);
+        if (cp < 0x80) {
+            UTF8String += static_cast<char>(cp);
+        } else if (cp < 0x800) {
+            UTF8String += static_cast<char>(0xC0 | (cp >> 6));
+            UTF8String += static_cast<char>(0x80 | (cp & 0x3F));
+        } else if (cp < 0x10000) {
+            UTF8String += static_cast<char>(0xE0 | (cp >> 12));
+            UTF8String += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            UTF8String += static_cast<char>(0x80 | (cp & 0x3F));
+        } else {
+            UTF8String += static_cast<char>(0xF0 | (cp >> 18));
+            UTF8String += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+            UTF8String += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            UTF8String += static_cast<char>(0x80 | (cp & 0x3F));
+        }
+    }
+    return UTF8String;
+}
+
+class POSIXSystemLibraryBackend final : public SystemLibraryBackend
+{
+public:
+    explicit POSIXSystemLibraryBackend() noexcept = default;
+    ~POSIXSystemLibraryBackend() noexcept override = default;
+
+    [[nodiscard]] HMODULE Open(const std::wstring &fileName) noexcept override;
+    [[nodiscard]] bool Close(const HMODULE module) noexcept override;
+    [[nodiscard]] FARPROC Resolve(const HMODULE module, const std::wstring &function) noexcept override;
+    [[nodiscard]] FARPROC ResolveNoCache(const std::wstring &fileName, const std::wstring &function) noexcept override;
+    void Trace(const std::wstring &message) noexcept override;
+
+private:
+    POSIXSystemLibraryBackend(const POSIXSystemLibraryBackend &) = delete;
+    POSIXSystemLibraryBackend &operator=(const POSIXSystemLibraryBackend &) = delete;
+    POSIXSystemLibraryBackend(POSIXSystemLibraryBackend &&) = delete;
+    POSIXSystemLibraryBackend &operator=(POSIXSystemLibraryBackend &&) = delete;
+};
+
+HMODULE POSIXSystemLibraryBackend::Open(const std::wstring &fileName) noexcept
+{
+    const std::string fileNameMultiByte = UTF32ToUTF8(fileName);
+    if (fileNameMultiByte.empty()) {
+        return nullptr;
+    }
+    return dlopen(fileNameMultiByte.c_str(), (RTLD_NOW | RTLD_LOCAL));
+}
+
+bool POSIXSystemLibraryBackend::Close(const HMODULE module) noexcept
+{
+    if (!module) {
+        return false;
+    }
+    return (dlclose(module) == 0);
+}
+
+FARPROC POSIXSystemLibraryBackend::Resolve(const HMODULE module, const std::wstring &function) noexcept
+{
+    if (!module || function.empty()) {
+        return nullptr;
+    }
+    const std::string functionMultiByte = UTF32ToUTF8(function);
+    // "functionMultiByte" may never be empty, but let's be safe.
+    if (functionMultiByte.empty()) {
+        return nullptr;
+    }
+    return reinterpret_cast<FARPROC>(dlsym(module, functionMultiByte.c_str()));
+}
+
+FARPROC POSIXSystemLibraryBackend::ResolveNoCache(const std::wstring &fileName, const std::wstring &function) noexcept
+{
+    if (fileName.empty() || function.empty()) {
+        return nullptr;
+    }
+    const std::string fileNameMultiByte = UTF32ToUTF8(fileName);
+    // RTLD_NOLOAD is the closest thing to "GetModuleHandleW()", but unlike the latter
+    // it increases the reference count of the library, so drop it again afterwards.
+    const HMODULE module = dlopen(fileNameMultiByte.c_str(), (RTLD_NOW | RTLD_NOLOAD));
+    if (!module) {
+        const std::wstring dbgMsg = std::wstring(LR"(Failed to retrieve the module handle of ")") + fileName + std::wstring(LR"(".)") + L'\n';
+        Trace(dbgMsg);
+        return nullptr;
+    }
+    const FARPROC address = Resolve(module, function);
+    [[maybe_unused]] const bool result = Close(module);
+    if (!address) {
+        const std::wstring dbgMsg = std::wstring(LR"(Failed to resolve symbol ")") + function + std::wstring(L"()\" from \"") + fileName + std::wstring(LR"(".)") + L'\n';
+        Trace(dbgMsg);
+        return nullptr;
+    }
+    return address;
+}
+
+void POSIXSystemLibraryBackend::Trace(const std::wstring &message) noexcept
+{
+#ifdef NDEBUG
+    static_cast<void>(message);
+#else // NDEBUG
+    if (!message.empty()) {
+        std::fputs(UTF32ToUTF8(message).c_str(), stderr);
+    }
+#endif // NDEBUG
+}
+
+SystemLibraryBackend &SystemLibraryBackend::Default() noexcept
+{
+    static POSIXSystemLibraryBackend backend;
+    return backend;
+}
+
+#endif // _WIN32
@@ -0,0 +1,157 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifdef _WIN32
+
+#include "SystemLibraryBackend.h"
+#include "WindowsVersion.h"
+
+[[nodiscard]] static inline std::string UTF16ToUTF8(const std::wstring &UTF16String) noexcept
+{
+    if (UTF16String.empty()) {
+        return {};
+    }
+    const auto originalString = &UTF16String[0];
+    const int newLength = WideCharToMultiByte(CP_UTF8, 0, originalString, -1, nullptr, 0, nullptr, nullptr);
+    if (newLength <= 0) {
+        return {};
+    }
+    std::string UTF8String(newLength, '\0');
+    WideCharToMultiByte(CP_UTF8, 0, originalString, -1, &UTF8String[0], newLength, nullptr, nullptr);
+    return UTF8String;
+}
+
+class Win32SystemLibraryBackend final : public SystemLibraryBackend
+{
+public:
+    explicit Win32SystemLibraryBackend() noexcept = default;
+    ~Win32SystemLibraryBackend() noexcept override = default;
+
+    [[nodiscard]] HMODULE Open(const std::wstring &fileName) noexcept override;
+    [[nodiscard]] bool Close(const HMODULE module) noexcept override;
+    [[nodiscard]] FARPROC Resolve(const HMODULE module, const std::wstring &function) noexcept override;
+    [[nodiscard]] FARPROC ResolveNoCache(const std::wstring &fileName, const std::wstring &function) noexcept override;
+    void Trace(const std::wstring &message) noexcept override;
+
+private:
+    Win32SystemLibraryBackend(const Win32SystemLibraryBackend &) = delete;
+    Win32SystemLibraryBackend &operator=(const Win32SystemLibraryBackend &) = delete;
+    Win32SystemLibraryBackend(Win32SystemLibraryBackend &&) = delete;
+    Win32SystemLibraryBackend &operator=(Win32SystemLibraryBackend &&) = delete;
+
+private:
+    [[nodiscard]] bool IsLoadFromSystem32Available() noexcept;
+};
+
+bool Win32SystemLibraryBackend::IsLoadFromSystem32Available() noexcept
+{
+    // Don't do this in the constructor: "WindowsVersion::CurrentVersion()" resolves
+    // "RtlGetVersion()" through us, constructing it from there would recurse.
+    // Libraries may be opened from several threads at the same time (see
+    // "SystemLibraryManager::Preload()"), the static initialization guards that.
+    static const bool available = [this]() -> bool {
+        bool result = false;
+        if (WindowsVersion::CurrentVersion() >= WindowsVersion::Windows_8) {
+            result = true;
+        } else {
+            result = (ResolveNoCache(L"kernel32.dll", L"AddDllDirectory") != nullptr);
+        }
+        std::wstring dbgMsg = LR"("LOAD_LIBRARY_SEARCH_SYSTEM32" is )";
+        if (!result) {
+            dbgMsg += L"not ";
+        }
+        dbgMsg += std::wstring(L"available on the current platform.\n");
+        Trace(dbgMsg);
+        return result;
+    }();
+    return available;
+}
+
+HMODULE Win32SystemLibraryBackend::Open(const std::wstring &fileName) noexcept
+{
+    if (fileName.empty()) {
+        return nullptr;
+    }
+    if (IsLoadFromSystem32Available()) {
+        return LoadLibraryExW(fileName.c_str(), nullptr, LOAD_LIBRARY_SEARCH_SYSTEM32);
+    } else {
+        return LoadLibraryW(fileName.c_str());
+    }
+}
+
+bool Win32SystemLibraryBackend::Close(const HMODULE module) noexcept
+{
+    if (!module) {
+        return false;
+    }
+    return (FreeLibrary(module) != FALSE);
+}
+
+FARPROC Win32SystemLibraryBackend::Resolve(const HMODULE module, const std::wstring &function) noexcept
+{
+    if (!module || function.empty()) {
+        return nullptr;
+    }
+    const std::string functionMultiByte = UTF16ToUTF8(function);
+    // "functionMultiByte" may never be empty, but let's be safe.
+    if (functionMultiByte.empty()) {
+        return nullptr;
+    }
+    return GetProcAddress(module, functionMultiByte.c_str());
+}
+
+FARPROC Win32SystemLibraryBackend::ResolveNoCache(const std::wstring &fileName, const std::wstring &function) noexcept
+{
+    if (fileName.empty() || function.empty()) {
+        return nullptr;
+    }
+    const HMODULE module = GetModuleHandleW(fileName.c_str());
+    if (!module) {
+        const std::wstring dbgMsg = std::wstring(LR"(Failed to retrieve the module handle of ")") + fileName + std::wstring(LR"(".)") + L'\n';
+        Trace(dbgMsg);
+        return nullptr;
+    }
+    const FARPROC address = Resolve(module, function);
+    if (!address) {
+        const std::wstring dbgMsg = std::wstring(LR"(Failed to resolve symbol ")") + function + std::wstring(L"()\" from \"") + fileName + std::wstring(LR"(".)") + L'\n';
+        Trace(dbgMsg);
+        return nullptr;
+    }
+    return address;
+}
+
+void Win32SystemLibraryBackend::Trace(const std::wstring &message) noexcept
+{
+    if (!message.empty()) {
+        OutputDebugStringW(message.c_str());
+    }
+}
+
+SystemLibraryBackend &SystemLibraryBackend::Default() noexcept
+{
+    static Win32SystemLibraryBackend backend;
+    return backend;
+}
+
+#endif // _WIN32
@@ -23,8 +23,12 @@
  */
 
 #include "SystemLibraryManager.h"
-#include "SystemLibrary.h"
+#include "Log.h"
+#include "Profiler.h"
 #include <unordered_map>
+#include <utility>
+#include <mutex>
+#include <algorithm>
 
 class SystemLibraryManagerPrivate
 {
@@ -36,6 +40,17 @@ public:
 
     void Release() noexcept;
 
+    [[nodiscard]] SystemLibraryBackend *Backend() const noexcept;
+    void Backend(SystemLibraryBackend *backend) noexcept;
+
+    void RegisterGroup(const std::wstring &name, const std::vector<std::wstring> &fileNames) noexcept;
+    [[nodiscard]] bool Preload(const std::wstring &group, const bool parallel) noexcept;
+    [[nodiscard]] std::vector<SystemLibraryLoadRecord> LoadTimeline() const noexcept;
+
+    [[nodiscard]] SystemLibraryRetryPolicy RetryPolicy() const noexcept;
+    void RetryPolicy(const SystemLibraryRetryPolicy policy) noexcept;
+    void Rescan() noexcept;
+
 private:
     explicit SystemLibraryManagerPrivate(const SystemLibraryManagerPrivate &) noexcept = delete;
     explicit SystemLibraryManagerPrivate(SystemLibraryManagerPrivate &&) noexcept = delete;
@@ -43,14 +58,32 @@ private:
     SystemLibraryManagerPrivate &operator=(const SystemLibraryManagerPrivate &) const noexcept = delete;
     SystemLibraryManagerPrivate &operator=(SystemLibraryManagerPrivate &&) const noexcept = delete;
 
+private:
+    // The caller must hold "m_mutex".
+    [[nodiscard]] std::shared_ptr<SystemLibrary> Acquire(const std::wstring &fileName) noexcept;
+    [[nodiscard]] static SystemLibraryLoadRecord LoadTimed(SystemLibrary &library, const std::wstring &group) noexcept;
+    void TraceLoadRecord(const SystemLibraryLoadRecord &record) const noexcept;
+
 private:
     SystemLibraryManager *q_ptr = nullptr;
+    SystemLibraryBackend *m_backend = nullptr;
+    SystemLibraryRetryPolicy m_retryPolicy = SystemLibraryRetryPolicy::AfterRescan;
+    // Recursive: reporting a failure may end up calling a thunk on the same thread.
+    mutable std::recursive_mutex m_mutex = {};
     std::unordered_map<std::wstring, std::shared_ptr<SystemLibrary>> m_loadedLibraries = {};
+    std::unordered_map<std::wstring, std::vector<std::wstring>> m_groups = {};
+    std::vector<SystemLibraryLoadRecord> m_timeline = {};
 };
 
 SystemLibraryManagerPrivate::SystemLibraryManagerPrivate(SystemLibraryManager *q) noexcept
 {
     q_ptr = q;
+    // Construct the default backend before us, so that it's destroyed after us:
+    // the libraries still need it when they are unloaded at exit.
+    [[maybe_unused]] const SystemLibraryBackend &defaultBackend = SystemLibraryBackend::Default();
+    m_groups.insert({SystemLibraryGroups::Window, {L"user32.dll", L"gdi32.dll", L"dwmapi.dll", L"uxtheme.dll", L"shcore.dll"}});
+    m_groups.insert({SystemLibraryGroups::Composition, {L"dcomp.dll", L"d3d11.dll", L"D2D1.dll", L"coremessaging.dll"}});
+    m_groups.insert({SystemLibraryGroups::COM, {L"combase.dll", L"ole32.dll", L"oleaut32.dll"}});
 }
 
 SystemLibraryManagerPrivate::~SystemLibraryManagerPrivate() noexcept
@@ -58,33 +91,60 @@ SystemLibraryManagerPrivate::~SystemLibraryManagerPrivate() noexcept
     Release();
 }
 
+std::shared_ptr<SystemLibrary> SystemLibraryManagerPrivate::Acquire(const std::wstring &fileName) noexcept
+{
+    const auto search = m_loadedLibraries.find(fileName);
+    if (search != m_loadedLibraries.cend()) {
+        return search->second;
+    }
+    const auto library = std::make_shared<SystemLibrary>(fileName, m_backend);
+    library->RetryPolicy(m_retryPolicy);
+    m_loadedLibraries.insert({fileName, library});
+    return library;
+}
+
+SystemLibraryLoadRecord SystemLibraryManagerPrivate::LoadTimed(SystemLibrary &library, const std::wstring &group) noexcept
+{
+    PROFILE_SCOPE(L"SystemLibrary::Load")
+    SystemLibraryLoadRecord record = {};
+    record.FileName = library.FileName();
+    record.Group = group;
+    record.Thread = std::this_thread::get_id();
+    record.Start = std::chrono::steady_clock::now();
+    record.Loaded = library.Load(true);
+    record.Finish = std::chrono::steady_clock::now();
+    return record;
+}
+
+void SystemLibraryManagerPrivate::TraceLoadRecord(const SystemLibraryLoadRecord &record) const noexcept
+{
+    const auto duration = std::chrono::duration_cast<std::chrono::microseconds>(record.Finish - record.Start);
+    LOG_DEBUG(L"Library \"{}\" (group \"{}\") loaded: {}, took {} microseconds.", record.FileName, record.Group, record.Loaded, duration.count());
+}
+
 FARPROC SystemLibraryManagerPrivate::GetSymbol(const std::wstring &fileName, const std::wstring &symbolName) noexcept
 {
     if (fileName.empty() || symbolName.empty()) {
         return nullptr;
     }
-    bool shouldInsert = true;
-    std::shared_ptr<SystemLibrary> library = nullptr;
-    if (m_loadedLibraries.empty()) {
-        library = std::make_shared<SystemLibrary>(fileName);
-    } else {
-        const auto search = m_loadedLibraries.find(fileName);
-        if (search == m_loadedLibraries.cend()) {
-            library = std::make_shared<SystemLibrary>(fileName);
-        } else {
-            shouldInsert = false;
-            library = search->second;
-        }
+    const std::scoped_lock lock(m_mutex);
+    const std::shared_ptr<SystemLibrary> library = Acquire(fileName);
+    // "library" may never be null, but let's be safe.
+    if (!library) {
+        return nullptr;
     }
-    if (shouldInsert) {
-        m_loadedLibraries.insert({fileName, library});
+    if (library->ShouldLoad()) {
+        // Not preloaded, record the on-demand load as well to make the timeline complete.
+        const SystemLibraryLoadRecord record = LoadTimed(*library, {});
+        TraceLoadRecord(record);
+        m_timeline.push_back(record);
     }
-    // "library" may never be null, but let's be safe.
-    return (library ? library->GetSymbol(symbolName) : nullptr);
+    return library->GetSymbol(symbolName);
 }
 
 void SystemLibraryManagerPrivate::Release() noexcept
 {
+    const std::scoped_lock lock(m_mutex);
     if (m_loadedLibraries.empty()) {
         return;
     }
@@ -92,15 +152,131 @@ void SystemLibraryManagerPrivate::Release() noexcept
         auto pLibrary = library.second;
         // It may never be null, but let's be safe.
         if (pLibrary) {
-            const bool result = pLibrary->Load(false);
             // The result is not important here.
-            UNREFERENCED_PARAMETER(result);
+            [[maybe_unused]] const bool result = pLibrary->Load(false);
             pLibrary.reset();
         }
     }
     m_loadedLibraries = {};
 }
 
+SystemLibraryBackend *SystemLibraryManagerPrivate::Backend() const noexcept
+{
+    return m_backend;
+}
+
+void SystemLibraryManagerPrivate::Backend(SystemLibraryBackend *backend) noexcept
+{
+    const std::scoped_lock lock(m_mutex);
+    if (!m_loadedLibraries.empty()) {
+        // The cached libraries were opened by the previous backend.
+        return;
+    }
+    m_backend = backend;
+}
+
+void SystemLibraryManagerPrivate::RegisterGroup(const std::wstring &name, const std::vector<std::wstring> &fileNames) noexcept
+{
+    if (name.empty()) {
+        return;
+    }
+    const std::scoped_lock lock(m_mutex);
+    m_groups.insert_or_assign(name, fileNames);
+}
+
+bool SystemLibraryManagerPrivate::Preload(const std::wstring &group, const bool parallel) noexcept
+{
+    PROFILE_SCOPE(L"SystemLibraryManager::Preload")
+    if (group.empty()) {
+        return false;
+    }
+    // Held during the whole preload: the worker threads don't lock anything themselves,
+    // they only touch their own library and their own record.
+    const std::scoped_lock lock(m_mutex);
+    const auto search = m_groups.find(group);
+    if (search == m_groups.cend()) {
+        LOG_DEBUG(L"Unknown system library group \"{}\".", group);
+        return false;
+    }
+    const std::vector<std::wstring> &fileNames = search->second;
+    std::vector<std::shared_ptr<SystemLibrary>> libraries = {};
+    std::vector<std::shared_ptr<SystemLibrary>> pending = {};
+    for (auto &&fileName : std::as_const(fileNames)) {
+        if (fileName.empty()) {
+            continue;
+        }
+        const std::shared_ptr<SystemLibrary> library = Acquire(fileName);
+        // "library" may never be null, but let's be safe.
+        if (!library) {
+            continue;
+        }
+        libraries.push_back(library);
+        // Loaded libraries are skipped, and so are the failed ones unless the retry policy allows it.
+        if (library->ShouldLoad()) {
+            pending.push_back(library);
+        }
+    }
+    std::vector<SystemLibraryLoadRecord> records(pending.size());
+    if (parallel && (pending.size() > 1)) {
+        std::vector<std::thread> workers = {};
+        workers.reserve(pending.size());
+        for (std::size_t index = 0; index != pending.size(); ++index) {
+            workers.emplace_back([&records, &pending, &group, index](){
+                records[index] = LoadTimed(*pending[index], group);
+            });
+        }
+        for (auto &&worker : workers) {
+            worker.join();
+        }
+    } else {
+        for (std::size_t index = 0; index != pending.size(); ++index) {
+            records[index] = LoadTimed(*pending[index], group);
+        }
+    }
+    std::sort(records.begin(), records.end(), [](const SystemLibraryLoadRecord &lhs, const SystemLibraryLoadRecord &rhs){
+        return (lhs.Finish < rhs.Finish);
+    });
+    for (auto &&record : std::as_const(records)) {
+        TraceLoadRecord(record);
+        m_timeline.push_back(record);
+    }
+    return std::all_of(libraries.cbegin(), libraries.cend(), [](const std::shared_ptr<SystemLibrary> &library){
+        return library->Loaded();
+    });
+}
+
+std::vector<SystemLibraryLoadRecord> SystemLibraryManagerPrivate::LoadTimeline() const noexcept
+{
+    const std::scoped_lock lock(m_mutex);
+    return m_timeline;
+}
+
+SystemLibraryRetryPolicy SystemLibraryManagerPrivate::RetryPolicy() const noexcept
+{
+    const std::scoped_lock lock(m_mutex);
+    return m_retryPolicy;
+}
+
+void SystemLibraryManagerPrivate::RetryPolicy(const SystemLibraryRetryPolicy policy) noexcept
+{
+    const std::scoped_lock lock(m_mutex);
+    m_retryPolicy = policy;
+    for (auto &&library : std::as_const(m_loadedLibraries)) {
+        // It may never be null, but let's be safe.
+        if (library.second) {
+            library.second->RetryPolicy(policy);
+        }
+    }
+}
+
+void SystemLibraryManagerPrivate::Rescan() noexcept
+{
+    const std::scoped_lock lock(m_mutex);
+    // Nothing is reloaded here, the failures are compared against the generation lazily.
+    SystemLibrary::Rescan();
+    LOG_DEBUG(L"Starting system library generation {}.", SystemLibrary::Generation());
+}
+
 SystemLibraryManager::SystemLibraryManager() noexcept : d_ptr(std::make_unique<SystemLibraryManagerPrivate>(this))
 {
 }
@@ -122,3 +298,43 @@ void SystemLibraryManager::Release() noexcept
 {
     d_ptr->Release();
 }
+
+SystemLibraryBackend *SystemLibraryManager::Backend() const noexcept
+{
+    return d_ptr->Backend();
+}
+
+void SystemLibraryManager::Backend(SystemLibraryBackend *backend) noexcept
+{
+    d_ptr->Backend(backend);
+}
+
+void SystemLibraryManager::RegisterGroup(const std::wstring &name, const std::vector<std::wstring> &fileNames) noexcept
+{
+    d_ptr->RegisterGroup(name, fileNames);
+}
+
+bool SystemLibraryManager::Preload(const std::wstring &group, const bool parallel) noexcept
+{
+    return d_ptr->Preload(group, parallel);
+}
+
+std::vector<SystemLibraryLoadRecord> SystemLibraryManager::LoadTimeline() const noexcept
+{
+    return d_ptr->LoadTimeline();
+}
+
+SystemLibraryRetryPolicy SystemLibraryManager::RetryPolicy() const noexcept
+{
+    return d_ptr->RetryPolicy();
+}
+
+void SystemLibraryManager::RetryPolicy(const SystemLibraryRetryPolicy policy) noexcept
+{
+    d_ptr->RetryPolicy(policy);
+}
+
+void SystemLibraryManager::Rescan() noexcept
+{
+    d_ptr->Rescan();
+}
@@ -24,10 +24,36 @@
 
 #pragma once
 
-#include <SDKDDKVer.h>
-#include <Windows.h>
+#include "SystemLibraryBackend.h"
+#include "SystemLibrary.h"
 #include <string>
 #include <memory>
+#include <vector>
+#include <chrono>
+#include <thread>
+
+// Names of the load groups which are always available. Libraries in the same group
+// are usually needed together, preloading them saves the serial cold loads later.
+namespace SystemLibraryGroups
+{
+    // user32, gdi32, dwmapi, uxtheme, shcore
+    [[maybe_unused]] constexpr const wchar_t Window[] = L"Window";
+    // dcomp, d3d11, D2D1, coremessaging
+    [[maybe_unused]] constexpr const wchar_t Composition[] = L"Composition";
+    // combase, ole32, oleaut32
+    [[maybe_unused]] constexpr const wchar_t COM[] = L"COM";
+} // namespace SystemLibraryGroups
+
+struct SystemLibraryLoadRecord
+{
+    std::wstring FileName = {};
+    // Empty if the library was loaded on demand.
+    std::wstring Group = {};
+    std::thread::id Thread = {};
+    std::chrono::steady_clock::time_point Start = {};
+    std::chrono::steady_clock::time_point Finish = {};
+    bool Loaded = false;
+};
 
 class SystemLibraryManagerPrivate;
 
@@ -40,6 +66,27 @@ public:
 
     void Release() noexcept;
 
+    // Replaces the group if it exists already. The file names must be spelled the
+    // same way as the thunks spell them, otherwise the libraries will be loaded twice.
+    void RegisterGroup(const std::wstring &name, const std::vector<std::wstring> &fileNames) noexcept;
+    // Loads all libraries of the group which have not been loaded yet and blocks until
+    // they are all done. Symbol lookups from other threads wait for it as well.
+    [[nodiscard]] bool Preload(const std::wstring &group, const bool parallel) noexcept;
+    // Every load attempt made so far, in the order of completion.
+    [[nodiscard]] std::vector<SystemLibraryLoadRecord> LoadTimeline() const noexcept;
+
+    // Applies to the libraries loaded so far and to all the future ones.
+    [[nodiscard]] SystemLibraryRetryPolicy RetryPolicy() const noexcept;
+    void RetryPolicy(const SystemLibraryRetryPolicy policy) noexcept;
+    // Lets the libraries and symbols which failed before be tried again (once),
+    // according to the retry policy. Cheap, nothing is reloaded right away.
+    void Rescan() noexcept;
+
+    // Null means the backend of the current platform. Switching the backend is only
+    // possible when no library has been loaded yet, call "Release()" first if needed.
+    [[nodiscard]] SystemLibraryBackend *Backend() const noexcept;
+    void Backend(SystemLibraryBackend *backend) noexcept;
+
 private:
     explicit SystemLibraryManager() noexcept;
     ~SystemLibraryManager() noexcept;
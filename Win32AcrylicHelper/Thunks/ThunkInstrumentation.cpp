@@ -0,0 +1,207 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "ThunkInstrumentation.h"
+#include "TimingService.h"
+#include "Utils.h"
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstdlib>
+#include <new>
+#include <utility>
+
+namespace ThunkInstrumentation
+{
+
+struct ThreadCounters
+{
+    std::array<std::atomic<std::uint64_t>, MaximumSymbolCount> Calls = {};
+    std::array<std::array<std::atomic<std::uint64_t>, HistogramBucketCount>, MaximumSymbolCount> Histogram = {};
+    ThreadCounters *Next = nullptr;
+};
+
+static std::atomic<std::size_t> g_symbolCount = 0;
+static std::array<const wchar_t *, MaximumSymbolCount> g_libraryNames = {};
+static std::array<const wchar_t *, MaximumSymbolCount> g_symbolNames = {};
+static std::array<std::atomic<bool>, MaximumSymbolCount> g_published = {};
+static std::array<std::atomic<std::uint64_t>, MaximumSymbolCount> g_resolutionNanoseconds = {};
+// All per-thread counter blocks ever created. They are never freed so that the
+// statistics of finished threads are still part of the final snapshot.
+static std::atomic<ThreadCounters *> g_threadCounters = nullptr;
+static thread_local ThreadCounters *t_threadCounters = nullptr;
+
+[[nodiscard]] static inline ThreadCounters *GetThreadCounters() noexcept
+{
+    if (t_threadCounters) {
+        return t_threadCounters;
+    }
+    const auto counters = new (std::nothrow) ThreadCounters;
+    if (!counters) {
+        return nullptr;
+    }
+    ThreadCounters *head = g_threadCounters.load(std::memory_order_relaxed);
+    do {
+        counters->Next = head;
+    } while (!g_threadCounters.compare_exchange_weak(head, counters, std::memory_order_release, std::memory_order_relaxed));
+    t_threadCounters = counters;
+    return counters;
+}
+
+// Only the owning thread writes its own counters, so a plain load/store pair is
+// enough and we can avoid the locked read-modify-write instructions.
+static inline void Increment(std::atomic<std::uint64_t> &counter) noexcept
+{
+    counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+[[nodiscard]] static inline std::size_t BucketFromNanoseconds(const std::uint64_t nanoseconds) noexcept
+{
+    const auto width = static_cast<std::size_t>(std::bit_width(nanoseconds));
+    return ((width == 0) ? 0 : std::min(width - 1, HistogramBucketCount - 1));
+}
+
+std::size_t Register(const wchar_t *library, const wchar_t *symbol) noexcept
+{
+    static const bool dumpRegistered = (std::atexit(Dump) == 0);
+    UNREFERENCED_PARAMETER(dumpRegistered);
+    const std::size_t id = g_symbolCount.fetch_add(1, std::memory_order_relaxed);
+    if (id >= MaximumSymbolCount) {
+        OutputDebugStringW(L"Too many thunks to instrument, please increase ThunkInstrumentation::MaximumSymbolCount.\n");
+        return InvalidSymbolId;
+    }
+    g_libraryNames[id] = library;
+    g_symbolNames[id] = symbol;
+    g_published[id].store(true, std::memory_order_release);
+    return id;
+}
+
+void RecordResolution(const std::size_t id, const std::uint64_t nanoseconds) noexcept
+{
+    if (id >= MaximumSymbolCount) {
+        return;
+    }
+    g_resolutionNanoseconds[id].store(nanoseconds, std::memory_order_relaxed);
+}
+
+void RecordCall(const std::size_t id, const std::uint64_t nanoseconds) noexcept
+{
+    if (id >= MaximumSymbolCount) {
+        return;
+    }
+    const auto counters = GetThreadCounters();
+    if (!counters) {
+        return;
+    }
+    Increment(counters->Calls[id]);
+    Increment(counters->Histogram[id][BucketFromNanoseconds(nanoseconds)]);
+}
+
+std::vector<SymbolStatistics> Snapshot() noexcept
+{
+    const std::size_t count = std::min(g_symbolCount.load(std::memory_order_relaxed), MaximumSymbolCount);
+    std::vector<SymbolStatistics> statistics = {};
+    statistics.reserve(count);
+    const ThreadCounters *head = g_threadCounters.load(std::memory_order_acquire);
+    for (std::size_t id = 0; id != count; ++id) {
+        if (!g_published[id].load(std::memory_order_acquire)) {
+            continue;
+        }
+        SymbolStatistics item = {};
+        item.Library = g_libraryNames[id];
+        item.Symbol = g_symbolNames[id];
+        item.ResolutionNanoseconds = g_resolutionNanoseconds[id].load(std::memory_order_relaxed);
+        for (auto counters = head; counters; counters = counters->Next) {
+            item.CallCount += counters->Calls[id].load(std::memory_order_relaxed);
+            for (std::size_t bucket = 0; bucket != HistogramBucketCount; ++bucket) {
+                item.Histogram[bucket] += counters->Histogram[id][bucket].load(std::memory_order_relaxed);
+            }
+        }
+        statistics.push_back(std::move(item));
+    }
+    return statistics;
+}
+
+std::wstring ToCSV(const std::vector<SymbolStatistics> &statistics) noexcept
+{
+    std::wstring result = L"library,symbol,calls,resolution_ns";
+    for (std::size_t bucket = 0; bucket != HistogramBucketCount; ++bucket) {
+        result += L",lt_" + std::to_wstring(std::uint64_t(2) << bucket) + L"ns";
+    }
+    result += L'\n';
+    for (auto &&item : std::as_const(statistics)) {
+        result += item.Library + L',' + item.Symbol + L',' + std::to_wstring(item.CallCount) + L',' + std::to_wstring(item.ResolutionNanoseconds);
+        for (auto &&count : std::as_const(item.Histogram)) {
+            result += L',' + std::to_wstring(count);
+        }
+        result += L'\n';
+    }
+    return result;
+}
+
+std::wstring ToJSON(const std::vector<SymbolStatistics> &statistics) noexcept
+{
+    std::wstring result = L"[\n";
+    bool first = true;
+    for (auto &&item : std::as_const(statistics)) {
+        if (!first) {
+            result += L",\n";
+        }
+        first = false;
+        result += L"  {\"library\": \"" + Utils::EscapeJSONString(item.Library) + L"\", \"symbol\": \"" + Utils::EscapeJSONString(item.Symbol)
+                + L"\", \"calls\": " + std::to_wstring(item.CallCount) + L", \"resolution_ns\": " + std::to_wstring(item.ResolutionNanoseconds)
+                + L", \"histogram\": [";
+        for (std::size_t bucket = 0; bucket != HistogramBucketCount; ++bucket) {
+            if (bucket != 0) {
+                result += L", ";
+            }
+            result += std::to_wstring(item.Histogram[bucket]);
+        }
+        result += L"]}";
+    }
+    result += L"\n]\n";
+    return result;
+}
+
+void Dump() noexcept
+{
+    const std::vector<SymbolStatistics> statistics = Snapshot();
+    Utils::WriteReport(L"WIN32ACRYLICHELPER_THUNK_STATISTICS", [&statistics](const ReportFormat format) -> std::wstring {
+        return ((format == ReportFormat::CSV) ? ToCSV(statistics) : ToJSON(statistics));
+    });
+}
+
+std::uint64_t Now() noexcept
+{
+    LARGE_INTEGER counter = {};
+    QueryPerformanceCounter(&counter);
+    return static_cast<std::uint64_t>(counter.QuadPart);
+}
+
+std::uint64_t ElapsedNanoseconds(const std::uint64_t since) noexcept
+{
+    return TimingService::TicksToNanoseconds(Now() - since);
+}
+
+} // namespace ThunkInstrumentation
@@ -0,0 +1,95 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <SDKDDKVer.h>
+#include <Windows.h>
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Optional call statistics of the Windows API thunks. Only compiled in when
+// "WIN32ACRYLICHELPER_THUNK_INSTRUMENTATION" is defined, see "WindowsAPIThunks.h".
+namespace ThunkInstrumentation
+{
+    // Bucket N counts the calls which took [2^N, 2^(N+1)) nanoseconds.
+    [[maybe_unused]] constexpr const std::size_t HistogramBucketCount = 32;
+    [[maybe_unused]] constexpr const std::size_t MaximumSymbolCount = 256;
+    [[maybe_unused]] constexpr const std::size_t InvalidSymbolId = MaximumSymbolCount;
+
+    struct SymbolStatistics
+    {
+        std::wstring Library = {};
+        std::wstring Symbol = {};
+        std::uint64_t CallCount = 0;
+        std::uint64_t ResolutionNanoseconds = 0;
+        std::array<std::uint64_t, HistogramBucketCount> Histogram = {};
+    };
+
+    [[nodiscard]] std::size_t Register(const wchar_t *library, const wchar_t *symbol) noexcept;
+    void RecordResolution(const std::size_t id, const std::uint64_t nanoseconds) noexcept;
+    void RecordCall(const std::size_t id, const std::uint64_t nanoseconds) noexcept;
+
+    [[nodiscard]] std::vector<SymbolStatistics> Snapshot() noexcept;
+    [[nodiscard]] std::wstring ToCSV(const std::vector<SymbolStatistics> &statistics) noexcept;
+    [[nodiscard]] std::wstring ToJSON(const std::vector<SymbolStatistics> &statistics) noexcept;
+
+    // Writes the snapshot to the file named by the "WIN32ACRYLICHELPER_THUNK_STATISTICS"
+    // environment variable (CSV if it ends with ".csv", JSON otherwise), or to the
+    // debugger output if the variable is not set. Called automatically at exit.
+    void Dump() noexcept;
+
+    [[nodiscard]] std::uint64_t Now() noexcept;
+    [[nodiscard]] std::uint64_t ElapsedNanoseconds(const std::uint64_t since) noexcept;
+
+    template<typename Function>
+    [[nodiscard]] inline auto TimedResolve(const std::size_t id, const Function &resolve) noexcept
+    {
+        const std::uint64_t start = Now();
+        const auto address = resolve();
+        RecordResolution(id, ElapsedNanoseconds(start));
+        return address;
+    }
+
+    class CallTimer
+    {
+    public:
+        inline explicit CallTimer(const std::size_t id) noexcept : m_id(id), m_start(Now()) {}
+        inline ~CallTimer() noexcept {
+            RecordCall(m_id, ElapsedNanoseconds(m_start));
+        }
+
+    private:
+        CallTimer(const CallTimer &) = delete;
+        CallTimer &operator=(const CallTimer &) = delete;
+        CallTimer(CallTimer &&) = delete;
+        CallTimer &operator=(CallTimer &&) = delete;
+
+    private:
+        std::size_t m_id = InvalidSymbolId;
+        std::uint64_t m_start = 0;
+    };
+} // namespace ThunkInstrumentation
@@ -33,20 +33,40 @@
 #define __RESOLVE_UNDOC_API(library, symbol, ordinal) static const auto symbol ## _API = __RESOLVE_UNDOC_API_INTERNAL( library , symbol , ordinal )
 #endif // __RESOLVE_UNDOC_API
 
+#ifndef __LOAD_UNDOC_API
+#define __LOAD_UNDOC_API(library, ordinal) \
+[](){ \
+    const HMODULE dll = LoadLibraryExW(L#library , nullptr, LOAD_LIBRARY_SEARCH_SYSTEM32); \
+    return ( dll ? reinterpret_cast<sig>(GetProcAddress(dll, MAKEINTRESOURCEA( ordinal ))) : nullptr ); \
+}
+#endif // __LOAD_UNDOC_API
+
 #ifndef __THUNK_UNDOC_API
+#ifdef WIN32ACRYLICHELPER_THUNK_INSTRUMENTATION
+#define __THUNK_UNDOC_API(library, symbol, ordinal, result_type, default_result, argument_signature, argument_list) \
+EXTERN_C result_type WINAPI \
+symbol \
+argument_signature \
+{ \
+    using sig = decltype (& :: symbol); \
+    static const std::size_t symbol ## _ID = ThunkInstrumentation::Register( L#library , L#symbol ); \
+    static const sig symbol ## _API = ThunkInstrumentation::TimedResolve( symbol ## _ID , __LOAD_UNDOC_API( library , ordinal ) ); \
+    const ThunkInstrumentation::CallTimer symbol ## _TIMER( symbol ## _ID ); \
+    return ( ( symbol ## _API ) ? ( symbol ## _API argument_list ) : ( default_result ) ); \
+} \
+_LCRT_DEFINE_IAT_SYMBOL( symbol , 0 );
+#else // WIN32ACRYLICHELPER_THUNK_INSTRUMENTATION
 #define __THUNK_UNDOC_API(library, symbol, ordinal, result_type, default_result, argument_signature, argument_list) \
 EXTERN_C result_type WINAPI \
 symbol \
 argument_signature \
 { \
     using sig = decltype (& :: symbol); \
-    static const sig symbol ## _API = [](){ \
-        const HMODULE dll = LoadLibraryExW(L#library , nullptr, LOAD_LIBRARY_SEARCH_SYSTEM32); \
-        return ( dll ? reinterpret_cast<sig>(GetProcAddress(dll, MAKEINTRESOURCEA( ordinal ))) : nullptr ); \
-    }(); \
+    static const sig symbol ## _API = __LOAD_UNDOC_API( library , ordinal )(); \
     return ( ( symbol ## _API ) ? ( symbol ## _API argument_list ) : ( default_result ) ); \
 } \
 _LCRT_DEFINE_IAT_SYMBOL( symbol , 0 );
+#endif // WIN32ACRYLICHELPER_THUNK_INSTRUMENTATION
 #endif // __THUNK_UNDOC_API
 
 #ifndef __USER32_DLL_FILENAME
@@ -86,6 +86,9 @@ __THUNK_API(__USER32_DLL_FILENAME, GetMessagePos, DWORD, DEFAULT_UINT, (VOID), (
 __THUNK_API(__USER32_DLL_FILENAME, SetLayeredWindowAttributes, BOOL, DEFAULT_BOOL, (HWND arg1, COLORREF arg2, BYTE arg3, DWORD arg4), (arg1, arg2, arg3, arg4))
 __THUNK_API(__USER32_DLL_FILENAME, MessageBoxW, int, DEFAULT_INT, (HWND arg1, LPCWSTR arg2, LPCWSTR arg3, UINT arg4), (arg1, arg2, arg3, arg4))
 __THUNK_API(__USER32_DLL_FILENAME, FindWindowW, HWND, DEFAULT_PTR, (LPCWSTR arg1, LPCWSTR arg2), (arg1, arg2))
+__THUNK_API(__USER32_DLL_FILENAME, RegisterWindowMessageW, UINT, DEFAULT_UINT, (LPCWSTR arg1), (arg1))
+__THUNK_API(__USER32_DLL_FILENAME, SetTimer, UINT_PTR, DEFAULT_UINT, (HWND arg1, UINT_PTR arg2, UINT arg3, TIMERPROC arg4), (arg1, arg2, arg3, arg4))
+__THUNK_API(__USER32_DLL_FILENAME, KillTimer, BOOL, DEFAULT_BOOL, (HWND arg1, UINT_PTR arg2), (arg1, arg2))
 __THUNK_API(__USER32_DLL_FILENAME, GetSystemMetrics, int, DEFAULT_INT, (int arg1), (arg1))
 __THUNK_API(__USER32_DLL_FILENAME, AttachThreadInput, BOOL, DEFAULT_BOOL, (DWORD arg1, DWORD arg2, BOOL arg3), (arg1, arg2, arg3))
 __THUNK_API(__USER32_DLL_FILENAME, GetForegroundWindow, HWND, DEFAULT_PTR, (VOID), ())
@@ -100,3 +103,9 @@ __THUNK_API(__USER32_DLL_FILENAME, SystemParametersInfoForDpi, BOOL, DEFAULT_BOO
 __THUNK_API(__USER32_DLL_FILENAME, AdjustWindowRectExForDpi, BOOL, DEFAULT_BOOL, (LPRECT arg1, DWORD arg2, BOOL arg3, DWORD arg4, UINT arg5), (arg1, arg2, arg3, arg4, arg5))
 __THUNK_API(__USER32_DLL_FILENAME, IsProcessDPIAware, BOOL, DEFAULT_BOOL, (VOID), ())
 __THUNK_API(__USER32_DLL_FILENAME, SetProcessDPIAware, BOOL, DEFAULT_BOOL, (VOID), ())
+__THUNK_API(__USER32_DLL_FILENAME, GetAncestor, HWND, DEFAULT_PTR, (HWND arg1, UINT arg2), (arg1, arg2))
+__THUNK_API(__USER32_DLL_FILENAME, PeekMessageW, BOOL, DEFAULT_BOOL, (LPMSG arg1, HWND arg2, UINT arg3, UINT arg4, UINT arg5), (arg1, arg2, arg3, arg4, arg5))
+__THUNK_API(__USER32_DLL_FILENAME, MsgWaitForMultipleObjectsEx, DWORD, WAIT_FAILED, (DWORD arg1, CONST HANDLE *arg2, DWORD arg3, DWORD arg4, DWORD arg5), (arg1, arg2, arg3, arg4, arg5))
+__THUNK_API(__USER32_DLL_FILENAME, GetClassLongPtrW, ULONG_PTR, DEFAULT_INT, (HWND arg1, int arg2), (arg1, arg2))
+__THUNK_API(__USER32_DLL_FILENAME, EnumChildWindows, BOOL, DEFAULT_BOOL, (HWND arg1, WNDENUMPROC arg2, LPARAM arg3), (arg1, arg2, arg3))
+__THUNK_API(__USER32_DLL_FILENAME, GetClassInfoExW, BOOL, DEFAULT_BOOL, (HINSTANCE arg1, LPCWSTR arg2, LPWNDCLASSEXW arg3), (arg1, arg2, arg3))
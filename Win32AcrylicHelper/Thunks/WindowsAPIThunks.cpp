@@ -38,3 +38,11 @@ GetWindowsAPIByName(
     }
     return SystemLibraryManager::instance().GetSymbol(library, symbol);
 }
+
+EXTERN_C ULONGLONG WINAPI
+GetWindowsAPIGeneration(
+    VOID
+) noexcept
+{
+    return SystemLibrary::Generation();
+}
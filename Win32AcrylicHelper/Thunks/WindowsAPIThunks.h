@@ -24,8 +24,29 @@
 
 #pragma once
 
+#ifdef _WIN32
 #include <SDKDDKVer.h>
 #include <Windows.h>
+#else // _WIN32
+// Only the cache below is available on POSIX, keep the Win32 spellings it uses.
+#include "SystemLibraryBackend.h"
+using LPCWSTR = const wchar_t *;
+using ULONGLONG = unsigned long long;
+#ifndef EXTERN_C
+#define EXTERN_C extern "C"
+#endif // EXTERN_C
+#ifndef WINAPI
+#define WINAPI
+#endif // WINAPI
+#ifndef VOID
+#define VOID void
+#endif // VOID
+#ifndef _In_
+#define _In_
+#endif // _In_
+#endif // _WIN32
+
+#include <atomic>
 
 #ifndef DEFAULT_INT
 #define DEFAULT_INT (-1)
@@ -51,6 +72,7 @@
 #define DEFAULT_HRESULT (E_NOTIMPL)
 #endif // DEFAULT_HRESULT
 
+#ifdef _WIN32
 #ifndef _LCRT_DEFINE_IAT_SYMBOL_MAKE_NAME
 #ifdef _M_IX86
 #define _LCRT_DEFINE_IAT_SYMBOL_MAKE_NAME(function, size) _CRT_CONCATENATE( _CRT_CONCATENATE( _imp__ , function ), _CRT_CONCATENATE( _ , size ) )
@@ -72,16 +94,103 @@ EXTERN_C __declspec(selectany) void const * const __identifier( _CRT_STRINGIZE_(
 EXTERN_C __declspec(selectany) void const * const _LCRT_DEFINE_IAT_SYMBOL_MAKE_NAME( function, size ) = reinterpret_cast< void const * >( function )
 #endif // _M_IX86
 #endif // _LCRT_DEFINE_IAT_SYMBOL
+#endif // _WIN32
+
+EXTERN_C FARPROC WINAPI
+GetWindowsAPIByName(
+    _In_ LPCWSTR library,
+    _In_ LPCWSTR symbol
+) noexcept;
+
+EXTERN_C ULONGLONG WINAPI
+GetWindowsAPIGeneration(
+    VOID
+) noexcept;
+
+// The resolved address of a thunk. A null address is retried once per system library
+// generation (see "SystemLibraryManager::Rescan()"), until then it costs a single
+// atomic load and comparison.
+template<typename Function>
+class WindowsAPICache
+{
+public:
+    explicit WindowsAPICache(const LPCWSTR library, const LPCWSTR symbol) noexcept : m_library(library), m_symbol(symbol)
+    {
+        [[maybe_unused]] const Function address = Resolve();
+    }
+
+    ~WindowsAPICache() noexcept = default;
+
+    [[nodiscard]] Function Get() noexcept
+    {
+        const Function address = m_address.load(std::memory_order_acquire);
+        if (address) {
+            return address;
+        }
+        if (m_generation.load(std::memory_order_relaxed) == GetWindowsAPIGeneration()) {
+            return nullptr;
+        }
+        return Resolve();
+    }
+
+private:
+    WindowsAPICache(const WindowsAPICache &) = delete;
+    WindowsAPICache &operator=(const WindowsAPICache &) = delete;
+    WindowsAPICache(WindowsAPICache &&) = delete;
+    WindowsAPICache &operator=(WindowsAPICache &&) = delete;
+
+private:
+    [[nodiscard]] Function Resolve() noexcept
+    {
+        // Read it before resolving, a rescan in the meantime must not be missed.
+        m_generation.store(GetWindowsAPIGeneration(), std::memory_order_relaxed);
+        const auto address = reinterpret_cast<Function>(GetWindowsAPIByName(m_library, m_symbol));
+        if (address) {
+            m_address.store(address, std::memory_order_release);
+        }
+        return address;
+    }
+
+private:
+    LPCWSTR m_library = nullptr;
+    LPCWSTR m_symbol = nullptr;
+    std::atomic<Function> m_address = nullptr;
+    std::atomic<ULONGLONG> m_generation = 0;
+};
 
+#ifdef _WIN32
 #ifndef __RESOLVE_API_INTERNAL
 #define __RESOLVE_API_INTERNAL(library, symbol) ( reinterpret_cast< decltype( & ::symbol ) >( GetWindowsAPIByName( L#library , L#symbol ) ) )
 #endif // __RESOLVE_API_INTERNAL
 
 #ifndef __RESOLVE_API
-#define __RESOLVE_API(library, symbol) static const auto symbol ## _API = __RESOLVE_API_INTERNAL( library , symbol )
+#define __RESOLVE_API(library, symbol) \
+static WindowsAPICache< decltype( & ::symbol ) > symbol ## _CACHE( L#library , L#symbol ); \
+const auto symbol ## _API = symbol ## _CACHE.Get()
 #endif // __RESOLVE_API
 
+#ifdef WIN32ACRYLICHELPER_THUNK_INSTRUMENTATION
+#include "ThunkInstrumentation.h"
+#endif // WIN32ACRYLICHELPER_THUNK_INSTRUMENTATION
+
 #ifndef __THUNK_API
+#ifdef WIN32ACRYLICHELPER_THUNK_INSTRUMENTATION
+#define __THUNK_API(library, symbol, result_type, default_result, argument_signature, argument_list) \
+EXTERN_C result_type WINAPI \
+symbol \
+argument_signature \
+{ \
+    static const std::size_t symbol ## _ID = ThunkInstrumentation::Register( L#library , L#symbol ); \
+    static const std::uint64_t symbol ## _RESOLUTION_START = ThunkInstrumentation::Now(); \
+    static WindowsAPICache< decltype( & ::symbol ) > symbol ## _CACHE( L#library , L#symbol ); \
+    static const bool symbol ## _RESOLUTION_RECORDED = ( ThunkInstrumentation::RecordResolution( symbol ## _ID , ThunkInstrumentation::ElapsedNanoseconds( symbol ## _RESOLUTION_START ) ), true ); \
+    UNREFERENCED_PARAMETER( symbol ## _RESOLUTION_RECORDED ); \
+    const auto symbol ## _API = symbol ## _CACHE.Get(); \
+    const ThunkInstrumentation::CallTimer symbol ## _TIMER( symbol ## _ID ); \
+    return ( ( symbol ## _API ) ? ( symbol ## _API argument_list ) : ( default_result ) ); \
+} \
+_LCRT_DEFINE_IAT_SYMBOL( symbol , 0 );
+#else // WIN32ACRYLICHELPER_THUNK_INSTRUMENTATION
 #define __THUNK_API(library, symbol, result_type, default_result, argument_signature, argument_list) \
 EXTERN_C result_type WINAPI \
 symbol \
@@ -91,10 +200,6 @@ argument_signature \
     return ( ( symbol ## _API ) ? ( symbol ## _API argument_list ) : ( default_result ) ); \
 } \
 _LCRT_DEFINE_IAT_SYMBOL( symbol , 0 );
+#endif // WIN32ACRYLICHELPER_THUNK_INSTRUMENTATION
 #endif // __THUNK_API
-
-EXTERN_C FARPROC WINAPI
-GetWindowsAPIByName(
-    _In_ LPCWSTR library,
-    _In_ LPCWSTR symbol
-) noexcept;
+#endif // _WIN32
@@ -0,0 +1,121 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "TimingService.h"
+#include "Utils.h"
+#include <TimeApi.h>
+#include <mutex>
+
+struct TimingCaps
+{
+    UINT MinimumTimerPeriod = 0;
+};
+
+[[nodiscard]] static inline const TimingCaps &GetTimingCaps() noexcept
+{
+    static const TimingCaps caps = [](){
+        TimingCaps result = {};
+        TIMECAPS tc = {};
+        if (timeGetDevCaps(&tc, sizeof(tc)) != MMSYSERR_NOERROR) {
+            Utils::DisplayErrorDialog(L"timeGetDevCaps() failed.");
+        } else {
+            result.MinimumTimerPeriod = tc.wPeriodMin;
+        }
+        return result;
+    }();
+    return caps;
+}
+
+static std::mutex g_highResolutionMutex;
+static int g_highResolutionCount = 0;
+
+LONGLONG TimingService::PerformanceFrequency() noexcept
+{
+    // Not part of "GetTimingCaps()": the thunk statistics time every thunk with it,
+    // so it must not call any thunk itself, not even to report an error.
+    static const LONGLONG frequency = [](){
+        LARGE_INTEGER freq = {};
+        if ((QueryPerformanceFrequency(&freq) == FALSE) || (freq.QuadPart <= 0)) {
+            OutputDebugStringW(L"Failed to retrieve the performance counter frequency.\n");
+            return LONGLONG(0);
+        }
+        return freq.QuadPart;
+    }();
+    return frequency;
+}
+
+std::uint64_t TimingService::TicksToNanoseconds(const std::uint64_t ticks) noexcept
+{
+    const auto frequency = static_cast<std::uint64_t>(PerformanceFrequency());
+    if (frequency == 0) {
+        return 0;
+    }
+    // Split the conversion to avoid overflowing for long durations.
+    return (((ticks / frequency) * 1000000000) + (((ticks % frequency) * 1000000000) / frequency));
+}
+
+UINT TimingService::MinimumTimerPeriod() noexcept
+{
+    return GetTimingCaps().MinimumTimerPeriod;
+}
+
+bool TimingService::BeginHighResolution() noexcept
+{
+    const UINT period = MinimumTimerPeriod();
+    if (period == 0) {
+        return false;
+    }
+    const std::scoped_lock lock(g_highResolutionMutex);
+    if (g_highResolutionCount == 0) {
+        if (timeBeginPeriod(period) != TIMERR_NOERROR) {
+            Utils::DisplayErrorDialog(L"timeBeginPeriod() failed.");
+            return false;
+        }
+    }
+    ++g_highResolutionCount;
+    return true;
+}
+
+bool TimingService::EndHighResolution() noexcept
+{
+    const std::scoped_lock lock(g_highResolutionMutex);
+    if (g_highResolutionCount <= 0) {
+        Utils::DisplayErrorDialog(L"TimingService::EndHighResolution() is called without a matching TimingService::BeginHighResolution().");
+        return false;
+    }
+    --g_highResolutionCount;
+    if (g_highResolutionCount == 0) {
+        if (timeEndPeriod(MinimumTimerPeriod()) != TIMERR_NOERROR) {
+            Utils::DisplayErrorDialog(L"timeEndPeriod() failed.");
+            return false;
+        }
+    }
+    return true;
+}
+
+bool TimingService::IsHighResolution() noexcept
+{
+    const std::scoped_lock lock(g_highResolutionMutex);
+    return (g_highResolutionCount > 0);
+}
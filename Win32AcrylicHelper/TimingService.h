@@ -0,0 +1,50 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <SDKDDKVer.h>
+#include <Windows.h>
+#include <cstdint>
+
+// Process wide timing state. The values which can't change while the process is
+// running are queried only once, and the system wide timer resolution is shared
+// by reference counting instead of being raised and lowered around every wait.
+namespace TimingService
+{
+    // Performance counter ticks per second.
+    [[nodiscard]] LONGLONG PerformanceFrequency() noexcept;
+    // Performance counter ticks to nanoseconds, without overflowing for long durations.
+    // Zero if the frequency is unknown.
+    [[nodiscard]] std::uint64_t TicksToNanoseconds(const std::uint64_t ticks) noexcept;
+    // The finest timer resolution the system supports, in milliseconds.
+    [[nodiscard]] UINT MinimumTimerPeriod() noexcept;
+
+    // Raise the system timer resolution to "MinimumTimerPeriod()" until the
+    // matching "EndHighResolution()". Meant to bracket short bursts of timing
+    // sensitive work, such as an interactive resize.
+    [[nodiscard]] bool BeginHighResolution() noexcept;
+    [[nodiscard]] bool EndHighResolution() noexcept;
+    [[nodiscard]] bool IsHighResolution() noexcept;
+} // namespace TimingService
@@ -29,13 +29,14 @@
 #include "OperationResult.h"
 #include "WindowsVersion.h"
 #include "Undocumented.h"
+#include "Profiler.h"
+#include <cwctype>
+#include <utility>
 
-void Utils::DisplayErrorDialog(const std::wstring &text) noexcept
+void Utils::DisplayErrorDialog(const std::wstring &text, const ErrorSeverity severity) noexcept
 {
     if (!text.empty()) {
-        const std::wstring textWithNewLine = text + L'\n';
-        OutputDebugStringW(textWithNewLine.c_str());
-        MessageBoxW(nullptr, text.c_str(), L"Error", MB_ICONERROR | MB_OK);
+        ErrorSink::Current().Report(severity, text);
     }
 }
 
@@ -98,6 +99,7 @@ ProcessDPIAwareness Utils::GetProcessDPIAwareness() noexcept
 
 bool Utils::SetProcessDPIAwareness(const ProcessDPIAwareness dpiAwareness) noexcept
 {
+    PROFILE_SCOPE(L"Utils::SetProcessDPIAwareness")
     const VersionNumber &curOsVer = WindowsVersion::CurrentVersion();
     if (curOsVer >= WindowsVersion::Windows10_1607) {
         DPI_AWARENESS_CONTEXT dac = DPI_AWARENESS_CONTEXT_UNAWARE;
@@ -220,3 +222,60 @@ bool Utils::LoadResourceData(const std::wstring &name, const std::wstring &type,
     *dataSize = resourceDataSize;
     return true;
 }
+
+std::string Utils::UTF16ToUTF8(const std::wstring &text) noexcept
+{
+    if (text.empty()) {
+        return {};
+    }
+    const auto originalString = &text[0];
+    const auto originalLength = static_cast<int>(text.size());
+    const int newLength = WideCharToMultiByte(CP_UTF8, 0, originalString, originalLength, nullptr, 0, nullptr, nullptr);
+    if (newLength <= 0) {
+        return {};
+    }
+    std::string result(newLength, '\0');
+    WideCharToMultiByte(CP_UTF8, 0, originalString, originalLength, &result[0], newLength, nullptr, nullptr);
+    return result;
+}
+
+std::wstring Utils::EscapeJSONString(const std::wstring &text) noexcept
+{
+    std::wstring result = {};
+    result.reserve(text.size());
+    for (auto &&ch : std::as_const(text)) {
+        if ((ch == L'"') || (ch == L'\\')) {
+            result += L'\\';
+        }
+        result += ch;
+    }
+    return result;
+}
+
+void Utils::WriteReport(const std::wstring &variable, const std::function<std::wstring(const ReportFormat)> &format) noexcept
+{
+    if (variable.empty() || !format) {
+        return;
+    }
+    wchar_t path[MAX_PATH] = { L'\0' };
+    const DWORD length = GetEnvironmentVariableW(variable.c_str(), path, MAX_PATH);
+    if ((length == 0) || (length >= MAX_PATH)) {
+        OutputDebugStringW(format(ReportFormat::CSV).c_str());
+        return;
+    }
+    std::wstring extension = ((length >= 4) ? std::wstring(path + length - 4) : std::wstring{});
+    for (auto &&ch : extension) {
+        ch = static_cast<wchar_t>(std::towlower(ch));
+    }
+    const std::string content = UTF16ToUTF8(format((extension == L".csv") ? ReportFormat::CSV : ReportFormat::JSON));
+    const HANDLE file = CreateFileW(path, GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        OutputDebugStringW((std::wstring(L"Failed to create \"") + path + std::wstring(L"\".\n")).c_str());
+        return;
+    }
+    DWORD written = 0;
+    if (WriteFile(file, content.data(), static_cast<DWORD>(content.size()), &written, nullptr) == FALSE) {
+        OutputDebugStringW((std::wstring(L"Failed to write \"") + path + std::wstring(L"\".\n")).c_str());
+    }
+    CloseHandle(file);
+}
@@ -25,13 +25,24 @@
 #pragma once
 
 #include "Definitions.h"
+#include "ErrorSink.h"
+#include <functional>
 #include <string>
 
 namespace Utils
 {
-    void DisplayErrorDialog(const std::wstring &text) noexcept;
+    // Despite the name, only fatal errors show a dialog, see "ErrorSink::Default()".
+    void DisplayErrorDialog(const std::wstring &text, const ErrorSeverity severity = ErrorSeverity::Error) noexcept;
     [[nodiscard]] ProcessDPIAwareness GetProcessDPIAwareness() noexcept;
     [[nodiscard]] bool SetProcessDPIAwareness(const ProcessDPIAwareness dpiAwareness) noexcept;
     [[nodiscard]] std::wstring DPIAwarenessToString(const ProcessDPIAwareness value) noexcept;
     [[nodiscard]] bool LoadResourceData(const std::wstring &name, const std::wstring &type, void **data, LPDWORD dataSize) noexcept;
+    [[nodiscard]] std::string UTF16ToUTF8(const std::wstring &text) noexcept;
+    // Only the quotes and the backslashes, enough for the names we write out.
+    [[nodiscard]] std::wstring EscapeJSONString(const std::wstring &text) noexcept;
+    // Writes the report as UTF-8 to the file named by the environment variable, as CSV
+    // if the file name ends with ".csv" and as JSON otherwise. Without the variable the
+    // CSV goes to the debugger. Uses nothing but Kernel32, so it works at exit and
+    // from within the thunks.
+    void WriteReport(const std::wstring &variable, const std::function<std::wstring(const ReportFormat)> &format) noexcept;
 } // namespace Utils
@@ -28,59 +28,41 @@
 #include "Utils.h"
 #include "Resource.h"
 #include "Undocumented.h"
+#include "HitTestMap.hpp"
+#include "WindowFrameGeometry.hpp"
+#include "FrameScheduler.h"
+#include "TimingService.h"
+#include "TaskBarCache.h"
+#include "PersonalizationSettings.h"
+#include "ThemeChangeCoalescer.h"
+#include "MessageDispatcher.h"
+#include "HandleMap.hpp"
+#include "EventLoop.h"
+#include "MessageTrace.h"
+#include "MessageInstrumentation.h"
+#include "Profiler.h"
+#include "WindowClassRegistry.h"
 #include <ComBaseApi.h>
 #include <ShellApi.h>
 #include <ShellScalingApi.h>
 #include <DwmApi.h>
-#include <TimeApi.h>
 #include <cmath>
-#include <cassert>
+#include <array>
+#include <algorithm>
+#include <atomic>
+#include <utility>
+#include <vector>
 
-#ifndef ABM_GETAUTOHIDEBAREX
-#define ABM_GETAUTOHIDEBAREX (0x0000000b)
-#endif
+static constexpr const std::size_t WindowMetricsCount = (static_cast<std::size_t>(WindowMetrics::WindowSmallIconHeight) + 1);
+// A window dragged back and forth between monitors only ever sees a few DPIs.
+static constexpr const std::size_t WindowMetricsCacheSize = 4;
 
-[[nodiscard]] static inline std::wstring GenerateGUID() noexcept
+// The window metrics for one DPI.
+struct WindowMetricsEntry
 {
-    GUID guid = {};
-    const HRESULT hr = CoCreateGuid(&guid);
-    if (FAILED(hr)) {
-        PRINT_HR_ERROR_MESSAGE(CoCreateGuid, hr, L"Failed to generate a new GUID.")
-        return {};
-    }
-    wchar_t buf[MAX_PATH] = { L'\0' };
-    if (StringFromGUID2(guid, buf, MAX_PATH) == 0) {
-        PRINT_WIN32_ERROR_MESSAGE(StringFromGUID2, L"Failed to convert GUID to string.")
-        return {};
-    }
-    return buf;
-}
-
-[[nodiscard]] static inline DWORD GetDWORDFromRegistry(const HKEY rootKey, const std::wstring &subKey, const std::wstring &keyName) noexcept
-{
-    if (!rootKey || subKey.empty() || keyName.empty()) {
-        Utils::DisplayErrorDialog(L"Can't query the registry due to invalid parameters are passed.");
-        return 0;
-    }
-    HKEY hKey = nullptr;
-    if (RegOpenKeyExW(rootKey, subKey.c_str(), 0, KEY_READ, &hKey) != ERROR_SUCCESS) {
-        PRINT_WIN32_ERROR_MESSAGE(RegOpenKeyExW, L"Failed to open the registry key to read.")
-        return 0;
-    }
-    DWORD dwValue = 0;
-    DWORD dwType = REG_DWORD;
-    DWORD dwSize = sizeof(dwValue);
-    const bool success = (RegQueryValueExW(hKey, keyName.c_str(), nullptr, &dwType, reinterpret_cast<LPBYTE>(&dwValue), &dwSize) == ERROR_SUCCESS);
-    if (!success) {
-        PRINT_WIN32_ERROR_MESSAGE(RegQueryValueExW, L"Failed to query the registry key value.")
-        // Don't return early here because we have to close the opened registry key later.
-    }
-    if (RegCloseKey(hKey) != ERROR_SUCCESS) {
-        PRINT_WIN32_ERROR_MESSAGE(RegCloseKey, L"Failed to close the registry key.")
-        return 0;
-    }
-    return dwValue;
-}
+    UINT Dpi = 0; // Zero means the entry is empty.
+    std::array<UINT, WindowMetricsCount> Values = {};
+};
 
 [[nodiscard]] static inline RECT GetWindowFrameGeometry(const HWND hWnd) noexcept
 {
@@ -95,19 +77,7 @@
     return rect;
 }
 
-[[nodiscard]] static inline bool IsHighContrastModeEnabled() noexcept
-{
-    HIGHCONTRASTW hc;
-    SecureZeroMemory(&hc, sizeof(hc));
-    hc.cbSize = sizeof(hc);
-    if (SystemParametersInfoW(SPI_GETHIGHCONTRAST, sizeof(hc), &hc, 0) == FALSE) {
-        PRINT_WIN32_ERROR_MESSAGE(SystemParametersInfoW, L"Failed to retrieve the high contrast mode state.")
-        return false;
-    }
-    return (hc.dwFlags & HCF_HIGHCONTRASTON);
-}
-
-[[nodiscard]] static inline bool ShouldAppsUseLightTheme() noexcept
+[[nodiscard]] static inline bool ShouldAppsUseLightTheme(const PersonalizationSnapshot &settings) noexcept
 {
     // Dark mode was first introduced in Windows 10 1607.
     // There is no dark theme before that, so we always assume
@@ -115,34 +85,18 @@
     if (WindowsVersion::CurrentVersion() < WindowsVersion::Windows10_1607) {
         return true;
     }
-    return (GetDWORDFromRegistry(HKEY_CURRENT_USER, PersonalizeRegistryKeyPath, L"AppsUseLightTheme") != 0);
+    return settings.AppsUseLightTheme;
 }
 
-[[nodiscard]] static inline DWORD GetGlobalColorizationColor2() noexcept
-{
-    DWORD color = 0; // The color format of the value is 0xAARRGGBB.
-    BOOL opaque = FALSE;
-    const HRESULT hr = DwmGetColorizationColor(&color, &opaque);
-    if (FAILED(hr)) {
-        PRINT_HR_ERROR_MESSAGE(DwmGetColorizationColor, hr, L"Failed to retrieve the colorization color.")
-        return 0;
-    }
-    return color;
-}
-
-[[nodiscard]] static inline WindowColorizationArea GetGlobalColorizationArea2() noexcept
+[[nodiscard]] static inline WindowColorizationArea GetGlobalColorizationArea2(const PersonalizationSnapshot &settings) noexcept
 {
     // It's a Win10 only feature.
     static constexpr const VersionNumber win10 = VersionNumber(10, 0, 0);
     if (WindowsVersion::CurrentVersion() < win10) {
         return WindowColorizationArea::None;
     }
-    const HKEY rootKey = HKEY_CURRENT_USER;
-    const std::wstring keyName = L"ColorPrevalence";
-    const DWORD dwmValue = GetDWORDFromRegistry(rootKey, DwmRegistryKeyPath, keyName);
-    const DWORD themeValue = GetDWORDFromRegistry(rootKey, PersonalizeRegistryKeyPath, keyName);
-    const bool dwm = (dwmValue != 0);
-    const bool theme = (themeValue != 0);
+    const bool dwm = settings.DwmColorPrevalence;
+    const bool theme = settings.ThemeColorPrevalence;
     if (dwm && theme) {
         return WindowColorizationArea::All;
     } else if (dwm) {
@@ -153,11 +107,11 @@
     return WindowColorizationArea::None;
 }
 
-[[nodiscard]] static inline WindowTheme GetGlobalApplicationTheme2() noexcept
+[[nodiscard]] static inline WindowTheme GetGlobalApplicationTheme2(const PersonalizationSnapshot &settings) noexcept
 {
-    if (IsHighContrastModeEnabled()) {
+    if (settings.HighContrast) {
         return WindowTheme::HighContrast;
-    } else if (ShouldAppsUseLightTheme()) {
+    } else if (ShouldAppsUseLightTheme(settings)) {
         return WindowTheme::Light;
     } else {
         return WindowTheme::Dark;
@@ -184,6 +138,9 @@
     return (includeTaskBar ? mi.rcMonitor : mi.rcWork);
 }
 
+// The DWM composition status, shared by all windows: unknown, disabled or enabled.
+static std::atomic<int> g_dwmCompositionState = -1;
+
 [[nodiscard]] static inline bool IsDWMCompositionEnabled() noexcept
 {
     // DWM composition is always enabled and can't be programmatically disabled
@@ -191,12 +148,19 @@
     if (WindowsVersion::CurrentVersion() >= WindowsVersion::Windows_8) {
         return true;
     }
+    // Remembered until the next "WM_DWMCOMPOSITIONCHANGED", it's asked for on
+    // every non-client message otherwise.
+    const int state = g_dwmCompositionState.load(std::memory_order_relaxed);
+    if (state >= 0) {
+        return (state != 0);
+    }
     BOOL enabled = FALSE;
     const HRESULT hr = DwmIsCompositionEnabled(&enabled);
     if (FAILED(hr)) {
         PRINT_HR_ERROR_MESSAGE(DwmIsCompositionEnabled, hr, L"Failed to query the DWM composition status.")
         return false;
     }
+    g_dwmCompositionState.store(((enabled != FALSE) ? 1 : 0), std::memory_order_relaxed);
     return (enabled != FALSE);
 }
 
@@ -283,41 +247,25 @@
 
 [[nodiscard]] static inline HWND CreateWindow2(const DWORD style, const DWORD extendedStyle, const HWND parentWindow, void *extraData, const UINT extraDataSize, const HBRUSH backgroundBrush, const WNDPROC wndProc) noexcept
 {
-    if (!wndProc) {
-        Utils::DisplayErrorDialog(L"Failed to register a window class due to the WindowProc function pointer is null.");
-        return nullptr;
-    }
-    const std::wstring guid = GenerateGUID();
-    if (guid.empty()) {
-        Utils::DisplayErrorDialog(L"Failed to generate a new GUID.");
-        return nullptr;
-    }
-    WNDCLASSEXW wcex;
-    SecureZeroMemory(&wcex, sizeof(wcex));
-    wcex.cbSize = sizeof(wcex);
-    wcex.style = CS_DBLCLKS;
-    wcex.lpfnWndProc = wndProc;
-    wcex.hInstance = HINST_THISCOMPONENT;
-    wcex.lpszClassName = guid.c_str();
-    if (backgroundBrush) {
-        wcex.hbrBackground = backgroundBrush;
-    }
-    wcex.hCursor = LoadCursorW(nullptr, IDC_ARROW);
+    PROFILE_SCOPE(L"CreateWindow2")
+    WindowClassKey key = {};
+    key.WindowProc = wndProc;
+    key.Style = CS_DBLCLKS;
+    key.Background = backgroundBrush;
     if (!(style & WS_CHILD)) {
-        wcex.hIcon = LoadIconW(HINST_THISCOMPONENT, MAKEINTRESOURCEW(IDI_WIN32ACRYLICHELPER_ICON));
-        wcex.hIconSm = LoadIconW(HINST_THISCOMPONENT, MAKEINTRESOURCEW(IDI_WIN32ACRYLICHELPER_SMALL_ICON));
+        // LoadIconW() hands out shared handles, so the key is the same for every window.
+        key.Icon = LoadIconW(HINST_THISCOMPONENT, MAKEINTRESOURCEW(IDI_WIN32ACRYLICHELPER_ICON));
+        key.SmallIcon = LoadIconW(HINST_THISCOMPONENT, MAKEINTRESOURCEW(IDI_WIN32ACRYLICHELPER_SMALL_ICON));
     }
-    if (extraDataSize > 0) {
-        wcex.cbWndExtra = extraDataSize;
-    }
-    const ATOM atom = RegisterClassExW(&wcex);
+    key.WindowExtraBytes = static_cast<int>(extraDataSize);
+    const ATOM atom = WindowClassRegistry::Acquire(key);
     if (atom == INVALID_ATOM) {
-        PRINT_WIN32_ERROR_MESSAGE(RegisterClassExW, L"Failed to register a window class.")
+        Utils::DisplayErrorDialog(L"Failed to acquire a window class.");
         return nullptr;
     }
     const HWND hWnd = CreateWindowExW(
         extendedStyle,       // _In_     DWORD     dwExStyle
-        guid.c_str(),        // _In_opt_ LPCWSTR   lpClassName
+        MAKEINTATOM(atom),   // _In_opt_ LPCWSTR   lpClassName
         nullptr,             // _In_opt_ LPCWSTR   lpWindowName
         style,               // _In_     DWORD     dwStyle
         CW_USEDEFAULT,       // _In_     int       X
@@ -331,29 +279,34 @@
         );
     if (!hWnd) {
         PRINT_WIN32_ERROR_MESSAGE(CreateWindowExW, L"Failed to create a window.")
+        WindowClassRegistry::Release(atom);
         return nullptr;
     }
+    // From now on the window owns the reference, it's dropped when the window is
+    // destroyed, whoever destroys it.
+    WindowClassRegistry::Attach(hWnd, atom);
     return hWnd;
 }
 
+static BOOL CALLBACK DetachWindowClass(const HWND hWnd, const LPARAM lParam) noexcept
+{
+    UNREFERENCED_PARAMETER(lParam);
+    WindowClassRegistry::Detach(hWnd);
+    return TRUE;
+}
+
 [[nodiscard]] static inline bool CloseWindow2(const HWND hWnd) noexcept
 {
     if (!hWnd) {
         return false;
     }
-    wchar_t className[MAX_PATH] = { L'\0' };
-    if (GetClassNameW(hWnd, className, MAX_PATH) <= 0) {
-        PRINT_WIN32_ERROR_MESSAGE(GetClassNameW, L"Failed to retrieve the class name of the window.")
-        return false;
-    }
     if (DestroyWindow(hWnd) == FALSE) {
         PRINT_WIN32_ERROR_MESSAGE(DestroyWindow, L"Failed to destroy the window.")
         return false;
     }
-    if (UnregisterClassW(className, HINST_THISCOMPONENT) == FALSE) {
-        PRINT_WIN32_ERROR_MESSAGE(UnregisterClassW, L"Failed to unregister the window class.")
-        return false;
-    }
+    // The references to the window classes were dropped while the windows still
+    // existed, so the classes couldn't be unregistered yet.
+    WindowClassRegistry::Trim();
     return true;
 }
 
@@ -363,10 +316,11 @@ public:
     explicit WindowPrivate(Window *q, const DWORD flags) noexcept;
     ~WindowPrivate() noexcept;
 
-    template<typename T>
-    [[nodiscard]] static T *GetThisFromHandle(const HWND hWnd) noexcept;
+    [[nodiscard]] static WindowPrivate *FromHandle(const HWND hWnd) noexcept;
 
     [[nodiscard]] static int MessageLoop() noexcept;
+    [[nodiscard]] static int MessageLoop(EventLoop &loop) noexcept;
+    [[nodiscard]] static bool FilterMessage(const MSG *msg) noexcept;
 
     [[nodiscard]] std::wstring Title() const noexcept;
     void Title(const std::wstring &value) const noexcept;
@@ -431,10 +385,30 @@ public:
     void DotsPerInchChangeHandler(const UIntChangeHandlerCallback &cb) noexcept;
     void ColorizationColorChangeHandler(const ColorChangeHandlerCallback &cb) noexcept;
     void ColorizationAreaChangeHandler(const WindowColorizationAreaChangeHandlerCallback &cb) noexcept;
+    void GeometryChangeHandler(const WindowGeometryChangeHandlerCallback &cb) noexcept;
+
+    [[nodiscard]] StrChangeSignal &TitleChanged() noexcept;
+    [[nodiscard]] IntChangeSignal &XChanged() noexcept;
+    [[nodiscard]] IntChangeSignal &YChanged() noexcept;
+    [[nodiscard]] UIntChangeSignal &WidthChanged() noexcept;
+    [[nodiscard]] UIntChangeSignal &HeightChanged() noexcept;
+    [[nodiscard]] WindowStateChangeSignal &VisibilityChanged() noexcept;
+    [[nodiscard]] BoolChangeSignal &ActiveChanged() noexcept;
+    [[nodiscard]] WindowFrameCornerChangeSignal &FrameCornerChanged() noexcept;
+    [[nodiscard]] WindowStartupLocationChangeSignal &StartupLocationChanged() noexcept;
+    [[nodiscard]] ColorChangeSignal &TitleBarBackgroundColorChanged() noexcept;
+    [[nodiscard]] WindowThemeChangeSignal &ThemeChanged() noexcept;
+    [[nodiscard]] UIntChangeSignal &DotsPerInchChanged() noexcept;
+    [[nodiscard]] ColorChangeSignal &ColorizationColorChanged() noexcept;
+    [[nodiscard]] WindowColorizationAreaChangeSignal &ColorizationAreaChanged() noexcept;
+    [[nodiscard]] WindowGeometryChangeSignal &GeometryChanged() noexcept;
 
     [[nodiscard]] bool CustomMessageHandler(const UINT message, const WPARAM wParam, const LPARAM lParam, LRESULT *result) const noexcept;
     void CustomMessageHandler(const WindowMessageHandlerCallback &cb) noexcept;
 
+    [[nodiscard]] std::uint32_t SubscribeMessage(const UINT message, const WindowMessageHandlerCallback &cb) noexcept;
+    void UnsubscribeMessage(const std::uint32_t id) noexcept;
+
     [[nodiscard]] bool WindowMessageFilter(const MSG *message) const noexcept;
     void WindowMessageFilter(const WindowMessageFilterCallback &cb) noexcept;
 
@@ -447,6 +421,7 @@ private:
 private:
     [[nodiscard]] bool Initialize() noexcept;
     [[nodiscard]] static LRESULT CALLBACK WindowProc(const HWND hWnd, const UINT message, const WPARAM wParam, const LPARAM lParam) noexcept;
+    void SubscribeInternalMessages2() noexcept;
     [[nodiscard]] bool InternalMessageHandler(const UINT message, const WPARAM wParam, const LPARAM lParam, LRESULT *result) noexcept;
     [[nodiscard]] POINT GetWindowPosition2() const noexcept;
     [[nodiscard]] SIZE GetWindowSize2() const noexcept;
@@ -456,6 +431,10 @@ private:
     [[nodiscard]] bool SetWindowState2(const WindowState state) noexcept;
     [[nodiscard]] UINT GetWindowDPI2() const noexcept;
     [[nodiscard]] UINT GetWindowVisibleFrameBorderThickness2() const noexcept;
+    void RefreshWindowMetrics2(WindowMetricsEntry &entry, const UINT dpi) noexcept;
+    void InvalidateWindowMetrics2() noexcept;
+    [[nodiscard]] bool UpdateHitTestMap2() noexcept;
+    [[nodiscard]] bool ApplyThemeChange2() noexcept;
     [[nodiscard]] bool UpdateWindowFrameMargins2() noexcept;
     void TitleChangeHandler() const noexcept;
     void XChangeHandler() const noexcept;
@@ -471,6 +450,8 @@ private:
     void DotsPerInchChangeHandler() const noexcept;
     void ColorizationColorChangeHandler() const noexcept;
     void ColorizationAreaChangeHandler() const noexcept;
+    void GeometryChangeHandler() noexcept;
+    void ScheduleGeometryChange2() noexcept;
 
 private:
     Window *q_ptr = nullptr;
@@ -486,35 +467,59 @@ private:
     WindowStartupLocation m_startupLocation = WindowStartupLocation::Default;
     Color m_titleBarBackgroundColor = Color();
     WindowTheme m_theme = WindowTheme::Light;
-    Color m_colorizationColor = Color();
-    WindowColorizationArea m_colorizationArea = WindowColorizationArea::None;
-    UINT m_dpi = 0;
+    // Computed on first access and kept until the relevant change message arrives.
+    mutable Color m_colorizationColor = Color();
+    mutable bool m_colorizationColorValid = false;
+    mutable WindowColorizationArea m_colorizationArea = WindowColorizationArea::None;
+    mutable bool m_colorizationAreaValid = false;
+    mutable UINT m_dpi = 0; // Zero means it has not been queried yet.
     HBRUSH m_windowBackgroundBrush = nullptr;
     bool m_exposed = false;
-    UINT m_resizeBorderThicknessX = 0;
-    UINT m_resizeBorderThicknessY = 0;
-    UINT m_windowVisibleFrameBorderThickness = 0;
-    UINT m_captionHeight = 0;
-    UINT m_windowIconWidth = 0;
-    UINT m_windowIconHeight = 0;
-    UINT m_windowSmallIconWidth = 0;
-    UINT m_windowSmallIconHeight = 0;
+    // Keyed by DPI, so that moving between monitors doesn't recompute anything.
+    std::array<WindowMetricsEntry, WindowMetricsCacheSize> m_metrics = {};
+    std::size_t m_metricsNext = 0; // The entry to be replaced next.
+    HitTestMap m_hitTestMap = HitTestMap();
+    POINT m_hitTestMapOrigin = {0, 0}; // The client area origin, in screen coordinates.
+    bool m_hitTestMapValid = false;
+    FrameScheduler m_frameScheduler = FrameScheduler(FrameClock::Default());
+    bool m_sizeMoving = false;
+    PersonalizationSnapshot m_settings = {}; // The settings the window currently reflects.
     HBRUSH m_titleBarBackgroundBrush = nullptr;
-    StrChangeHandlerCallback m_titleChangeHandlerCallback = nullptr;
-    IntChangeHandlerCallback m_xChangeHandlerCallback = nullptr;
-    IntChangeHandlerCallback m_yChangeHandlerCallback = nullptr;
-    UIntChangeHandlerCallback m_widthChangeHandlerCallback = nullptr;
-    UIntChangeHandlerCallback m_heightChangeHandlerCallback = nullptr;
-    WindowStateChangeHandlerCallback m_visibilityChangeHandlerCallback = nullptr;
-    BoolChangeHandlerCallback m_activeChangeHandlerCallback = nullptr;
-    WindowFrameCornerChangeHandlerCallback m_frameCornerChangeHandlerCallback = nullptr;
-    WindowStartupLocationChangeHandlerCallback m_startupLocationChangeHandlerCallback = nullptr;
-    ColorChangeHandlerCallback m_titleBarBackgroundColorChangeHandlerCallback = nullptr;
-    WindowThemeChangeHandlerCallback m_themeChangeHandlerCallback = nullptr;
-    UIntChangeHandlerCallback m_dotsPerInchChangeHandlerCallback = nullptr;
-    ColorChangeHandlerCallback m_colorizationColorChangeHandlerCallback = nullptr;
-    WindowColorizationAreaChangeHandlerCallback m_colorizationAreaChangeHandlerCallback = nullptr;
+    StrChangeSignal m_titleChanged;
+    IntChangeSignal m_xChanged;
+    IntChangeSignal m_yChanged;
+    UIntChangeSignal m_widthChanged;
+    UIntChangeSignal m_heightChanged;
+    WindowStateChangeSignal m_visibilityChanged;
+    BoolChangeSignal m_activeChanged;
+    WindowFrameCornerChangeSignal m_frameCornerChanged;
+    WindowStartupLocationChangeSignal m_startupLocationChanged;
+    ColorChangeSignal m_titleBarBackgroundColorChanged;
+    WindowThemeChangeSignal m_themeChanged;
+    UIntChangeSignal m_dotsPerInchChanged;
+    ColorChangeSignal m_colorizationColorChanged;
+    WindowColorizationAreaChangeSignal m_colorizationAreaChanged;
+    WindowGeometryChangeSignal m_geometryChanged;
+    // The handlers of the "*ChangeHandler()" setters, subscribed to the signals above.
+    SignalConnection m_titleChangeHandlerConnection;
+    SignalConnection m_xChangeHandlerConnection;
+    SignalConnection m_yChangeHandlerConnection;
+    SignalConnection m_widthChangeHandlerConnection;
+    SignalConnection m_heightChangeHandlerConnection;
+    SignalConnection m_visibilityChangeHandlerConnection;
+    SignalConnection m_activeChangeHandlerConnection;
+    SignalConnection m_frameCornerChangeHandlerConnection;
+    SignalConnection m_startupLocationChangeHandlerConnection;
+    SignalConnection m_titleBarBackgroundColorChangeHandlerConnection;
+    SignalConnection m_themeChangeHandlerConnection;
+    SignalConnection m_dotsPerInchChangeHandlerConnection;
+    SignalConnection m_colorizationColorChangeHandlerConnection;
+    SignalConnection m_colorizationAreaChangeHandlerConnection;
+    SignalConnection m_geometryChangeHandlerConnection;
+    WindowGeometry m_deliveredGeometry = {}; // What the geometry handler has been told last.
+    GeometryChangeCoalescer m_geometryChangeCoalescer; // In "FrameClock::Default()" ticks.
     WindowMessageHandlerCallback m_customMessageHandlerCallback = nullptr;
+    MessageDispatcher m_messageDispatcher;
     WindowMessageFilterCallback m_windowMessageFilterCallback = nullptr;
     bool m_useAlternativeRendering = false;
     static inline bool m_osEnvDetected = false;
@@ -522,16 +527,14 @@ private:
     bool m_frameBorderVisible = false;
 };
 
-template<typename T>
-T *WindowPrivate::GetThisFromHandle(const HWND hWnd) noexcept
+// The windows of the calling thread, a window only ever receives messages on the
+// thread that created it. Looked up for every message, "GetWindowLongPtrW()" is
+// much slower than this.
+static thread_local HandleMap<HWND, WindowPrivate> t_windows;
+
+WindowPrivate *WindowPrivate::FromHandle(const HWND hWnd) noexcept
 {
-    if (!hWnd) {
-        return nullptr;
-    }
-    SetLastError(ERROR_SUCCESS);
-    const LONG_PTR result = GetWindowLongPtrW(hWnd, GWLP_USERDATA);
-    PRINT_WIN32_ERROR_MESSAGE(GetWindowLongPtrW, L"Failed to retrieve the user data of the window.")
-    return ((result == 0) ? nullptr : reinterpret_cast<T *>(result));
+    return t_windows.Find(hWnd);
 }
 
 POINT WindowPrivate::GetWindowPosition2() const noexcept
@@ -776,13 +779,101 @@ UINT WindowPrivate::GetWindowVisibleFrameBorderThickness2() const noexcept
         // We just eat this error because this enumeration value is only available
         // on Windows 11 and onwards, so querying it's value will always result in
         // a "parameter error" (error code: 87) on older systems.
-        const auto dpr = (static_cast<double>(m_dpi) / static_cast<double>(USER_DEFAULT_SCREEN_DPI));
+        const auto dpr = (static_cast<double>(DotsPerInch()) / static_cast<double>(USER_DEFAULT_SCREEN_DPI));
         return static_cast<UINT>(std::round(static_cast<double>(DefaultWindowVisibleFrameBorderThickness) * dpr));
     }
 }
 
+void WindowPrivate::RefreshWindowMetrics2(WindowMetricsEntry &entry, const UINT dpi) noexcept
+{
+    const auto GetSystemMetricsForDpi2 = [](const int nIndex, const UINT dpi) -> UINT {
+        if (dpi == 0) {
+            return 0;
+        }
+        return static_cast<UINT>(m_dpiFunctionsAvailable ? GetSystemMetricsForDpi(nIndex, dpi) : GetSystemMetrics(nIndex));
+    };
+    const auto Set = [&entry](const WindowMetrics metrics, const UINT value) -> void {
+        entry.Values[static_cast<std::size_t>(metrics)] = value;
+    };
+    Set(WindowMetrics::ResizeBorderThicknessX, (GetSystemMetricsForDpi2(SM_CXPADDEDBORDER, dpi) + GetSystemMetricsForDpi2(SM_CXSIZEFRAME, dpi)));
+    Set(WindowMetrics::ResizeBorderThicknessY, (GetSystemMetricsForDpi2(SM_CYPADDEDBORDER, dpi) + GetSystemMetricsForDpi2(SM_CYSIZEFRAME, dpi)));
+    Set(WindowMetrics::WindowVisibleFrameBorderThickness, GetWindowVisibleFrameBorderThickness2());
+    Set(WindowMetrics::CaptionHeight, GetSystemMetricsForDpi2(SM_CYCAPTION, dpi));
+    Set(WindowMetrics::WindowIconWidth, GetSystemMetricsForDpi2(SM_CXICON, dpi));
+    Set(WindowMetrics::WindowIconHeight, GetSystemMetricsForDpi2(SM_CYICON, dpi));
+    Set(WindowMetrics::WindowSmallIconWidth, GetSystemMetricsForDpi2(SM_CXSMICON, dpi));
+    Set(WindowMetrics::WindowSmallIconHeight, GetSystemMetricsForDpi2(SM_CYSMICON, dpi));
+    entry.Dpi = dpi;
+}
+
+void WindowPrivate::InvalidateWindowMetrics2() noexcept
+{
+    for (auto &&entry : m_metrics) {
+        entry.Dpi = 0;
+    }
+    m_hitTestMapValid = false;
+}
+
+bool WindowPrivate::UpdateHitTestMap2() noexcept
+{
+    POINT origin = {0, 0};
+    if (ClientToScreen(m_window, &origin) == FALSE) {
+        PRINT_WIN32_ERROR_MESSAGE(ClientToScreen, L"Failed to translate from window coordinate to screen coordinate.")
+        return false;
+    }
+    const auto resizeBorderThicknessY = static_cast<int>(GetWindowMetrics2(WindowMetrics::ResizeBorderThicknessY));
+    const auto captionHeight = static_cast<int>(GetWindowMetrics2(WindowMetrics::CaptionHeight));
+    HitTestGeometry geometry = {};
+    geometry.Width = static_cast<int>(m_width);
+    geometry.Height = static_cast<int>(m_height);
+    geometry.ResizeBorderThicknessX = static_cast<int>(GetWindowMetrics2(WindowMetrics::ResizeBorderThicknessX));
+    geometry.ResizeBorderThicknessY = resizeBorderThicknessY;
+    geometry.TitleBarHeight = ((m_visibility == WindowState::Maximized) ? captionHeight : (captionHeight + resizeBorderThicknessY));
+    geometry.HasTitleBar = ((m_visibility == WindowState::Windowed) || (m_visibility == WindowState::Maximized));
+    geometry.ResizableTop = (m_visibility == WindowState::Windowed);
+    // When the frame border is visible, DefWindowProc() still handles the
+    // left, right and bottom parts of the frame because we didn't change them.
+    geometry.ResizableEdges = (!m_frameBorderVisible && (m_visibility != WindowState::Maximized));
+    m_hitTestMap.Build(geometry);
+    m_hitTestMapOrigin = origin;
+    m_hitTestMapValid = true;
+    MessageTrace::RecordHitTestGeometry(m_window, origin, geometry);
+    return true;
+}
+
+bool WindowPrivate::ApplyThemeChange2() noexcept
+{
+    const PersonalizationSnapshot settings = PersonalizationSettings::Instance().Snapshot();
+    if (settings.Generation == m_settings.Generation) {
+        return true;
+    }
+    const PersonalizationSnapshot previous = m_settings;
+    m_settings = settings;
+    // Only tell about what actually changed, and only about the final state. The colorization
+    // values are derived from "m_settings" again the next time somebody asks for them.
+    if (settings.ColorizationColor != previous.ColorizationColor) {
+        m_colorizationColorValid = false;
+        ColorizationColorChangeHandler();
+    }
+    if (GetGlobalColorizationArea2(settings) != GetGlobalColorizationArea2(previous)) {
+        m_colorizationAreaValid = false;
+        ColorizationAreaChangeHandler();
+    }
+    const WindowTheme theme = GetGlobalApplicationTheme2(settings);
+    if (theme != m_theme) {
+        m_theme = theme;
+        ThemeChangeHandler();
+        if (!RefreshWindowTheme2()) {
+            Utils::DisplayErrorDialog(L"Failed to refresh the window theme.");
+            return false;
+        }
+    }
+    return true;
+}
+
 bool WindowPrivate::Initialize() noexcept
 {
+    PROFILE_SCOPE(L"WindowPrivate::Initialize")
     if (!m_window) {
         Utils::DisplayErrorDialog(L"Failed to initialize WindowPrivate due to this window has not been created.");
         return false;
@@ -794,9 +885,11 @@ bool WindowPrivate::Initialize() noexcept
     }
     static constexpr const VersionNumber win10 = VersionNumber(10, 0, 0);
     m_frameBorderVisible = (curOsVer >= win10);
-    m_dpi = GetWindowDPI2();
-    const std::wstring dpiDbgMsg = std::wstring(L"Current window's dots-per-inch (DPI): ") + std::to_wstring(m_dpi) + L'\n';
-    OutputDebugStringW(dpiDbgMsg.c_str());
+    // The DPI and the colorization values are only queried when somebody needs them,
+    // the theme has to be known right now because it decides the look of the frame.
+    m_dpi = 0;
+    m_colorizationColorValid = false;
+    m_colorizationAreaValid = false;
     if (!UpdateWindowFrameMargins2()) {
         Utils::DisplayErrorDialog(L"Failed to update the window frame margins.");
         return false;
@@ -805,13 +898,13 @@ bool WindowPrivate::Initialize() noexcept
         Utils::DisplayErrorDialog(L"Failed to trigger a window frame change event for the window.");
         return false;
     }
-    m_theme = GetGlobalApplicationTheme2();
+    m_settings = PersonalizationSettings::Instance().Snapshot();
+    m_theme = GetGlobalApplicationTheme2(m_settings);
     if (!RefreshWindowTheme2()) {
         Utils::DisplayErrorDialog(L"Failed to change the window theme.");
         return false;
     }
-    m_colorizationColor = Color(GetGlobalColorizationColor2());
-    m_colorizationArea = GetGlobalColorizationArea2();
+    ThemeChangeCoalescer::Register(m_window);
     m_visibility = WindowState::Hidden;
     m_active = false;
     const POINT windowPosition = GetWindowPosition2();
@@ -829,7 +922,7 @@ bool WindowPrivate::Initialize() noexcept
 WindowPrivate::WindowPrivate(Window *q, const DWORD flags) noexcept
 {
     if (!q) {
-        Utils::DisplayErrorDialog(L"WindowPrivate's q pointer is null.");
+        Utils::DisplayErrorDialog(L"WindowPrivate's q pointer is null.", ErrorSeverity::Fatal);
         std::exit(-1);
     }
     q_ptr = q;
@@ -839,19 +932,21 @@ WindowPrivate::WindowPrivate(Window *q, const DWORD flags) noexcept
         m_windowBackgroundBrush = static_cast<HBRUSH>(GetStockObject(BLACK_BRUSH));
         if (!m_windowBackgroundBrush) {
             PRINT_WIN32_ERROR_MESSAGE(GetStockObject, L"Failed to retrieve the black brush.")
+            Utils::DisplayErrorDialog(L"Failed to retrieve the black brush.", ErrorSeverity::Fatal);
             std::exit(-1);
         }
         // Create the title bar background brush early, we'll need it in WM_PAINT.
         TitleBarBackgroundColor(Color::FromRgba(0, 0, 0));
     }
+    SubscribeInternalMessages2();
     m_window = CreateWindow2(WS_OVERLAPPEDWINDOW, flags, nullptr, this, sizeof(WindowPrivate *), m_windowBackgroundBrush, WindowProc);
     if (m_window) {
         if (!Initialize()) {
-            Utils::DisplayErrorDialog(L"Failed to initialize WindowPrivate.");
+            Utils::DisplayErrorDialog(L"Failed to initialize WindowPrivate.", ErrorSeverity::Fatal);
             std::exit(-1);
         }
     } else {
-        Utils::DisplayErrorDialog(L"Failed to create this window.");
+        Utils::DisplayErrorDialog(L"Failed to create this window.", ErrorSeverity::Fatal);
         std::exit(-1);
     }
 }
@@ -881,13 +976,7 @@ int WindowPrivate::MessageLoop() noexcept
 {
     MSG msg = {};
     while (GetMessageW(&msg, nullptr, 0, 0) != FALSE) {
-#if 0
-        const auto that = GetThisFromHandle<WindowPrivate>(msg.hwnd);
-        const bool filtered = (that && that->WindowMessageFilter(&msg));
-#else
-        static constexpr const bool filtered = false;
-#endif
-        if (!filtered) {
+        if (!FilterMessage(&msg)) {
             TranslateMessage(&msg);
             DispatchMessageW(&msg);
         }
@@ -895,6 +984,26 @@ int WindowPrivate::MessageLoop() noexcept
     return static_cast<int>(msg.wParam);
 }
 
+int WindowPrivate::MessageLoop(EventLoop &loop) noexcept
+{
+    loop.MessageFilter(&WindowPrivate::FilterMessage);
+    return loop.Run();
+}
+
+bool WindowPrivate::FilterMessage(const MSG *msg) noexcept
+{
+    if (!msg) {
+        return false;
+    }
+    const WindowPrivate *that = FromHandle(msg->hwnd);
+    // Input for child windows (the XAML Island for example) goes through the
+    // filter of their top level window.
+    if (!that && msg->hwnd && (((msg->message >= WM_KEYFIRST) && (msg->message <= WM_KEYLAST)) || ((msg->message >= WM_MOUSEFIRST) && (msg->message <= WM_MOUSELAST)))) {
+        that = FromHandle(GetAncestor(msg->hwnd, GA_ROOT));
+    }
+    return (that && that->WindowMessageFilter(msg));
+}
+
 std::wstring WindowPrivate::Title() const noexcept
 {
     return m_title;
@@ -1086,16 +1195,29 @@ WindowTheme WindowPrivate::Theme() const noexcept
 
 UINT WindowPrivate::DotsPerInch() const noexcept
 {
+    // Nothing to ask for while the window is still being created.
+    if ((m_dpi == 0) && m_window) {
+        m_dpi = GetWindowDPI2();
+        LOG_DEBUG(L"Current window's dots-per-inch (DPI): {}", m_dpi);
+    }
     return m_dpi;
 }
 
 const Color &WindowPrivate::ColorizationColor() const noexcept
 {
+    if (!m_colorizationColorValid) {
+        m_colorizationColor = Color(static_cast<COLORREF>(m_settings.ColorizationColor)); // The color format is 0xAARRGGBB.
+        m_colorizationColorValid = true;
+    }
     return m_colorizationColor;
 }
 
 WindowColorizationArea WindowPrivate::ColorizationArea() const noexcept
 {
+    if (!m_colorizationAreaValid) {
+        m_colorizationArea = GetGlobalColorizationArea2(m_settings);
+        m_colorizationAreaValid = true;
+    }
     return m_colorizationArea;
 }
 
@@ -1108,6 +1230,7 @@ void WindowPrivate::FrameBorderVisible(const bool value) noexcept
 {
     if (m_frameBorderVisible != value) {
         m_frameBorderVisible = value;
+        m_hitTestMapValid = false;
         if (!TriggerWindowFrameChange2()) {
             Utils::DisplayErrorDialog(L"Failed to trigger a frame change event for the window.");
         }
@@ -1123,7 +1246,8 @@ HWND WindowPrivate::CreateChildWindow(const DWORD style, const DWORD extendedSty
         Utils::DisplayErrorDialog(L"Can't create the child window due to the parent window has not been created yet.");
         return nullptr;
     }
-    return CreateWindow2((style | WS_CHILD), extendedStyle, m_window, extraData, extraDataSize, m_windowBackgroundBrush, wndProc);
+    // WM_PARENTNOTIFY tells us when the child window is destroyed, it drops its window class then.
+    return CreateWindow2((style | WS_CHILD), (extendedStyle & ~WS_EX_NOPARENTNOTIFY), m_window, extraData, extraDataSize, m_windowBackgroundBrush, wndProc);
 }
 
 HWND WindowPrivate::WindowHandle() const noexcept
@@ -1161,142 +1285,225 @@ UINT WindowPrivate::GetWindowMetrics2(const WindowMetrics metrics) noexcept
         Utils::DisplayErrorDialog(L"Failed to retrieve the window metrics due to the window has not been created yet.");
         return 0;
     }
-    const auto GetSystemMetricsForDpi2 = [](const int nIndex, const UINT dpi) -> int {
-        if (dpi == 0) {
-            return 0;
-        }
-        return (m_dpiFunctionsAvailable ? GetSystemMetricsForDpi(nIndex, dpi) : GetSystemMetrics(nIndex));
-    };
-    switch (metrics) {
-    case WindowMetrics::ResizeBorderThicknessX: {
-        if (m_resizeBorderThicknessX == 0) {
-            const int paddedBorderThicknessX = GetSystemMetricsForDpi2(SM_CXPADDEDBORDER, m_dpi);
-            const int sizeFrameThicknessX = GetSystemMetricsForDpi2(SM_CXSIZEFRAME, m_dpi);
-            m_resizeBorderThicknessX = (paddedBorderThicknessX + sizeFrameThicknessX);
-        }
-        return m_resizeBorderThicknessX;
-    } break;
-    case WindowMetrics::ResizeBorderThicknessY: {
-        if (m_resizeBorderThicknessY == 0) {
-            const int paddedBorderThicknessY = GetSystemMetricsForDpi2(SM_CYPADDEDBORDER, m_dpi);
-            const int sizeFrameThicknessY = GetSystemMetricsForDpi2(SM_CYSIZEFRAME, m_dpi);
-            m_resizeBorderThicknessY = (paddedBorderThicknessY + sizeFrameThicknessY);
-        }
-        return m_resizeBorderThicknessY;
-    } break;
-    case WindowMetrics::WindowVisibleFrameBorderThickness: {
-        if (m_windowVisibleFrameBorderThickness == 0) {
-            m_windowVisibleFrameBorderThickness = GetWindowVisibleFrameBorderThickness2();
-        }
-        return m_windowVisibleFrameBorderThickness;
-    } break;
-    case WindowMetrics::CaptionHeight: {
-        if (m_captionHeight == 0) {
-            m_captionHeight = GetSystemMetricsForDpi2(SM_CYCAPTION, m_dpi);
-        }
-        return m_captionHeight;
-    } break;
-    case WindowMetrics::WindowIconWidth: {
-        if (m_windowIconWidth == 0) {
-            m_windowIconWidth = GetSystemMetricsForDpi2(SM_CXICON, m_dpi);
-        }
-        return m_windowIconWidth;
-    } break;
-    case WindowMetrics::WindowIconHeight: {
-        if (m_windowIconHeight == 0) {
-            m_windowIconHeight = GetSystemMetricsForDpi2(SM_CYICON, m_dpi);
-        }
-        return m_windowIconHeight;
-    } break;
-    case WindowMetrics::WindowSmallIconWidth: {
-        if (m_windowSmallIconWidth == 0) {
-            m_windowSmallIconWidth = GetSystemMetricsForDpi2(SM_CXSMICON, m_dpi);
-        }
-        return m_windowSmallIconWidth;
-    } break;
-    case WindowMetrics::WindowSmallIconHeight: {
-        if (m_windowSmallIconHeight == 0) {
-            m_windowSmallIconHeight = GetSystemMetricsForDpi2(SM_CYSMICON, m_dpi);
+    const auto index = static_cast<std::size_t>(metrics);
+    if (index >= WindowMetricsCount) {
+        return 0;
+    }
+    const UINT dpi = DotsPerInch();
+    for (auto &&entry : std::as_const(m_metrics)) {
+        if (entry.Dpi == dpi) {
+            return entry.Values[index];
         }
-        return m_windowSmallIconHeight;
-    } break;
     }
-    return 0;
+    // Round robin: the DPIs come and go in no particular order anyway.
+    WindowMetricsEntry &entry = m_metrics[m_metricsNext];
+    m_metricsNext = ((m_metricsNext + 1) % m_metrics.size());
+    RefreshWindowMetrics2(entry, dpi);
+    return entry.Values[index];
 }
 
 void WindowPrivate::TitleChangeHandler(const StrChangeHandlerCallback &cb) noexcept
 {
-    m_titleChangeHandlerCallback = cb;
+    m_titleChangeHandlerConnection.Disconnect();
+    if (cb) {
+        m_titleChangeHandlerConnection = m_titleChanged.Connect(cb);
+    }
 }
 
 void WindowPrivate::XChangeHandler(const IntChangeHandlerCallback &cb) noexcept
 {
-    m_xChangeHandlerCallback = cb;
+    m_xChangeHandlerConnection.Disconnect();
+    if (cb) {
+        m_xChangeHandlerConnection = m_xChanged.Connect(cb);
+    }
 }
 
 void WindowPrivate::YChangeHandler(const IntChangeHandlerCallback &cb) noexcept
 {
-    m_yChangeHandlerCallback = cb;
+    m_yChangeHandlerConnection.Disconnect();
+    if (cb) {
+        m_yChangeHandlerConnection = m_yChanged.Connect(cb);
+    }
 }
 
 void WindowPrivate::WidthChangeHandler(const UIntChangeHandlerCallback &cb) noexcept
 {
-    m_widthChangeHandlerCallback = cb;
+    m_widthChangeHandlerConnection.Disconnect();
+    if (cb) {
+        m_widthChangeHandlerConnection = m_widthChanged.Connect(cb);
+    }
 }
 
 void WindowPrivate::HeightChangeHandler(const UIntChangeHandlerCallback &cb) noexcept
 {
-    m_heightChangeHandlerCallback = cb;
+    m_heightChangeHandlerConnection.Disconnect();
+    if (cb) {
+        m_heightChangeHandlerConnection = m_heightChanged.Connect(cb);
+    }
 }
 
 void WindowPrivate::VisibilityChangeHandler(const WindowStateChangeHandlerCallback &cb) noexcept
 {
-    m_visibilityChangeHandlerCallback = cb;
+    m_visibilityChangeHandlerConnection.Disconnect();
+    if (cb) {
+        m_visibilityChangeHandlerConnection = m_visibilityChanged.Connect(cb);
+    }
 }
 
 void WindowPrivate::ActiveChangeHandler(const BoolChangeHandlerCallback &cb) noexcept
 {
-    m_activeChangeHandlerCallback = cb;
+    m_activeChangeHandlerConnection.Disconnect();
+    if (cb) {
+        m_activeChangeHandlerConnection = m_activeChanged.Connect(cb);
+    }
 }
 
 void WindowPrivate::FrameCornerChangeHandler(const WindowFrameCornerChangeHandlerCallback &cb) noexcept
 {
-    m_frameCornerChangeHandlerCallback = cb;
+    m_frameCornerChangeHandlerConnection.Disconnect();
+    if (cb) {
+        m_frameCornerChangeHandlerConnection = m_frameCornerChanged.Connect(cb);
+    }
 }
 
 void WindowPrivate::StartupLocationChangeHandler(const WindowStartupLocationChangeHandlerCallback &cb) noexcept
 {
-    m_startupLocationChangeHandlerCallback = cb;
+    m_startupLocationChangeHandlerConnection.Disconnect();
+    if (cb) {
+        m_startupLocationChangeHandlerConnection = m_startupLocationChanged.Connect(cb);
+    }
 }
 
 void WindowPrivate::TitleBarBackgroundColorChangeHandler(const ColorChangeHandlerCallback &cb) noexcept
 {
-    m_titleBarBackgroundColorChangeHandlerCallback = cb;
+    m_titleBarBackgroundColorChangeHandlerConnection.Disconnect();
+    if (cb) {
+        m_titleBarBackgroundColorChangeHandlerConnection = m_titleBarBackgroundColorChanged.Connect(cb);
+    }
 }
 
 void WindowPrivate::ThemeChangeHandler(const WindowThemeChangeHandlerCallback &cb) noexcept
 {
-    m_themeChangeHandlerCallback = cb;
+    m_themeChangeHandlerConnection.Disconnect();
+    if (cb) {
+        m_themeChangeHandlerConnection = m_themeChanged.Connect(cb);
+    }
 }
 
 void WindowPrivate::DotsPerInchChangeHandler(const UIntChangeHandlerCallback &cb) noexcept
 {
-    m_dotsPerInchChangeHandlerCallback = cb;
+    m_dotsPerInchChangeHandlerConnection.Disconnect();
+    if (cb) {
+        m_dotsPerInchChangeHandlerConnection = m_dotsPerInchChanged.Connect(cb);
+    }
 }
 
 void WindowPrivate::ColorizationColorChangeHandler(const ColorChangeHandlerCallback &cb) noexcept
 {
-    m_colorizationColorChangeHandlerCallback = cb;
+    m_colorizationColorChangeHandlerConnection.Disconnect();
+    if (cb) {
+        m_colorizationColorChangeHandlerConnection = m_colorizationColorChanged.Connect(cb);
+    }
 }
 
 void WindowPrivate::ColorizationAreaChangeHandler(const WindowColorizationAreaChangeHandlerCallback &cb) noexcept
 {
-    m_colorizationAreaChangeHandlerCallback = cb;
+    m_colorizationAreaChangeHandlerConnection.Disconnect();
+    if (cb) {
+        m_colorizationAreaChangeHandlerConnection = m_colorizationAreaChanged.Connect(cb);
+    }
+}
+
+void WindowPrivate::GeometryChangeHandler(const WindowGeometryChangeHandlerCallback &cb) noexcept
+{
+    m_geometryChangeHandlerConnection.Disconnect();
+    if (cb) {
+        m_geometryChangeHandlerConnection = m_geometryChanged.Connect(cb);
+    }
+}
+
+StrChangeSignal &WindowPrivate::TitleChanged() noexcept
+{
+    return m_titleChanged;
+}
+
+IntChangeSignal &WindowPrivate::XChanged() noexcept
+{
+    return m_xChanged;
+}
+
+IntChangeSignal &WindowPrivate::YChanged() noexcept
+{
+    return m_yChanged;
+}
+
+UIntChangeSignal &WindowPrivate::WidthChanged() noexcept
+{
+    return m_widthChanged;
+}
+
+UIntChangeSignal &WindowPrivate::HeightChanged() noexcept
+{
+    return m_heightChanged;
+}
+
+WindowStateChangeSignal &WindowPrivate::VisibilityChanged() noexcept
+{
+    return m_visibilityChanged;
+}
+
+BoolChangeSignal &WindowPrivate::ActiveChanged() noexcept
+{
+    return m_activeChanged;
+}
+
+WindowFrameCornerChangeSignal &WindowPrivate::FrameCornerChanged() noexcept
+{
+    return m_frameCornerChanged;
+}
+
+WindowStartupLocationChangeSignal &WindowPrivate::StartupLocationChanged() noexcept
+{
+    return m_startupLocationChanged;
+}
+
+ColorChangeSignal &WindowPrivate::TitleBarBackgroundColorChanged() noexcept
+{
+    return m_titleBarBackgroundColorChanged;
+}
+
+WindowThemeChangeSignal &WindowPrivate::ThemeChanged() noexcept
+{
+    return m_themeChanged;
+}
+
+UIntChangeSignal &WindowPrivate::DotsPerInchChanged() noexcept
+{
+    return m_dotsPerInchChanged;
+}
+
+ColorChangeSignal &WindowPrivate::ColorizationColorChanged() noexcept
+{
+    return m_colorizationColorChanged;
+}
+
+WindowColorizationAreaChangeSignal &WindowPrivate::ColorizationAreaChanged() noexcept
+{
+    return m_colorizationAreaChanged;
+}
+
+WindowGeometryChangeSignal &WindowPrivate::GeometryChanged() noexcept
+{
+    return m_geometryChanged;
 }
 
 bool WindowPrivate::CustomMessageHandler(const UINT message, const WPARAM wParam, const LPARAM lParam, LRESULT *result) const noexcept
 {
-    return (m_customMessageHandlerCallback ? m_customMessageHandlerCallback(message, wParam, lParam, result) : false);
+    if (!m_customMessageHandlerCallback) {
+        return false;
+    }
+    MESSAGE_INSTRUMENTATION_SCOPE(CustomHandler, message)
+    return m_customMessageHandlerCallback(message, wParam, lParam, result);
 }
 
 void WindowPrivate::CustomMessageHandler(const WindowMessageHandlerCallback &cb) noexcept
@@ -1309,6 +1516,16 @@ bool WindowPrivate::WindowMessageFilter(const MSG *message) const noexcept
     return (m_windowMessageFilterCallback ? m_windowMessageFilterCallback(message) : false);
 }
 
+std::uint32_t WindowPrivate::SubscribeMessage(const UINT message, const WindowMessageHandlerCallback &cb) noexcept
+{
+    return m_messageDispatcher.Subscribe(message, cb);
+}
+
+void WindowPrivate::UnsubscribeMessage(const std::uint32_t id) noexcept
+{
+    m_messageDispatcher.Unsubscribe(id);
+}
+
 void WindowPrivate::WindowMessageFilter(const WindowMessageFilterCallback &cb) noexcept
 {
     m_windowMessageFilterCallback = cb;
@@ -1316,6 +1533,8 @@ void WindowPrivate::WindowMessageFilter(const WindowMessageFilterCallback &cb) n
 
 LRESULT CALLBACK WindowPrivate::WindowProc(const HWND hWnd, const UINT message, const WPARAM wParam, const LPARAM lParam) noexcept
 {
+    MESSAGE_INSTRUMENTATION_SCOPE(WindowProc, message)
+    MessageTrace::RecordMessage(hWnd, message, wParam, lParam);
     if (message == WM_NCCREATE) {
         const auto cs = reinterpret_cast<LPCREATESTRUCT>(lParam);
         const auto that = static_cast<WindowPrivate *>(cs->lpCreateParams);
@@ -1328,6 +1547,9 @@ LRESULT CALLBACK WindowPrivate::WindowProc(const HWND hWnd, const UINT message,
         if (result != 0) {
             Utils::DisplayErrorDialog(L"The extra data of this window has been overwritten.");
         }
+        if (!t_windows.Insert(hWnd, that)) {
+            Utils::DisplayErrorDialog(L"Failed to add the window to the window table of the current thread.");
+        }
     } else if (message == WM_NCDESTROY) {
         // See the above comments.
         SetLastError(ERROR_SUCCESS);
@@ -1336,19 +1558,82 @@ LRESULT CALLBACK WindowPrivate::WindowProc(const HWND hWnd, const UINT message,
         if (result == 0) {
             Utils::DisplayErrorDialog(L"This window doesn't contain any extra data.");
         }
-    }
-    if (const auto that = GetThisFromHandle<WindowPrivate>(hWnd)) {
+        t_windows.Erase(hWnd);
+        WindowClassRegistry::Detach(hWnd);
+    } else if (message == WM_DESTROY) {
+        // The child windows are destroyed after us and they run the window procedures
+        // of our users, drop their references to the window classes now.
+        EnumChildWindows(hWnd, DetachWindowClass, 0);
+    } else if ((message == WM_PARENTNOTIFY) && (LOWORD(wParam) == WM_DESTROY)) {
+        // A child window destroyed on its own.
+        WindowClassRegistry::Detach(reinterpret_cast<HWND>(lParam));
+    }
+    if (const auto that = FromHandle(hWnd)) {
         LRESULT result = 0;
         if (that->CustomMessageHandler(message, wParam, lParam, &result)) {
             return result;
         }
-        if (that->InternalMessageHandler(message, wParam, lParam, &result)) {
+        if (that->m_messageDispatcher.Dispatch(message, wParam, lParam, &result)) {
             return result;
         }
     }
     return DefWindowProcW(hWnd, message, wParam, lParam);
 }
 
+void WindowPrivate::SubscribeInternalMessages2() noexcept
+{
+    // Every message handled by "InternalMessageHandler()", keep it in sync with the switch there.
+    static constexpr const UINT internalMessages[] = {
+        WM_MOVE, WM_SIZE, WM_SETTINGCHANGE, WM_DPICHANGED, WM_ENTERSIZEMOVE, WM_EXITSIZEMOVE,
+        WM_WINDOWPOSCHANGED, WM_TIMER, WM_DISPLAYCHANGE, WM_DWMCOMPOSITIONCHANGED,
+        WM_DWMCOLORIZATIONCOLORCHANGED, WM_PAINT, WM_SETTEXT, WM_SETICON, WM_CLOSE, WM_DESTROY,
+        WM_NCCREATE, WM_NCCALCSIZE, WM_NCHITTEST, WM_NCRBUTTONUP, WM_ACTIVATE, WM_WINDOWPOSCHANGING,
+        WM_NCUAHDRAWCAPTION, WM_NCUAHDRAWFRAME, WM_NCPAINT, WM_NCACTIVATE, WM_ERASEBKGND
+    };
+    const auto internalHandler = [this](const UINT message, const WPARAM wParam, const LPARAM lParam, LRESULT *result) -> bool {
+        return InternalMessageHandler(message, wParam, lParam, result);
+    };
+    for (auto &&message : internalMessages) {
+        [[maybe_unused]] const auto internalId = m_messageDispatcher.Subscribe(message, internalHandler);
+    }
+    // The latest subscriber runs first, so these see their messages before the switch.
+    const auto taskBarHandler = [this](const UINT message, const WPARAM wParam, const LPARAM lParam, LRESULT *result) -> bool {
+        UNREFERENCED_PARAMETER(result);
+        if (!m_window || !TaskBarCache::IsChangeNotification(message, wParam, lParam)) {
+            return false;
+        }
+        TaskBarCache::Invalidate();
+        // A maximized window has to make room for the auto-hide task bar.
+        if (m_visibility == WindowState::Maximized) {
+            if (!TriggerWindowFrameChange2()) {
+                Utils::DisplayErrorDialog(L"Failed to trigger a window frame change event for the window.");
+            }
+        }
+        return false; // Not consumed, the window may have to handle it as well.
+    };
+    [[maybe_unused]] const auto settingChangeId = m_messageDispatcher.Subscribe(WM_SETTINGCHANGE, taskBarHandler);
+    [[maybe_unused]] const auto displayChangeId = m_messageDispatcher.Subscribe(WM_DISPLAYCHANGE, taskBarHandler);
+    if (const UINT taskBarCreated = TaskBarCache::TaskBarCreatedMessage(); taskBarCreated != 0) {
+        [[maybe_unused]] const auto taskBarCreatedId = m_messageDispatcher.Subscribe(taskBarCreated, taskBarHandler);
+    }
+    if (const UINT themeChanged = ThemeChangeCoalescer::NotificationMessage(); themeChanged != 0) {
+        [[maybe_unused]] const auto themeChangedId = m_messageDispatcher.Subscribe(themeChanged, [this](const UINT message, const WPARAM wParam, const LPARAM lParam, LRESULT *result) -> bool {
+            UNREFERENCED_PARAMETER(message);
+            UNREFERENCED_PARAMETER(wParam);
+            UNREFERENCED_PARAMETER(lParam);
+            if (!m_window) {
+                return false;
+            }
+            if (!ApplyThemeChange2()) {
+                Utils::DisplayErrorDialog(L"Failed to apply the theme change.");
+                return false;
+            }
+            *result = 0;
+            return true;
+        });
+    }
+}
+
 bool WindowPrivate::InternalMessageHandler(const UINT message, const WPARAM wParam, const LPARAM lParam, LRESULT *result) noexcept
 {
     if (!result) {
@@ -1363,6 +1648,7 @@ bool WindowPrivate::InternalMessageHandler(const UINT message, const WPARAM wPar
     case WM_MOVE: {
         m_x = GET_X_LPARAM(lParam);
         m_y = GET_Y_LPARAM(lParam);
+        m_hitTestMapValid = false;
         XChangeHandler();
         YChangeHandler();
     } break;
@@ -1382,6 +1668,7 @@ bool WindowPrivate::InternalMessageHandler(const UINT message, const WPARAM wPar
         }
         m_width = LOWORD(lParam);
         m_height = HIWORD(lParam);
+        m_hitTestMapValid = false;
         if (visibilityChanged) {
             VisibilityChangeHandler();
         }
@@ -1401,18 +1688,15 @@ bool WindowPrivate::InternalMessageHandler(const UINT message, const WPARAM wPar
         }
     } break;
     case WM_SETTINGCHANGE: {
+        // Non-client metrics (caption height, border width, ...) may have changed.
+        InvalidateWindowMetrics2();
         // wParam == 0: User-wide setting change
         // wParam == 1: System-wide setting change
-        // ### TODO: how to detect high contrast theme here
-        if ((wParam == 0) && (lParam != 0) && (std::wcscmp(reinterpret_cast<LPCWSTR>(lParam), L"ImmersiveColorSet") == 0)) {
-            m_colorizationArea = GetGlobalColorizationArea2();
-            m_theme = GetGlobalApplicationTheme2();
-            ColorizationAreaChangeHandler();
-            ThemeChangeHandler();
-            if (!RefreshWindowTheme2()) {
-                Utils::DisplayErrorDialog(L"Failed to refresh the window theme.");
-                return false;
-            }
+        const bool colorSetChanged = ((wParam == 0) && (lParam != 0) && (std::wcscmp(reinterpret_cast<LPCWSTR>(lParam), L"ImmersiveColorSet") == 0));
+        const bool highContrastChanged = (wParam == SPI_SETHIGHCONTRAST);
+        if (colorSetChanged || highContrastChanged) {
+            // These come in bursts, wait for the burst to be over.
+            ThemeChangeCoalescer::Schedule();
         }
     } break;
     case WM_DPICHANGED: {
@@ -1420,9 +1704,18 @@ bool WindowPrivate::InternalMessageHandler(const UINT message, const WPARAM wPar
         const UINT dpiX = LOWORD(wParam);
         const UINT dpiY = HIWORD(wParam);
         m_dpi = static_cast<UINT>(std::round(static_cast<double>(dpiX + dpiY) / 2.0));
+        // The metrics are kept per DPI, only the hit-test map has to go.
+        m_hitTestMapValid = false;
+        // We may be on another monitor now, with a different refresh rate.
+        m_frameScheduler.Invalidate();
         DotsPerInchChangeHandler();
-        const std::wstring dpiDbgMsg = std::wstring(L"Current window's dots-per-inch (DPI) has changed from ") + std::to_wstring(oldDPI) + std::wstring(L" to ") + std::to_wstring(m_dpi) + std::wstring(L".\n");
-        OutputDebugStringW(dpiDbgMsg.c_str());
+        // The old DPI is unknown if nobody asked for it: the window reports the new
+        // one already, querying it now would only tell the same thing twice.
+        if (oldDPI == 0) {
+            LOG_DEBUG(L"Current window's dots-per-inch (DPI) has changed to {}.", m_dpi);
+        } else {
+            LOG_DEBUG(L"Current window's dots-per-inch (DPI) has changed from {} to {}.", oldDPI, m_dpi);
+        }
         const auto prcNewWindow = reinterpret_cast<LPRECT>(lParam);
         if (SetGeometry(prcNewWindow->left, prcNewWindow->top, RECT_WIDTH(*prcNewWindow), RECT_HEIGHT(*prcNewWindow))) {
             *result = 0;
@@ -1432,7 +1725,45 @@ bool WindowPrivate::InternalMessageHandler(const UINT message, const WPARAM wPar
             return false;
         }
     } break;
+    case WM_ENTERSIZEMOVE: {
+        // Resizing waits for the vertical blank a lot, keep the system timer
+        // resolution raised for the whole resize instead of for every wait.
+        if (!m_sizeMoving) {
+            m_sizeMoving = TimingService::BeginHighResolution();
+        }
+    } break;
+    case WM_EXITSIZEMOVE: {
+        if (m_sizeMoving) {
+            m_sizeMoving = false;
+            if (!TimingService::EndHighResolution()) {
+                Utils::DisplayErrorDialog(L"Failed to restore the system timer resolution.");
+            }
+        }
+    } break;
+    case WM_WINDOWPOSCHANGED: {
+        // DefWindowProc() sends WM_MOVE and WM_SIZE from here, let it update
+        // the geometry first and then tell about all of it at once.
+        *result = DefWindowProcW(m_window, message, wParam, lParam);
+        ScheduleGeometryChange2();
+        return true;
+    } break;
+    case WM_TIMER: {
+        if (wParam == WindowGeometryChangeTimerId) {
+            if (KillTimer(m_window, WindowGeometryChangeTimerId) == FALSE) {
+                PRINT_WIN32_ERROR_MESSAGE(KillTimer, L"Failed to kill the geometry change timer.")
+            }
+            GeometryChangeHandler();
+            *result = 0;
+            return true;
+        }
+    } break;
+    case WM_DISPLAYCHANGE: {
+        m_frameScheduler.Invalidate();
+    } break;
     case WM_DWMCOMPOSITIONCHANGED: {
+        // Forget the remembered status, it's queried again below.
+        g_dwmCompositionState.store(-1, std::memory_order_relaxed);
+        m_frameScheduler.Invalidate();
         // We can't modify the window frame when DWM composition is disabled.
         if (IsDWMCompositionEnabled()) {
             if (!UpdateWindowFrameMargins2()) {
@@ -1441,8 +1772,7 @@ bool WindowPrivate::InternalMessageHandler(const UINT message, const WPARAM wPar
         }
     } break;
     case WM_DWMCOLORIZATIONCOLORCHANGED: {
-        m_colorizationColor = Color(static_cast<COLORREF>(wParam)); // The color format is 0xAARRGGBB.
-        ColorizationColorChangeHandler();
+        ThemeChangeCoalescer::Schedule();
     } break;
     case WM_PAINT: {
         if (m_useAlternativeRendering || !m_frameBorderVisible) {
@@ -1459,7 +1789,7 @@ bool WindowPrivate::InternalMessageHandler(const UINT message, const WPARAM wPar
             PRINT_WIN32_ERROR_MESSAGE(BeginPaint, L"Failed to start painting.")
             return false;
         }
-        const LONG topBorderHeight = ((m_visibility == WindowState::Maximized) ? 0 : GetWindowVisibleFrameBorderThickness2());
+        const LONG topBorderHeight = ((m_visibility == WindowState::Maximized) ? 0 : static_cast<LONG>(GetWindowMetrics2(WindowMetrics::WindowVisibleFrameBorderThickness)));
         if (ps.rcPaint.top < topBorderHeight) {
             RECT rcTopBorder = ps.rcPaint;
             rcTopBorder.bottom = topBorderHeight;
@@ -1544,6 +1874,13 @@ bool WindowPrivate::InternalMessageHandler(const UINT message, const WPARAM wPar
         }
     } break;
     case WM_DESTROY: {
+        ThemeChangeCoalescer::Unregister(m_window);
+        if (m_sizeMoving) {
+            m_sizeMoving = false;
+            if (!TimingService::EndHighResolution()) {
+                Utils::DisplayErrorDialog(L"Failed to restore the system timer resolution.");
+            }
+        }
         PostQuitMessage(0);
         *result = 0;
         return true;
@@ -1587,179 +1924,47 @@ bool WindowPrivate::InternalMessageHandler(const UINT message, const WPARAM wPar
             clientRect->top = originalTop;
         }
         const bool max = (m_visibility == WindowState::Maximized);
-        const bool full = false; // ### TODO
-        // We don't need this correction when we're fullscreen. We will
-        // have the WS_POPUP size, so we don't have to worry about
-        // borders, and the default frame will be fine.
-        if (max && !full) {
-            // When a window is maximized, its size is actually a little bit more
-            // than the monitor's work area. The window is positioned and sized in
-            // such a way that the resize handles are outside of the monitor and
-            // then the window is clipped to the monitor so that the resize handle
-            // do not appear because you don't need them (because you can't resize
-            // a window when it's maximized unless you restore it).
-            const UINT resizeBorderThicknessY = GetWindowMetrics2(WindowMetrics::ResizeBorderThicknessY);
-            clientRect->top += resizeBorderThicknessY;
-            if (!m_frameBorderVisible) {
-                clientRect->bottom -= resizeBorderThicknessY;
-                const UINT resizeBorderThicknessX = GetWindowMetrics2(WindowMetrics::ResizeBorderThicknessX);
-                clientRect->left += resizeBorderThicknessX;
-                clientRect->right -= resizeBorderThicknessX;
-            }
-        }
-        // Attempt to detect if there's an autohide taskbar, and if
-        // there is, reduce our size a bit on the side with the taskbar,
-        // so the user can still mouse-over the taskbar to reveal it.
-        // Make sure to use MONITOR_DEFAULTTONEAREST, so that this will
-        // still find the right monitor even when we're restoring from
-        // minimized.
-        if (max || full) {
-            APPBARDATA abd;
-            SecureZeroMemory(&abd, sizeof(abd));
-            abd.cbSize = sizeof(abd);
-            // First, check if we have an auto-hide taskbar at all:
-            if (SHAppBarMessage(ABM_GETSTATE, &abd) & ABS_AUTOHIDE) {
-                bool top = false, bottom = false, left = false, right = false;
-                // "ABM_GETAUTOHIDEBAREX" was introduced on Windows 8.1
-                if (WindowsVersion::CurrentVersion() >= WindowsVersion::Windows_8_1) {
-                    const HMONITOR mon = MonitorFromWindow(m_window, MONITOR_DEFAULTTONEAREST);
-                    if (mon) {
-                        MONITORINFO mi;
-                        SecureZeroMemory(&mi, sizeof(mi));
-                        mi.cbSize = sizeof(mi);
-                        if (GetMonitorInfoW(mon, &mi) == FALSE) {
-                            PRINT_WIN32_ERROR_MESSAGE(GetMonitorInfoW, L"Failed to retrieve the screen information.")
-                            return false;
-                        }
-                        const RECT screenRect = mi.rcMonitor;
-                        // This helper can be used to determine if there's a
-                        // auto-hide taskbar on the given edge of the monitor
-                        // we're currently on.
-                        const auto hasAutohideTaskbar = [&screenRect](const UINT edge) -> bool {
-                            APPBARDATA abd2;
-                            SecureZeroMemory(&abd2, sizeof(abd2));
-                            abd2.cbSize = sizeof(abd2);
-                            abd2.uEdge = edge;
-                            abd2.rc = screenRect;
-                            return (reinterpret_cast<HWND>(SHAppBarMessage(ABM_GETAUTOHIDEBAREX, &abd2)) != nullptr);
-                        };
-                        top = hasAutohideTaskbar(ABE_TOP);
-                        bottom = hasAutohideTaskbar(ABE_BOTTOM);
-                        left = hasAutohideTaskbar(ABE_LEFT);
-                        right = hasAutohideTaskbar(ABE_RIGHT);
-                    } else {
-                        PRINT_WIN32_ERROR_MESSAGE(MonitorFromWindow, L"Failed to retrieve the corresponding screen.")
-                        return false;
-                    }
-                } else {
-                    int edge = -1;
-                    APPBARDATA _abd;
-                    SecureZeroMemory(&_abd, sizeof(_abd));
-                    _abd.cbSize = sizeof(_abd);
-                    _abd.hWnd = FindWindowW(L"Shell_TrayWnd", nullptr);
-                    if (_abd.hWnd) {
-                        const HMONITOR windowScreen = MonitorFromWindow(m_window, MONITOR_DEFAULTTONEAREST);
-                        if (!windowScreen) {
-                            PRINT_WIN32_ERROR_MESSAGE(MonitorFromWindow, L"Failed to retrieve the window screen.")
-                            return false;
-                        }
-                        const HMONITOR taskBarScreen = MonitorFromWindow(_abd.hWnd, MONITOR_DEFAULTTOPRIMARY);
-                        if (!taskBarScreen) {
-                            PRINT_WIN32_ERROR_MESSAGE(MonitorFromWindow, L"Failed to retrieve the task bar screen.")
-                            return false;
-                        }
-                        if (taskBarScreen == windowScreen) {
-                            SHAppBarMessage(ABM_GETTASKBARPOS, &_abd);
-                            edge = _abd.uEdge;
-                        }
-                    } else {
-                        PRINT_WIN32_ERROR_MESSAGE(FindWindowW, L"Failed to retrieve the window handle of the task bar.")
-                        return false;
-                    }
-                    top = (edge == ABE_TOP);
-                    bottom = (edge == ABE_BOTTOM);
-                    left = (edge == ABE_LEFT);
-                    right = (edge == ABE_RIGHT);
-                }
-                // If there's a taskbar on any side of the monitor, reduce
-                // our size a little bit on that edge.
-                // Note to future code archeologists:
-                // This doesn't seem to work for fullscreen on the primary
-                // display. However, testing a bunch of other apps with
-                // fullscreen modes and an auto-hiding taskbar has
-                // shown that _none_ of them reveal the taskbar from
-                // fullscreen mode. This includes Edge, Firefox, Chrome,
-                // Sublime Text, PowerPoint - none seemed to support this.
-                // This does however work fine for maximized.
-                if (top) {
-                    // Peculiarly, when we're fullscreen,
-                    clientRect->top += DefaultAutoHideTaskBarThicknessY;
-                } else if (bottom) {
-                    clientRect->bottom -= DefaultAutoHideTaskBarThicknessY;
-                } else if (left) {
-                    clientRect->left += DefaultAutoHideTaskBarThicknessX;
-                } else if (right) {
-                    clientRect->right -= DefaultAutoHideTaskBarThicknessX;
-                }
+        // ### TODO: fullscreen. We won't need the maximized corrections then, we
+        // will have the WS_POPUP size, so we don't have to worry about borders,
+        // and the default frame will be fine.
+        ClientAreaFrame frame = {};
+        frame.Maximized = max;
+        frame.FrameBorderVisible = m_frameBorderVisible;
+        if (max) {
+            frame.ResizeBorderThicknessX = static_cast<int>(GetWindowMetrics2(WindowMetrics::ResizeBorderThicknessX));
+            frame.ResizeBorderThicknessY = static_cast<int>(GetWindowMetrics2(WindowMetrics::ResizeBorderThicknessY));
+            // Make sure to use MONITOR_DEFAULTTONEAREST, so that this will still
+            // find the right monitor even when we're restoring from minimized.
+            // The task bar state is cached per monitor, asking the shell on
+            // every frame calculation is way too slow.
+            const HMONITOR mon = MonitorFromWindow(m_window, MONITOR_DEFAULTTONEAREST);
+            if (!mon) {
+                PRINT_WIN32_ERROR_MESSAGE(MonitorFromWindow, L"Failed to retrieve the corresponding screen.")
+                return false;
             }
-        }
-        // Dirty hack to workaround the DWM flicker.
-        LARGE_INTEGER freq = {};
-        if (QueryPerformanceFrequency(&freq) == FALSE) {
-            PRINT_WIN32_ERROR_MESSAGE(QueryPerformanceFrequency, L"Failed to retrieve the CPU frequency.")
-            return false;
-        }
-        TIMECAPS tc = {};
-        if (timeGetDevCaps(&tc, sizeof(tc)) != MMSYSERR_NOERROR) {
-            Utils::DisplayErrorDialog(L"timeGetDevCaps() failed.");
-            return false;
-        }
-        const UINT ms_granularity = tc.wPeriodMin;
-        if (timeBeginPeriod(ms_granularity) != TIMERR_NOERROR) {
-            Utils::DisplayErrorDialog(L"timeBeginPeriod() failed.");
-            return false;
-        }
-        LARGE_INTEGER now0 = {};
-        if (QueryPerformanceCounter(&now0) == FALSE) {
-            PRINT_WIN32_ERROR_MESSAGE(QueryPerformanceCounter, L"Failed to retrieve the performance counter.")
-            return false;
-        }
-        // ask DWM where the vertical blank falls
-        DWM_TIMING_INFO dti;
-        SecureZeroMemory(&dti, sizeof(dti));
-        dti.cbSize = sizeof(dti);
-        const HRESULT hr = DwmGetCompositionTimingInfo(nullptr, &dti);
-        if (FAILED(hr)) {
-            PRINT_HR_ERROR_MESSAGE(DwmGetCompositionTimingInfo, hr, L"Failed to retrieve the composition timing info.")
-            return false;
-        }
-        LARGE_INTEGER now1 = {};
-        if (QueryPerformanceCounter(&now1) == FALSE) {
-            PRINT_WIN32_ERROR_MESSAGE(QueryPerformanceCounter, L"Failed to retrieve the performance counter.")
-            return false;
-        }
-        // - DWM told us about SOME vertical blank
-        //   - past or future, possibly many frames away
-        // - convert that into the NEXT vertical blank
-        const LONGLONG period = dti.qpcRefreshPeriod;
-        const LONGLONG dt = dti.qpcVBlank - now1.QuadPart;
-        LONGLONG w = 0, m = 0;
-        if (dt >= 0) {
-            w = dt / period;
-        } else {
-            // reach back to previous period
-            // - so m represents consistent position within phase
-            w = -1 + dt / period;
-        }
-        m = dt - (period * w);
-        assert(m >= 0);
-        assert(m < period);
-        const double m_ms = 1000.0 * static_cast<double>(m) / static_cast<double>(freq.QuadPart);
-        Sleep(static_cast<DWORD>(std::round(m_ms)));
-        if (timeEndPeriod(ms_granularity) != TIMERR_NOERROR) {
-            Utils::DisplayErrorDialog(L"timeEndPeriod() failed.");
-            return false;
-        }
+            // Note to future code archeologists:
+            // This doesn't seem to work for fullscreen on the primary
+            // display. However, testing a bunch of other apps with
+            // fullscreen modes and an auto-hiding taskbar has
+            // shown that _none_ of them reveal the taskbar from
+            // fullscreen mode. This includes Edge, Firefox, Chrome,
+            // Sublime Text, PowerPoint - none seemed to support this.
+            // This does however work fine for maximized.
+            frame.AutoHideTaskBarEdge = TaskBarCache::AutoHideEdge(mon);
+            frame.AutoHideTaskBarThicknessX = static_cast<int>(DefaultAutoHideTaskBarThicknessX);
+            frame.AutoHideTaskBarThicknessY = static_cast<int>(DefaultAutoHideTaskBarThicknessY);
+        }
+        const ClientAreaInsets insets = CalculateClientAreaInsets(frame);
+        clientRect->left += insets.Left;
+        clientRect->top += insets.Top;
+        clientRect->right -= insets.Right;
+        clientRect->bottom -= insets.Bottom;
+        // Workaround the DWM flicker: commit the new size right at the
+        // vertical blank. The scheduler tracks the vertical blank phase and
+        // waits on a high resolution waitable timer, so neither the compositor
+        // nor the system timer resolution is touched on every resize.
+        // Nothing to align with if DWM can't tell us, just don't wait then.
+        [[maybe_unused]] const bool aligned = m_frameScheduler.WaitForVBlank();
         // We cannot return WVR_REDRAW otherwise Windows exhibits bugs
         // where client pixels and child windows are mispositioned by
         // the width/height of the upper-left nonclient area.
@@ -1767,17 +1972,13 @@ bool WindowPrivate::InternalMessageHandler(const UINT message, const WPARAM wPar
         return true;
     } break;
     case WM_NCHITTEST: {
-        const POINT globalPos = {GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam)};
-        POINT localPos = globalPos;
-        if (ScreenToClient(m_window, &localPos) == FALSE) {
-            PRINT_WIN32_ERROR_MESSAGE(ScreenToClient, L"Failed to translate from screen coordinate to window coordinate.")
-            return false;
+        // The geometry only changes on size, position, DPI and state changes,
+        // don't redo the math for every single mouse move.
+        if (!m_hitTestMapValid) {
+            if (!UpdateHitTestMap2()) {
+                return false;
+            }
         }
-        const auto resizeBorderThicknessY = static_cast<LONG>(GetWindowMetrics2(WindowMetrics::ResizeBorderThicknessY));
-        const UINT captionHeight = GetWindowMetrics2(WindowMetrics::CaptionHeight);
-        const LONG titleBarHeight = ((m_visibility == WindowState::Hidden) ? 0 : ((m_visibility == WindowState::Maximized) ? captionHeight : (captionHeight + resizeBorderThicknessY)));
-        const bool isTitleBar = (((m_visibility == WindowState::Windowed) || (m_visibility == WindowState::Maximized)) ? (localPos.y <= titleBarHeight) : false);
-        const bool isTop = ((m_visibility == WindowState::Windowed) ? (localPos.y <= resizeBorderThicknessY) : false);
         if (m_frameBorderVisible) {
             // This will handle the left, right and bottom parts of the frame
             // because we didn't change them.
@@ -1791,67 +1992,42 @@ bool WindowPrivate::InternalMessageHandler(const UINT message, const WPARAM wPar
             // title bar or the drag bar. Apparently, it must be the drag bar or
             // the little border at the top which the user can use to move or
             // resize the window.
-            if (isTop) {
-                *result = HTTOP;
-                return true;
-            }
-            if (isTitleBar) {
-                *result = HTCAPTION;
-                return true;
-            }
+        }
+        const int x = (GET_X_LPARAM(lParam) - m_hitTestMapOrigin.x);
+        const int y = (GET_Y_LPARAM(lParam) - m_hitTestMapOrigin.y);
+        switch (m_hitTestMap.Find(x, y)) {
+        case HitTestResult::Client:
             *result = HTCLIENT;
-            return true;
-        } else {
-            if (m_visibility == WindowState::Maximized) {
-                *result = (isTitleBar ? HTCAPTION : HTCLIENT);
-                return true;
-            } else {
-                const bool isBottom = (localPos.y >= (static_cast<LONG>(m_height) - resizeBorderThicknessY));
-                // Make the border a little wider to let the user easy to resize on corners.
-                const double factor = ((isTop || isBottom) ? 2.0 : 1.0);
-                const UINT resizeBorderThicknessX = GetWindowMetrics2(WindowMetrics::ResizeBorderThicknessX);
-                const bool isLeft = (localPos.x <= static_cast<LONG>(std::round(static_cast<double>(resizeBorderThicknessX) * factor)));
-                const bool isRight = (localPos.x >= (static_cast<LONG>(m_width) - static_cast<LONG>(std::round(static_cast<double>(resizeBorderThicknessX) * factor))));
-                if (isTop) {
-                    if (isLeft) {
-                        *result = HTTOPLEFT;
-                        return true;
-                    }
-                    if (isRight) {
-                        *result = HTTOPRIGHT;
-                        return true;
-                    }
-                    *result = HTTOP;
-                    return true;
-                }
-                if (isBottom) {
-                    if (isLeft) {
-                        *result = HTBOTTOMLEFT;
-                        return true;
-                    }
-                    if (isRight) {
-                        *result = HTBOTTOMRIGHT;
-                        return true;
-                    }
-                    *result = HTBOTTOM;
-                    return true;
-                }
-                if (isLeft) {
-                    *result = HTLEFT;
-                    return true;
-                }
-                if (isRight) {
-                    *result = HTRIGHT;
-                    return true;
-                }
-                if (isTitleBar) {
-                    *result = HTCAPTION;
-                    return true;
-                }
-                *result = HTCLIENT;
-                return true;
-            }
+            break;
+        case HitTestResult::Caption:
+            *result = HTCAPTION;
+            break;
+        case HitTestResult::Left:
+            *result = HTLEFT;
+            break;
+        case HitTestResult::Right:
+            *result = HTRIGHT;
+            break;
+        case HitTestResult::Top:
+            *result = HTTOP;
+            break;
+        case HitTestResult::TopLeft:
+            *result = HTTOPLEFT;
+            break;
+        case HitTestResult::TopRight:
+            *result = HTTOPRIGHT;
+            break;
+        case HitTestResult::Bottom:
+            *result = HTBOTTOM;
+            break;
+        case HitTestResult::BottomLeft:
+            *result = HTBOTTOMLEFT;
+            break;
+        case HitTestResult::BottomRight:
+            *result = HTBOTTOMRIGHT;
+            break;
         }
+        return true;
     } break;
     case WM_NCRBUTTONUP: {
         if (wParam == HTCAPTION) {
@@ -1968,99 +2144,106 @@ bool WindowPrivate::UpdateWindowFrameMargins2() noexcept
 
 void WindowPrivate::TitleChangeHandler() const noexcept
 {
-    if (m_titleChangeHandlerCallback) {
-        m_titleChangeHandlerCallback(m_title);
-    }
+    m_titleChanged.Emit(m_title);
 }
 
 void WindowPrivate::XChangeHandler() const noexcept
 {
-    if (m_xChangeHandlerCallback) {
-        m_xChangeHandlerCallback(m_x);
-    }
+    m_xChanged.Emit(m_x);
 }
 
 void WindowPrivate::YChangeHandler() const noexcept
 {
-    if (m_yChangeHandlerCallback) {
-        m_yChangeHandlerCallback(m_y);
-    }
+    m_yChanged.Emit(m_y);
 }
 
 void WindowPrivate::WidthChangeHandler() const noexcept
 {
-    if (m_widthChangeHandlerCallback) {
-        m_widthChangeHandlerCallback(m_width);
-    }
+    m_widthChanged.Emit(m_width);
 }
 
 void WindowPrivate::HeightChangeHandler() const noexcept
 {
-    if (m_heightChangeHandlerCallback) {
-        m_heightChangeHandlerCallback(m_height);
-    }
+    m_heightChanged.Emit(m_height);
 }
 
 void WindowPrivate::VisibilityChangeHandler() const noexcept
 {
-    if (m_visibilityChangeHandlerCallback) {
-        m_visibilityChangeHandlerCallback(m_visibility);
-    }
+    m_visibilityChanged.Emit(m_visibility);
 }
 
 void WindowPrivate::ActiveChangeHandler() const noexcept
 {
-    if (m_activeChangeHandlerCallback) {
-        m_activeChangeHandlerCallback(m_active);
-    }
+    m_activeChanged.Emit(m_active);
 }
 
 void WindowPrivate::FrameCornerChangeHandler() const noexcept
 {
-    if (m_frameCornerChangeHandlerCallback) {
-        m_frameCornerChangeHandlerCallback(m_frameCorner);
-    }
+    m_frameCornerChanged.Emit(m_frameCorner);
 }
 
 void WindowPrivate::StartupLocationChangeHandler() const noexcept
 {
-    if (m_startupLocationChangeHandlerCallback) {
-        m_startupLocationChangeHandlerCallback(m_startupLocation);
-    }
+    m_startupLocationChanged.Emit(m_startupLocation);
 }
 
 void WindowPrivate::TitleBarBackgroundColorChangeHandler() const noexcept
 {
-    if (m_titleBarBackgroundColorChangeHandlerCallback) {
-        m_titleBarBackgroundColorChangeHandlerCallback(m_titleBarBackgroundColor);
-    }
+    m_titleBarBackgroundColorChanged.Emit(m_titleBarBackgroundColor);
 }
 
 void WindowPrivate::ThemeChangeHandler() const noexcept
 {
-    if (m_themeChangeHandlerCallback) {
-        m_themeChangeHandlerCallback(m_theme);
-    }
+    m_themeChanged.Emit(m_theme);
 }
 
 void WindowPrivate::DotsPerInchChangeHandler() const noexcept
 {
-    if (m_dotsPerInchChangeHandlerCallback) {
-        m_dotsPerInchChangeHandlerCallback(m_dpi);
-    }
+    m_dotsPerInchChanged.Emit(DotsPerInch());
 }
 
 void WindowPrivate::ColorizationColorChangeHandler() const noexcept
 {
-    if (m_colorizationColorChangeHandlerCallback) {
-        m_colorizationColorChangeHandlerCallback(m_colorizationColor);
-    }
+    m_colorizationColorChanged.Emit(ColorizationColor());
 }
 
 void WindowPrivate::ColorizationAreaChangeHandler() const noexcept
 {
-    if (m_colorizationAreaChangeHandlerCallback) {
-        m_colorizationAreaChangeHandlerCallback(m_colorizationArea);
+    m_colorizationAreaChanged.Emit(ColorizationArea());
+}
+
+void WindowPrivate::GeometryChangeHandler() noexcept
+{
+    m_geometryChangeCoalescer.Delivered(FrameClock::Default().Now());
+    const WindowGeometry geometry = {m_x, m_y, m_width, m_height};
+    if (geometry == m_deliveredGeometry) {
+        return;
+    }
+    m_deliveredGeometry = geometry;
+    m_geometryChanged.Emit(geometry);
+}
+
+void WindowPrivate::ScheduleGeometryChange2() noexcept
+{
+    FrameClock &clock = FrameClock::Default();
+    const std::int64_t frequency = clock.Frequency();
+    const std::int64_t period = m_frameScheduler.Period();
+    const std::int64_t frameInterval = ((frequency <= 0) ? 0 : ((period > 0) ? period : (frequency / 60)));
+    const std::int64_t delay = m_geometryChangeCoalescer.Schedule(clock.Now(), frameInterval);
+    if (delay < 0) {
+        // The timer is running already, it will deliver the latest state.
+        return;
+    }
+    if (delay == 0) {
+        GeometryChangeHandler();
+        return;
+    }
+    // Already delivered during this frame, deliver the final state once the frame is over.
+    const auto remaining = static_cast<UINT>((delay * 1000 + frequency - 1) / frequency);
+    if (SetTimer(m_window, WindowGeometryChangeTimerId, std::max(remaining, static_cast<UINT>(USER_TIMER_MINIMUM)), nullptr) == 0) {
+        PRINT_WIN32_ERROR_MESSAGE(SetTimer, L"Failed to start the geometry change timer.")
+        m_geometryChangeCoalescer.Cancel();
+        GeometryChangeHandler();
     }
 }
 
@@ -2081,6 +2264,11 @@ int Window::MessageLoop() noexcept
     return WindowPrivate::MessageLoop();
 }
 
+int Window::MessageLoop(EventLoop &loop) noexcept
+{
+    return WindowPrivate::MessageLoop(loop);
+}
+
 void Window::Title(const std::wstring &value) noexcept
 {
     d_ptr->Title(value);
@@ -2231,6 +2419,81 @@ bool Window::SetGeometry(const int x, const int y, const UINT w, const UINT h) c
     return d_ptr->SetGeometry(x, y, w, h);
 }
 
+StrChangeSignal &Window::TitleChanged() noexcept
+{
+    return d_ptr->TitleChanged();
+}
+
+IntChangeSignal &Window::XChanged() noexcept
+{
+    return d_ptr->XChanged();
+}
+
+IntChangeSignal &Window::YChanged() noexcept
+{
+    return d_ptr->YChanged();
+}
+
+UIntChangeSignal &Window::WidthChanged() noexcept
+{
+    return d_ptr->WidthChanged();
+}
+
+UIntChangeSignal &Window::HeightChanged() noexcept
+{
+    return d_ptr->HeightChanged();
+}
+
+WindowStateChangeSignal &Window::VisibilityChanged() noexcept
+{
+    return d_ptr->VisibilityChanged();
+}
+
+BoolChangeSignal &Window::ActiveChanged() noexcept
+{
+    return d_ptr->ActiveChanged();
+}
+
+WindowFrameCornerChangeSignal &Window::FrameCornerChanged() noexcept
+{
+    return d_ptr->FrameCornerChanged();
+}
+
+WindowStartupLocationChangeSignal &Window::StartupLocationChanged() noexcept
+{
+    return d_ptr->StartupLocationChanged();
+}
+
+ColorChangeSignal &Window::TitleBarBackgroundColorChanged() noexcept
+{
+    return d_ptr->TitleBarBackgroundColorChanged();
+}
+
+WindowThemeChangeSignal &Window::ThemeChanged() noexcept
+{
+    return d_ptr->ThemeChanged();
+}
+
+UIntChangeSignal &Window::DotsPerInchChanged() noexcept
+{
+    return d_ptr->DotsPerInchChanged();
+}
+
+ColorChangeSignal &Window::ColorizationColorChanged() noexcept
+{
+    return d_ptr->ColorizationColorChanged();
+}
+
+WindowColorizationAreaChangeSignal &Window::ColorizationAreaChanged() noexcept
+{
+    return d_ptr->ColorizationAreaChanged();
+}
+
+WindowGeometryChangeSignal &Window::GeometryChanged() noexcept
+{
+    return d_ptr->GeometryChanged();
+}
+
 void Window::TitleChangeHandler(const StrChangeHandlerCallback &cb) noexcept
 {
     d_ptr->TitleChangeHandler(cb);
@@ -2301,11 +2564,26 @@ void Window::ColorizationAreaChangeHandler(const WindowColorizationAreaChangeHan
     d_ptr->ColorizationAreaChangeHandler(cb);
 }
 
+void Window::GeometryChangeHandler(const WindowGeometryChangeHandlerCallback &cb) noexcept
+{
+    d_ptr->GeometryChangeHandler(cb);
+}
+
 void Window::CustomMessageHandler(const WindowMessageHandlerCallback &cb) noexcept
 {
     d_ptr->CustomMessageHandler(cb);
 }
 
+std::uint32_t Window::SubscribeMessage(const UINT message, const WindowMessageHandlerCallback &cb) noexcept
+{
+    return d_ptr->SubscribeMessage(message, cb);
+}
+
+void Window::UnsubscribeMessage(const std::uint32_t id) noexcept
+{
+    d_ptr->UnsubscribeMessage(id);
+}
+
 void Window::WindowMessageFilter(const WindowMessageFilterCallback &cb) noexcept
 {
     d_ptr->WindowMessageFilter(cb);
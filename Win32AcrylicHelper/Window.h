@@ -29,8 +29,10 @@
 #include <string>
 #include <memory>
 #include <functional>
+#include <cstdint>
 #include "Definitions.h"
 #include "Color.hpp"
+#include "Signal.hpp"
 
 #define WINDOW_ENABLE_DOUBLE_BUFFERING WS_EX_COMPOSITED
 #define WINDOW_USE_ACCELERATED_SURFACE WS_EX_LAYERED
@@ -38,6 +40,12 @@
 #define WINDOW_USE_ALTERNATIVE_RENDERING WS_EX_NOREDIRECTIONBITMAP
 #define WINDOW_USE_TRANSLUCENT_BACKGROUND WS_EX_TRANSPARENT
 
+// The timer the window sets on its own handle to deliver the last geometry change
+// of a frame, see "GeometryChangeHandler()". Subclasses must not start timers with
+// this identifier on the window, and must leave its WM_TIMER messages to the window.
+// A high constant, far away from the small numbers timers are usually given.
+[[maybe_unused]] constexpr const UINT_PTR WindowGeometryChangeTimerId = 0x57414847;
+
 using BoolChangeHandlerCallback = std::function<void (const bool)>;
 using StrChangeHandlerCallback = std::function<void (const std::wstring &)>;
 using IntChangeHandlerCallback = std::function<void (const int)>;
@@ -48,10 +56,23 @@ using WindowStartupLocationChangeHandlerCallback = std::function<void (const Win
 using ColorChangeHandlerCallback = std::function<void (const Color &)>;
 using WindowThemeChangeHandlerCallback = std::function<void (const WindowTheme)>;
 using WindowColorizationAreaChangeHandlerCallback = std::function<void (const WindowColorizationArea)>;
+using WindowGeometryChangeHandlerCallback = std::function<void (const WindowGeometry &)>;
+using BoolChangeSignal = Signal<const bool>;
+using StrChangeSignal = Signal<const std::wstring &>;
+using IntChangeSignal = Signal<const int>;
+using UIntChangeSignal = Signal<const UINT>;
+using WindowStateChangeSignal = Signal<const WindowState>;
+using WindowFrameCornerChangeSignal = Signal<const WindowFrameCorner>;
+using WindowStartupLocationChangeSignal = Signal<const WindowStartupLocation>;
+using ColorChangeSignal = Signal<const Color &>;
+using WindowThemeChangeSignal = Signal<const WindowTheme>;
+using WindowColorizationAreaChangeSignal = Signal<const WindowColorizationArea>;
+using WindowGeometryChangeSignal = Signal<const WindowGeometry &>;
 using WindowMessageHandlerCallback = std::function<bool (const UINT, const WPARAM, const LPARAM, LRESULT *)>;
 using WindowMessageFilterCallback = std::function<bool (const MSG *)>;
 
 class WindowPrivate;
+class EventLoop;
 
 class Window
 {
@@ -60,6 +81,8 @@ public:
     ~Window() noexcept;
 
     [[nodiscard]] static int MessageLoop() noexcept;
+    // Runs the given loop instead, with the message filters of the windows installed.
+    [[nodiscard]] static int MessageLoop(EventLoop &loop) noexcept;
 
     [[nodiscard]] std::wstring Title() const noexcept;
     void Title(const std::wstring &value) noexcept;
@@ -102,12 +125,31 @@ public:
     [[nodiscard]] bool FrameBorderVisible() const noexcept;
     void FrameBorderVisible(const bool value) noexcept;
 
+    // "WS_EX_NOPARENTNOTIFY" is ignored, the window has to know when its children are destroyed.
     [[nodiscard]] HWND CreateChildWindow(const DWORD style, const DWORD extendedStyle, const WNDPROC wndProc, void *extraData, const UINT extraDataSize) const noexcept;
     [[nodiscard]] HWND WindowHandle() const noexcept;
     [[nodiscard]] bool Move(const int x, const int y) const noexcept;
     [[nodiscard]] bool Resize(const UINT w, const UINT h) const noexcept;
     [[nodiscard]] bool SetGeometry(const int x, const int y, const UINT w, const UINT h) const noexcept;
 
+    // Any number of subscribers can connect to these. The single handlers below are
+    // subscribers too, each replacing the one set before.
+    [[nodiscard]] StrChangeSignal &TitleChanged() noexcept;
+    [[nodiscard]] IntChangeSignal &XChanged() noexcept;
+    [[nodiscard]] IntChangeSignal &YChanged() noexcept;
+    [[nodiscard]] UIntChangeSignal &WidthChanged() noexcept;
+    [[nodiscard]] UIntChangeSignal &HeightChanged() noexcept;
+    [[nodiscard]] WindowStateChangeSignal &VisibilityChanged() noexcept;
+    [[nodiscard]] BoolChangeSignal &ActiveChanged() noexcept;
+    [[nodiscard]] WindowFrameCornerChangeSignal &FrameCornerChanged() noexcept;
+    [[nodiscard]] WindowStartupLocationChangeSignal &StartupLocationChanged() noexcept;
+    [[nodiscard]] ColorChangeSignal &TitleBarBackgroundColorChanged() noexcept;
+    [[nodiscard]] WindowThemeChangeSignal &ThemeChanged() noexcept;
+    [[nodiscard]] UIntChangeSignal &DotsPerInchChanged() noexcept;
+    [[nodiscard]] ColorChangeSignal &ColorizationColorChanged() noexcept;
+    [[nodiscard]] WindowColorizationAreaChangeSignal &ColorizationAreaChanged() noexcept;
+    [[nodiscard]] WindowGeometryChangeSignal &GeometryChanged() noexcept;
+
     [[nodiscard]] inline friend bool operator==(const Window &lhs, const Window &rhs) noexcept {
         return (lhs.WindowHandle() == rhs.WindowHandle());
     }
@@ -130,7 +172,13 @@ protected:
     void DotsPerInchChangeHandler(const UIntChangeHandlerCallback &cb) noexcept;
     void ColorizationColorChangeHandler(const ColorChangeHandlerCallback &cb) noexcept;
     void ColorizationAreaChangeHandler(const WindowColorizationAreaChangeHandlerCallback &cb) noexcept;
+    // Position and size changes together, delivered at most once per frame.
+    void GeometryChangeHandler(const WindowGeometryChangeHandlerCallback &cb) noexcept;
     void CustomMessageHandler(const WindowMessageHandlerCallback &cb) noexcept;
+    // Only called for the given message. Runs before the built-in handling, the
+    // latest subscriber first; returning true stops the message right there.
+    [[nodiscard]] std::uint32_t SubscribeMessage(const UINT message, const WindowMessageHandlerCallback &cb) noexcept;
+    void UnsubscribeMessage(const std::uint32_t id) noexcept;
     void WindowMessageFilter(const WindowMessageFilterCallback &cb) noexcept;
 
     [[nodiscard]] UINT GetWindowMetrics(const WindowMetrics metrics) const noexcept;
@@ -0,0 +1,170 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "WindowClassRegistry.h"
+#include "OperationResult.h"
+#include "Undocumented.h"
+#include "Utils.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct WindowClassEntry
+{
+    WindowClassKey Key = {};
+    ATOM Atom = INVALID_ATOM;
+    std::size_t References = 0;
+};
+
+struct WindowClassReference
+{
+    HWND Window = nullptr;
+    ATOM Atom = INVALID_ATOM;
+};
+
+static std::mutex g_windowClassMutex;
+// Only a handful of distinct classes ever exist, a linear search is all we need.
+static std::vector<WindowClassEntry> g_windowClasses = {};
+static std::size_t g_windowClassCount = 0;
+// The windows holding a reference. Keyed by the window rather than looked up from
+// its class, so that a window destroyed during its own creation, whose reference
+// is still held by its creator, isn't released twice.
+static std::vector<WindowClassReference> g_windowReferences = {};
+
+// Unregisters the classes nobody references any more. The caller holds the lock.
+static inline void TrimUnlocked() noexcept
+{
+    for (auto it = g_windowClasses.begin(); it != g_windowClasses.end();) {
+        if (it->References != 0) {
+            ++it;
+            continue;
+        }
+        if (UnregisterClassW(MAKEINTATOM(it->Atom), HINST_THISCOMPONENT) == FALSE) {
+            // The last window is still being destroyed, or some windows of this class
+            // were not created through us. Keep the class around, it can still be
+            // shared by the next window.
+            if (GetLastError() != ERROR_CLASS_HAS_WINDOWS) {
+                PRINT_WIN32_ERROR_MESSAGE(UnregisterClassW, L"Failed to unregister the window class.")
+            }
+            ++it;
+            continue;
+        }
+        it = g_windowClasses.erase(it);
+    }
+}
+
+// Drops a reference to the class. The caller holds the lock.
+static inline void ReleaseUnlocked(const ATOM atom) noexcept
+{
+    const auto it = std::find_if(g_windowClasses.begin(), g_windowClasses.end(), [atom](const WindowClassEntry &entry) -> bool {
+        return (entry.Atom == atom);
+    });
+    if ((it == g_windowClasses.end()) || (it->References == 0)) {
+        return;
+    }
+    if (--it->References == 0) {
+        TrimUnlocked();
+    }
+}
+
+ATOM WindowClassRegistry::Acquire(const WindowClassKey &key) noexcept
+{
+    if (!key.WindowProc) {
+        Utils::DisplayErrorDialog(L"Failed to register a window class due to the WindowProc function pointer is null.");
+        return INVALID_ATOM;
+    }
+    const std::scoped_lock lock(g_windowClassMutex);
+    for (auto &&entry : g_windowClasses) {
+        if (entry.Key == key) {
+            ++entry.References;
+            return entry.Atom;
+        }
+    }
+    PROFILE_SCOPE(L"RegisterClassExW")
+    // Class names only have to be unique within this module.
+    const std::wstring className = L"Win32AcrylicHelperWindowClass" + std::to_wstring(++g_windowClassCount);
+    WNDCLASSEXW wcex;
+    SecureZeroMemory(&wcex, sizeof(wcex));
+    wcex.cbSize = sizeof(wcex);
+    wcex.style = key.Style;
+    wcex.lpfnWndProc = key.WindowProc;
+    wcex.hInstance = HINST_THISCOMPONENT;
+    wcex.lpszClassName = className.c_str();
+    wcex.hbrBackground = key.Background;
+    wcex.hCursor = LoadCursorW(nullptr, IDC_ARROW);
+    wcex.hIcon = key.Icon;
+    wcex.hIconSm = key.SmallIcon;
+    wcex.cbWndExtra = key.WindowExtraBytes;
+    const ATOM atom = RegisterClassExW(&wcex);
+    if (atom == INVALID_ATOM) {
+        PRINT_WIN32_ERROR_MESSAGE(RegisterClassExW, L"Failed to register a window class.")
+        return INVALID_ATOM;
+    }
+    g_windowClasses.push_back({key, atom, 1});
+    return atom;
+}
+
+void WindowClassRegistry::Release(const ATOM atom) noexcept
+{
+    if (atom == INVALID_ATOM) {
+        return;
+    }
+    const std::scoped_lock lock(g_windowClassMutex);
+    ReleaseUnlocked(atom);
+}
+
+void WindowClassRegistry::Attach(const HWND hWnd, const ATOM atom) noexcept
+{
+    if (!hWnd || (atom == INVALID_ATOM)) {
+        return;
+    }
+    const std::scoped_lock lock(g_windowClassMutex);
+    g_windowReferences.push_back({hWnd, atom});
+}
+
+void WindowClassRegistry::Detach(const HWND hWnd) noexcept
+{
+    if (!hWnd) {
+        return;
+    }
+    const std::scoped_lock lock(g_windowClassMutex);
+    const auto it = std::find_if(g_windowReferences.begin(), g_windowReferences.end(), [hWnd](const WindowClassReference &reference) -> bool {
+        return (reference.Window == hWnd);
+    });
+    if (it == g_windowReferences.end()) {
+        return;
+    }
+    const ATOM atom = it->Atom;
+    *it = g_windowReferences.back();
+    g_windowReferences.pop_back();
+    ReleaseUnlocked(atom);
+}
+
+void WindowClassRegistry::Trim() noexcept
+{
+    const std::scoped_lock lock(g_windowClassMutex);
+    TrimUnlocked();
+}
@@ -0,0 +1,64 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <SDKDDKVer.h>
+#include <Windows.h>
+
+// Everything that makes two window classes interchangeable for us.
+struct WindowClassKey
+{
+    WNDPROC WindowProc = nullptr;
+    UINT Style = 0;
+    HBRUSH Background = nullptr;
+    HICON Icon = nullptr;
+    HICON SmallIcon = nullptr;
+    int WindowExtraBytes = 0;
+
+    [[nodiscard]] inline bool operator==(const WindowClassKey &) const noexcept = default;
+};
+
+// The window classes of this library, shared by all windows with the same
+// key and unregistered when the last of them is gone. Registering a new class
+// for every window would fill up the atom table and slow down window creation.
+namespace WindowClassRegistry
+{
+    // The atom of a class matching "key", registered on first use. Every
+    // successful call must be paired with a call to "Release()", or the
+    // reference must be handed over to the window created with it.
+    [[nodiscard]] ATOM Acquire(const WindowClassKey &key) noexcept;
+    // Drops a reference, the class is unregistered with the last one.
+    // Atoms which were not registered here are ignored.
+    void Release(const ATOM atom) noexcept;
+    // Hands the reference of a successful "Acquire()" over to the window.
+    void Attach(const HWND hWnd, const ATOM atom) noexcept;
+    // Drops the reference of the window, if it has one. Must be called when the
+    // window is destroyed, no matter by whom; calling it again does nothing.
+    void Detach(const HWND hWnd) noexcept;
+    // A class can't be unregistered while its windows still exist, which is the
+    // case when the last reference is dropped during their destruction. Such
+    // classes are unregistered here, or by the next "Release()"/"Detach()".
+    void Trim() noexcept;
+} // namespace WindowClassRegistry
@@ -0,0 +1,142 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+// The arithmetic of the window frame: how WM_NCCALCSIZE shrinks the proposed client
+// area, and when a geometry change is delivered. Deliberately free of any Windows
+// dependency, the message trace replay runs the very same code.
+
+#include <cstdint>
+
+enum class TaskBarEdge : int
+{
+    None = 0,
+    Top,
+    Bottom,
+    Left,
+    Right
+};
+
+// Everything the client area of WM_NCCALCSIZE depends on, besides the default frame
+// "DefWindowProc()" applies when the frame border is visible.
+struct ClientAreaFrame
+{
+    bool Maximized = false;
+    bool FrameBorderVisible = false; // The default frame has been applied already, except at the top.
+    int ResizeBorderThicknessX = 0; // Only needed when maximized.
+    int ResizeBorderThicknessY = 0;
+    TaskBarEdge AutoHideTaskBarEdge = TaskBarEdge::None; // Of the monitor, only needed when maximized.
+    int AutoHideTaskBarThicknessX = 0;
+    int AutoHideTaskBarThicknessY = 0;
+};
+
+// How much the proposed window rectangle shrinks on each side.
+struct ClientAreaInsets
+{
+    int Left = 0;
+    int Top = 0;
+    int Right = 0;
+    int Bottom = 0;
+};
+
+[[nodiscard]] inline constexpr ClientAreaInsets CalculateClientAreaInsets(const ClientAreaFrame &frame) noexcept
+{
+    ClientAreaInsets insets = {};
+    if (!frame.Maximized) {
+        return insets;
+    }
+    // When a window is maximized, its size is actually a little bit more
+    // than the monitor's work area. The window is positioned and sized in
+    // such a way that the resize handles are outside of the monitor and
+    // then the window is clipped to the monitor so that the resize handle
+    // do not appear because you don't need them (because you can't resize
+    // a window when it's maximized unless you restore it).
+    insets.Top = frame.ResizeBorderThicknessY;
+    if (!frame.FrameBorderVisible) {
+        insets.Bottom = frame.ResizeBorderThicknessY;
+        insets.Left = frame.ResizeBorderThicknessX;
+        insets.Right = frame.ResizeBorderThicknessX;
+    }
+    // If there's an auto-hide task bar on any side of the monitor, reduce our
+    // size a little bit on that side, so the user can still mouse-over the
+    // task bar to reveal it.
+    switch (frame.AutoHideTaskBarEdge) {
+    case TaskBarEdge::Top:
+        insets.Top += frame.AutoHideTaskBarThicknessY;
+        break;
+    case TaskBarEdge::Bottom:
+        insets.Bottom += frame.AutoHideTaskBarThicknessY;
+        break;
+    case TaskBarEdge::Left:
+        insets.Left += frame.AutoHideTaskBarThicknessX;
+        break;
+    case TaskBarEdge::Right:
+        insets.Right += frame.AutoHideTaskBarThicknessX;
+        break;
+    default:
+        break;
+    }
+    return insets;
+}
+
+// Geometry changes are delivered at most once per frame: the first change of a
+// frame right away, the last one once the frame is over. The times are in the
+// ticks of whatever clock the caller uses.
+class GeometryChangeCoalescer
+{
+public:
+    inline explicit GeometryChangeCoalescer() noexcept = default;
+    inline ~GeometryChangeCoalescer() noexcept = default;
+
+    // Returns how long to wait before delivering: zero to deliver right away,
+    // or a negative value when a delivery is waiting already and will pick up
+    // this change too. Delivery is considered pending after a positive result.
+    [[nodiscard]] inline std::int64_t Schedule(const std::int64_t now, const std::int64_t frameInterval) noexcept {
+        if (m_pending) {
+            return -1;
+        }
+        const std::int64_t elapsed = (now - m_lastDelivery);
+        if ((frameInterval <= 0) || (elapsed >= frameInterval)) {
+            return 0;
+        }
+        m_pending = true;
+        return (frameInterval - elapsed);
+    }
+    // The delayed delivery couldn't be arranged, deliver right away instead.
+    inline void Cancel() noexcept {
+        m_pending = false;
+    }
+    inline void Delivered(const std::int64_t now) noexcept {
+        m_pending = false;
+        m_lastDelivery = now;
+    }
+    [[nodiscard]] inline bool Pending() const noexcept {
+        return m_pending;
+    }
+
+private:
+    std::int64_t m_lastDelivery = 0;
+    bool m_pending = false;
+};